@@ -68,6 +68,8 @@ void Error_Handler(void);
 #define RS485_NUCLEO_RX_GPIO_Port GPIOA
 #define FULL_GAS_BUTTON_Pin GPIO_PIN_4
 #define FULL_GAS_BUTTON_GPIO_Port GPIOA
+#define PADDLE_Pin GPIO_PIN_5
+#define PADDLE_GPIO_Port GPIOA
 #define LED_STS_Pin GPIO_PIN_7
 #define LED_STS_GPIO_Port GPIOA
 #define HORN_BUTTON_Pin GPIO_PIN_0
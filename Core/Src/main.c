@@ -94,7 +94,7 @@ int main(void)
   MX_IWDG_Init();
   MX_CRC_Init();
   MX_TIM6_Init();
-  MX_TIM7_Init();
+  MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
   hydrogreen_main();
   /* USER CODE END 2 */
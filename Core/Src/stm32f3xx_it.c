@@ -23,6 +23,8 @@
 #include "stm32f3xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "scheduler.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -56,8 +58,8 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern TIM_HandleTypeDef htim2;
 extern TIM_HandleTypeDef htim6;
-extern TIM_HandleTypeDef htim7;
 extern DMA_HandleTypeDef hdma_usart1_tx;
 extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
@@ -87,7 +89,7 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  trace_dump();
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -173,9 +175,12 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
+  TRACE(TRACE_PENDSV_BEGIN, 0);
+  scheduler_isrStep();
 
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
+  TRACE(TRACE_PENDSV_END, 0);
 
   /* USER CODE END PendSV_IRQn 1 */
 }
@@ -186,7 +191,7 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-  HAL_SYSTICK_Callback();
+
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
@@ -201,31 +206,87 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f3xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles EXTI line0 interrupt.
+  */
+void EXTI0_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI0_IRQn 0 */
+  TRACE(TRACE_EXTI_BEGIN, 0);
+  /* USER CODE END EXTI0_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(HORN_BUTTON_Pin);
+  /* USER CODE BEGIN EXTI0_IRQn 1 */
+  TRACE(TRACE_EXTI_END, 0);
+  /* USER CODE END EXTI0_IRQn 1 */
+}
+
+/**
+  * @brief This function handles EXTI line4 interrupt.
+  */
+void EXTI4_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI4_IRQn 0 */
+  TRACE(TRACE_EXTI_BEGIN, 0);
+  /* USER CODE END EXTI4_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(FULL_GAS_BUTTON_Pin);
+  /* USER CODE BEGIN EXTI4_IRQn 1 */
+  TRACE(TRACE_EXTI_END, 0);
+  /* USER CODE END EXTI4_IRQn 1 */
+}
+
 /**
   * @brief This function handles DMA1 channel4 global interrupt.
   */
 void DMA1_Channel4_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
-
+  TRACE(TRACE_DMA1_CH4_BEGIN, 0);
   /* USER CODE END DMA1_Channel4_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart1_tx);
   /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
-
+  TRACE(TRACE_DMA1_CH4_END, 0);
   /* USER CODE END DMA1_Channel4_IRQn 1 */
 }
 
+/**
+  * @brief This function handles EXTI line[9:5] interrupts.
+  */
+void EXTI9_5_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI9_5_IRQn 0 */
+  TRACE(TRACE_EXTI_BEGIN, 0);
+  /* USER CODE END EXTI9_5_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(FUELCELL_PREPARETORACE_MODE_BUTTON_Pin);
+  /* USER CODE BEGIN EXTI9_5_IRQn 1 */
+  TRACE(TRACE_EXTI_END, 0);
+  /* USER CODE END EXTI9_5_IRQn 1 */
+}
+
+/**
+  * @brief This function handles TIM2 global interrupt.
+  */
+void TIM2_IRQHandler(void)
+{
+  /* USER CODE BEGIN TIM2_IRQn 0 */
+  TRACE(TRACE_TIM2_BEGIN, 0);
+  /* USER CODE END TIM2_IRQn 0 */
+  HAL_TIM_IRQHandler(&htim2);
+  /* USER CODE BEGIN TIM2_IRQn 1 */
+  TRACE(TRACE_TIM2_END, 0);
+  /* USER CODE END TIM2_IRQn 1 */
+}
+
 /**
   * @brief This function handles USART1 global interrupt / USART1 wake-up interrupt through EXT line 25.
   */
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-
+  TRACE(TRACE_USART1_BEGIN, 0);
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
-
+  TRACE(TRACE_USART1_END, 0);
   /* USER CODE END USART1_IRQn 1 */
 }
 
@@ -235,42 +296,43 @@ void USART1_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+  TRACE(TRACE_USART2_BEGIN, 0);
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
-
+  TRACE(TRACE_USART2_END, 0);
   /* USER CODE END USART2_IRQn 1 */
 }
 
+/**
+  * @brief This function handles EXTI line[15:10] interrupts.
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI15_10_IRQn 0 */
+  TRACE(TRACE_EXTI_BEGIN, 0);
+  /* USER CODE END EXTI15_10_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(FUELCELL_RACE_MODE_BUTTON_Pin);
+  HAL_GPIO_EXTI_IRQHandler(HALF_GAS_BUTTON_Pin);
+  /* USER CODE BEGIN EXTI15_10_IRQn 1 */
+  TRACE(TRACE_EXTI_END, 0);
+  /* USER CODE END EXTI15_10_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM6 global and DAC1 underrun error interrupts.
   */
 void TIM6_DAC1_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM6_DAC1_IRQn 0 */
-
+  TRACE(TRACE_TIM6_BEGIN, 0);
   /* USER CODE END TIM6_DAC1_IRQn 0 */
   HAL_TIM_IRQHandler(&htim6);
   /* USER CODE BEGIN TIM6_DAC1_IRQn 1 */
-
+  TRACE(TRACE_TIM6_END, 0);
   /* USER CODE END TIM6_DAC1_IRQn 1 */
 }
 
-/**
-  * @brief This function handles TIM7 global and DAC2 underrun error interrupts.
-  */
-void TIM7_DAC2_IRQHandler(void)
-{
-  /* USER CODE BEGIN TIM7_DAC2_IRQn 0 */
-
-  /* USER CODE END TIM7_DAC2_IRQn 0 */
-  HAL_TIM_IRQHandler(&htim7);
-  /* USER CODE BEGIN TIM7_DAC2_IRQn 1 */
-
-  /* USER CODE END TIM7_DAC2_IRQn 1 */
-}
-
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
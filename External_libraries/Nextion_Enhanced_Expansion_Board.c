@@ -16,44 +16,143 @@
 #include "Nextion_Enhanced_NX3224K028.h"
 #include "usart.h"
 
+static uint8_t countPins(uint8_t ioMask);
+
 /**
-* @fn Nextion_Enhanced_Expansion_Board_configureGPIO(uint8_t io, uint8_t mode, uint8_t comp)
+* @fn Nextion_Enhanced_Expansion_Board_configureGPIO(NEXTION_HANDLE *nextion, uint8_t io, uint8_t mode, uint8_t comp)
 * @brief Funkcja konfigurujaca piny rozszerzenia (mode: 0-pull up input, 1-input binding, 2-push pull output, 3-PWM output, 4-open drain output)
 */
-uint8_t Nextion_Enhanced_Expansion_Board_configureGPIO(uint8_t io, uint8_t mode, uint8_t comp)
+uint8_t Nextion_Enhanced_Expansion_Board_configureGPIO(NEXTION_HANDLE *nextion, uint8_t io, uint8_t mode, uint8_t comp)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "cfgpio %d,%d,%d", io, mode, comp);
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "cfgpio %d,%d,%d", io, mode, comp);
+}
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+/**
+* @fn Nextion_Enhanced_Expansion_Board_configureGPIOMask(NEXTION_HANDLE *nextion, uint8_t ioMask, uint8_t mode, uint8_t comp)
+* @brief Konfiguracja wszystkich pinow z maski (bit 0 - IO0) w jednej paczce DMA, komendy trafiaja do paczki wszystkie albo zadna
+*/
+uint8_t Nextion_Enhanced_Expansion_Board_configureGPIOMask(NEXTION_HANDLE *nextion, uint8_t ioMask, uint8_t mode, uint8_t comp)
+{
+  if (Nextion_Enhanced_NX3224K028_getFreeSpace(nextion) < countPins(ioMask) * NEXTION_EXPANSION_CFGPIO_LENGTH)
+    {
+      return 0;
+    }
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  for (uint8_t io = 0; io < NEXTION_EXPANSION_PIO_CNT; io++)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      if ( (ioMask & (1 << io)) && !Nextion_Enhanced_NX3224K028_sendCommand(nextion, "cfgpio %d,%d,%d", io, mode, comp) )
+	{
+	  return 0;
+	}
     }
 
-  return 0;
+  return 1;
 }
 
 /**
-* @fn Nextion_Enhanced_Expansion_Board_pinState(uint8_t io, uint8_t state)
+* @fn Nextion_Enhanced_Expansion_Board_pinState(NEXTION_HANDLE *nextion, uint8_t io, uint8_t state)
 * @brief Funkcja ustawiajaca stan wybranego pinu IO
 */
-uint8_t Nextion_Enhanced_Expansion_Board_pinState(uint8_t io, uint8_t state)
+uint8_t Nextion_Enhanced_Expansion_Board_pinState(NEXTION_HANDLE *nextion, uint8_t io, uint8_t state)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "pio%d=%d", io, state);
+}
+
+/**
+* @fn Nextion_Enhanced_Expansion_Board_pinStateMask(NEXTION_HANDLE *nextion, uint8_t ioMask, uint8_t states)
+* @brief Ustawienie stanow wszystkich pinow z maski (bit n states - stan IOn) w jednej paczce DMA
+*/
+uint8_t Nextion_Enhanced_Expansion_Board_pinStateMask(NEXTION_HANDLE *nextion, uint8_t ioMask, uint8_t states)
+{
+  if (Nextion_Enhanced_NX3224K028_getFreeSpace(nextion) < countPins(ioMask) * NEXTION_EXPANSION_PIO_LENGTH)
+    {
+      return 0;
+    }
+
+  for (uint8_t io = 0; io < NEXTION_EXPANSION_PIO_CNT; io++)
+    {
+      if ( (ioMask & (1 << io)) && !Nextion_Enhanced_NX3224K028_sendCommand(nextion, "pio%d=%d", io, (states >> io) & 1) )
+	{
+	  return 0;
+	}
+    }
+
+  return 1;
+}
+
+/**
+* @fn Nextion_Enhanced_Expansion_Board_sequencerStart(NEXTION_EXPANSION_SEQUENCER *sequencer, uint8_t io, const NEXTION_EXPANSION_PATTERN *pattern)
+* @brief Rozpoczecie odtwarzania wzorca od pierwszej szczeliny (wzorzec musi istniec przez caly czas odtwarzania)
+*/
+void Nextion_Enhanced_Expansion_Board_sequencerStart(NEXTION_EXPANSION_SEQUENCER *sequencer, uint8_t io, const NEXTION_EXPANSION_PATTERN *pattern)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "pio%d=%d", io, state);
+  //Zmiana pinu - stan nowego pinu nie jest znany
+  if ( (sequencer->io != io) || (sequencer->pattern == NULL) )
+    {
+      sequencer->pinState = NEXTION_EXPANSION_PIN_UNKNOWN;
+    }
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  sequencer->io = io;
+  sequencer->pattern = pattern;
+  sequencer->slot = 0;
+  sequencer->slotStartTick = HAL_GetTick();
+}
+
+/**
+* @fn Nextion_Enhanced_Expansion_Board_sequencerStop(NEXTION_EXPANSION_SEQUENCER *sequencer)
+* @brief Zatrzymanie wzorca, pin zostanie ustawiony w stan niski przy kolejnym wywolaniu sequencerStep()
+*/
+void Nextion_Enhanced_Expansion_Board_sequencerStop(NEXTION_EXPANSION_SEQUENCER *sequencer)
+{
+  sequencer->pattern = NULL;
+}
+
+/**
+* @fn Nextion_Enhanced_Expansion_Board_sequencerStep(NEXTION_HANDLE *nextion, NEXTION_EXPANSION_SEQUENCER *sequencer)
+* @brief Obsluga sekwencera, wywolywac w kazdym kroku przed flush(). Komenda pio jest wysylana tylko przy zmianie stanu
+* (ponawiana jezeli paczka DMA byla pelna), zwraca 1 jezeli wyslano komende
+*/
+uint8_t Nextion_Enhanced_Expansion_Board_sequencerStep(NEXTION_HANDLE *nextion, NEXTION_EXPANSION_SEQUENCER *sequencer)
+{
+  uint8_t state = 0;
+
+  if (sequencer->pattern != NULL)
+    {
+      uint32_t now = HAL_GetTick();
+
+      if (now - sequencer->slotStartTick >= sequencer->pattern->slotTime)
+	{
+	  sequencer->slot++;
+	  sequencer->slotStartTick = now;
+
+	  if (sequencer->slot >= sequencer->pattern->slotCnt) sequencer->slot = 0;
+	}
+
+      state = (sequencer->pattern->pattern >> sequencer->slot) & 1;
+    }
+
+  if ( (state == sequencer->pinState) || !Nextion_Enhanced_Expansion_Board_pinState(nextion, sequencer->io, state) )
+    {
+      return 0;
+    }
+
+  sequencer->pinState = state;
+
+  return 1;
+}
+
+/**
+* @fn countPins(uint8_t ioMask)
+* @brief Liczba pinow w masce
+*/
+static uint8_t countPins(uint8_t ioMask)
+{
+  uint8_t cnt = 0;
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  for (; ioMask; ioMask &= ioMask - 1)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      cnt++;
     }
 
-  return 0;
+  return cnt;
 }
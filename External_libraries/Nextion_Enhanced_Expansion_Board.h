@@ -12,6 +12,41 @@
 #pragma once
 
 #include "stdint.h"
+#include "Nextion_Enhanced_NX3224K028.h"
 
-extern uint8_t Nextion_Enhanced_Expansion_Board_configureGPIO(uint8_t io, uint8_t mode, uint8_t comp);
-extern uint8_t Nextion_Enhanced_Expansion_Board_pinState(uint8_t io, uint8_t state);
+#define NEXTION_EXPANSION_PIO_CNT		8					///< Liczba pinow IO rozszerzenia
+#define NEXTION_EXPANSION_CFGPIO_LENGTH		(14 + 3)				///< Najdluzsza komenda "cfgpio 7,4,255" + terminator
+#define NEXTION_EXPANSION_PIO_LENGTH		(6 + 3)					///< Komenda "pio7=1" + terminator
+#define NEXTION_EXPANSION_PIN_UNKNOWN		0xFF					///< Stan pinu nie zostal jeszcze wyslany
+
+/**
+* @struct NEXTION_EXPANSION_PATTERN
+* @brief Wzorzec sygnalu (np. buzzer, dioda) odtwarzany cyklicznie przez sekwencer
+*/
+typedef struct
+{
+  uint32_t pattern;				///< Stan pinu w kolejnych szczelinach (bit 0 - pierwsza szczelina)
+  uint8_t slotCnt;				///< Liczba szczelin we wzorcu (1 - 32)
+  uint16_t slotTime;				///< Czas trwania jednej szczeliny [ms]
+} NEXTION_EXPANSION_PATTERN;
+
+/**
+* @struct NEXTION_EXPANSION_SEQUENCER
+* @brief Stan sekwencera jednego pinu, komenda pio jest wysylana tylko przy zmianie stanu
+*/
+typedef struct
+{
+  uint8_t io;					///< Sterowany pin
+  const NEXTION_EXPANSION_PATTERN *pattern;	///< Odtwarzany wzorzec, NULL - sekwencer zatrzymany (pin w stanie niskim)
+  uint8_t slot;					///< Aktualna szczelina wzorca
+  uint32_t slotStartTick;			///< Czas rozpoczecia aktualnej szczeliny [ms]
+  uint8_t pinState;				///< Stan ostatnio wyslany do wyswietlacza
+} NEXTION_EXPANSION_SEQUENCER;
+
+extern uint8_t Nextion_Enhanced_Expansion_Board_configureGPIO(NEXTION_HANDLE *nextion, uint8_t io, uint8_t mode, uint8_t comp);
+extern uint8_t Nextion_Enhanced_Expansion_Board_configureGPIOMask(NEXTION_HANDLE *nextion, uint8_t ioMask, uint8_t mode, uint8_t comp);
+extern uint8_t Nextion_Enhanced_Expansion_Board_pinState(NEXTION_HANDLE *nextion, uint8_t io, uint8_t state);
+extern uint8_t Nextion_Enhanced_Expansion_Board_pinStateMask(NEXTION_HANDLE *nextion, uint8_t ioMask, uint8_t states);
+extern void Nextion_Enhanced_Expansion_Board_sequencerStart(NEXTION_EXPANSION_SEQUENCER *sequencer, uint8_t io, const NEXTION_EXPANSION_PATTERN *pattern);
+extern void Nextion_Enhanced_Expansion_Board_sequencerStop(NEXTION_EXPANSION_SEQUENCER *sequencer);
+extern uint8_t Nextion_Enhanced_Expansion_Board_sequencerStep(NEXTION_HANDLE *nextion, NEXTION_EXPANSION_SEQUENCER *sequencer);
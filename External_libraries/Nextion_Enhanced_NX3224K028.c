@@ -11,345 +11,1037 @@
 
 #include <stdint-gcc.h>
 #include <stdio_ext.h>
+#include <stdarg.h>
 #include <strings.h>
+#include <string.h>
 #include "Nextion_Enhanced_NX3224K028.h"
 #include "usart.h"
 
-uint8_t dataToWrite[100];
+/*
+ * Note: reception runs all the time, so HAL_UART_GetState() never returns HAL_UART_STATE_READY.
+ * Only the TX part of the state (gState) is checked before starting a transfer.
+ */
+
+static NEXTION_HANDLE *instances[NEXTION_MAX_INSTANCES];	///< Zainicjalizowane wyswietlacze, wykorzystywane do przekazania odebranego bajtu do wlasciwej instancji
+
+static uint8_t reinitUart(NEXTION_HANDLE *nextion, uint32_t baudrate);
+static void dropNormalTraffic(NEXTION_HANDLE *nextion);
+static void requestPage(NEXTION_HANDLE *nextion, uint8_t pageId, uint8_t isPrio);
+static uint8_t transparentDataStep(NEXTION_HANDLE *nextion);
+static void updateTxStats(NEXTION_HANDLE *nextion);
+static uint16_t countCommands(const uint8_t *data, uint16_t length);
+static inline uint8_t rxPeek(NEXTION_HANDLE *nextion, uint8_t offset);
+static void decodeFrame(NEXTION_HANDLE *nextion, uint8_t length);
+static void pushEvent(NEXTION_HANDLE *nextion, uint8_t type, uint8_t pageId, uint8_t componentId, uint8_t touchEvent);
+static void rxByteReceived(NEXTION_HANDLE *nextion);
 
 /*
- * Modify txt value in control:
- * ex. Nextion_Enhanced_NX3224K028_writeTxtToControl((const uint8_t *)"t0", (const uint8_t *)"20:12");
+ * Initialise a display instance on its UART (TX DMA must be configured), the handle has to stay valid for the whole program:
+ * ex. static NEXTION_HANDLE lcd; Nextion_Enhanced_NX3224K028_init(&lcd, &huart1);
+ * Returns 0 when NEXTION_MAX_INSTANCES displays are already registered.
  */
-uint8_t Nextion_Enhanced_NX3224K028_writeTxtToControl(const uint8_t *controlName, const uint8_t *valueToWrite)
+uint8_t Nextion_Enhanced_NX3224K028_init(NEXTION_HANDLE *nextion, UART_HandleTypeDef *huart)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "%s.txt=\"%s\"", controlName, valueToWrite);
+  uint8_t slot = NEXTION_MAX_INSTANCES;
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  for (uint8_t i = 0; i < NEXTION_MAX_INSTANCES; i++)
+    {
+      //Ponowna inicjalizacja tej samej instancji zajmuje jej dotychczasowe miejsce
+      if ( (instances[i] == nextion) || ( (instances[i] == NULL) && (slot == NEXTION_MAX_INSTANCES) ) )
+	{
+	  slot = i;
+	}
+    }
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  if (slot == NEXTION_MAX_INSTANCES)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      return 0;
     }
 
-  return 0;
+  memset(nextion, 0, sizeof(NEXTION_HANDLE));
+  nextionRxRing_init(&nextion->rxRing);
+  nextionEventQueue_init(&nextion->eventQueue);
+  nextion->huart = huart;
+  nextion->activePage = NEXTION_PAGE_UNKNOWN;
+
+  instances[slot] = nextion;
+
+  return 1;
 }
 
 /*
- * Modify number value in control:
- * ex. Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t *)"n0", 25);
+ * Append formatted command (with 0xFF 0xFF 0xFF terminator) to the pending DMA frame.
+ * Returns 0 when the frame has no room left, the command has to be retried after the next flush:
+ * ex. Nextion_Enhanced_NX3224K028_sendCommand(&lcd, "%s.val=%d", "n0", 25);
  */
-uint8_t Nextion_Enhanced_NX3224K028_writeNumberToControl(const uint8_t *controlName, uint16_t valueToWrite)
+uint8_t Nextion_Enhanced_NX3224K028_sendCommand(NEXTION_HANDLE *nextion, const char *format, ...)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "%s.val=%d", controlName, valueToWrite);
+  uint16_t freeSpace = Nextion_Enhanced_NX3224K028_getFreeSpace(nextion);
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  //Komenda addt musi byc ostatnia w paczce, kolejne bajty wyswietlacz potraktowalby jako dane
+  if ( (freeSpace <= 3) || (nextion->addtFsm == NEXTION_ADDT_IN_FILL) )
+    {
+      return 0;
+    }
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  uint8_t *command = &nextion->txBuffer[nextion->txFillIdx][nextion->txFillLen];
+
+  //Komenda jest formatowana bezposrednio w buforze DMA, zostaje w nim tylko jezeli zmiesci sie razem z terminatorem
+  va_list args;
+  va_start(args, format);
+  int size = vsnprintf((char*)command, freeSpace - 2, format, args);
+  va_end(args);
+
+  if ( (size < 0) || (size > freeSpace - 3) )
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      return 0;
     }
 
-  return 0;
+  command[size] = 0xFF;
+  command[size + 1] = 0xFF;
+  command[size + 2] = 0xFF;
+
+  nextion->txFillLen += size + 3;
+  nextion->txFillCmdCnt++;
+
+  return 1;
 }
 
 /*
- * Modify number value in control:
- * ex. Nextion_Enhanced_NX3224K028_writeFloatToControl((const uint8_t *)"x0", 25.55);
+ * Send all pending commands in a single DMA transfer, call once per main loop step (after all commands were queued).
+ * Returns 1 if a transfer was started.
  */
-uint8_t Nextion_Enhanced_NX3224K028_writeFloatToControl(const uint8_t *controlName, float valueToWrite)
+uint8_t Nextion_Enhanced_NX3224K028_flush(NEXTION_HANDLE *nextion)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "%s.txt=\"%.2f\"", controlName, valueToWrite);
+  updateTxStats(nextion);
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  //W trakcie wymiany addt zwykle komendy czekaja w buforze
+  if (transparentDataStep(nextion))
+    {
+      return 0;
+    }
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  //Otwarta ramka musi zostac wyslana w calosci, razem z ref_star
+  if ( (nextion->txFillLen == 0) || nextion->txFrameOpen || (nextion->huart->gState != HAL_UART_STATE_READY) )
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      return 0;
     }
 
-  return 0;
+  if (HAL_UART_Transmit_DMA(nextion->huart, nextion->txBuffer[nextion->txFillIdx], nextion->txFillLen) != HAL_OK)
+    {
+      return 0;
+    }
+
+  nextion->txDmaIsPrio = 0;
+
+  if (nextion->addtFsm == NEXTION_ADDT_IN_FILL)
+    {
+      nextion->addtFsm = NEXTION_ADDT_WAIT_READY;
+      nextion->addtStateTick = HAL_GetTick();
+      nextion->addtStartTick = nextion->addtStateTick;
+    }
+
+  nextion->txStatsCmdCnt += nextion->txFillCmdCnt;
+  nextion->txStatsByteCnt += nextion->txFillLen;
+  nextion->txStatsBurstCnt++;
+
+  //Wyswietlacz odpowiada na sendme po kolei, pomiar konczy odpowiedz poprzedzona odpowiedziami na wczesniej wyslane sendme
+  if (nextion->txFrameTimeInFill)
+    {
+      nextion->txFrameTimeInFill = 0;
+      nextion->txFrameTimePending = 1;
+      nextion->txFrameTimeStart = HAL_GetTick();
+      nextion->txFrameTimeReplyLeft = nextion->sendmeInFlight + nextion->txFrameTimeSendme;
+    }
+
+  nextion->sendmeInFlight += nextion->txFillSendmeCnt;
+
+  //Bufor jest teraz wysylany przez DMA, kolejne komendy trafiaja do drugiego bufora
+  nextion->txFillIdx ^= 1;
+  nextion->txFillLen = 0;
+  nextion->txFillCmdCnt = 0;
+  nextion->txFillSendmeCnt = 0;
+
+  return 1;
 }
 
 /*
- * Modify number value in control:
- * ex. Nextion_Enhanced_NX3224K028_writeFltToControl((const uint8_t *)"x0", 25.55);
+ * Load page ahead of all queued traffic (safety pages), normal commands queued or being sent are dropped.
+ * Returns 0 while a previous priority transfer is still in progress (at most 48 B on the wire) or while a transparent data
+ * exchange (addt) is past its command, the display would take the page command as data. A refused request shortens that
+ * exchange: 0xFE is awaited for NEXTION_ADDT_PRIO_TIMEOUT and 0xFD is not awaited once the data is sent, so with flush() every 1 ms
+ * the call is accepted within NEXTION_ADDT_PRIO_TIMEOUT + 3 ms (instead of up to 2 x NEXTION_ADDT_TIMEOUT). The caller has to retry
+ * every step, prioPageLatency is measured from the accepted call:
+ * ex. Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 3);
  */
-uint8_t Nextion_Enhanced_NX3224K028_writeFltToControl(const uint8_t *controlName, uint8_t valueToWrite)
+uint8_t Nextion_Enhanced_NX3224K028_loadNewPagePriority(NEXTION_HANDLE *nextion, uint8_t pageId)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "%s.txt=\"0x%.2X\"", controlName, valueToWrite);
+  if (nextion->txDmaIsPrio && (nextion->huart->gState != HAL_UART_STATE_READY))
+    {
+      return 0;
+    }
+
+  //Wyswietlacz w trybie przezroczystym potraktowalby komende jako dane, wymiana addt jest ograniczona czasowo (NEXTION_ADDT_TIMEOUT)
+  if ( (nextion->addtFsm != NEXTION_ADDT_IDLE) && (nextion->addtFsm != NEXTION_ADDT_IN_FILL) )
+    {
+      nextion->addtPrioPending = 1;
+      return 0;
+    }
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  //Przerwany transfer mogl zostawic w wyswietlaczu czesc komendy (konczy ja sam terminator) oraz wylaczone odswiezanie (ref_stop bez ref_star)
+  int size = snprintf((char*)nextion->txPrioBuffer, sizeof(nextion->txPrioBuffer), NEXTION_TERMINATOR "ref_star" NEXTION_TERMINATOR "page %d" NEXTION_TERMINATOR
+		      "sendme" NEXTION_TERMINATOR, pageId);
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  if ( (size < 0) || (size >= (int)sizeof(nextion->txPrioBuffer)) )
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      return 0;
     }
 
-  return 0;
+  if (nextion->huart->gState != HAL_UART_STATE_READY)
+    {
+      HAL_UART_AbortTransmit(nextion->huart);
+      nextion->abortedBurstCnt++;
+    }
+
+  dropNormalTraffic(nextion);
+
+  if (HAL_UART_Transmit_DMA(nextion->huart, nextion->txPrioBuffer, size) != HAL_OK)
+    {
+      return 0;
+    }
+
+  nextion->txDmaIsPrio = 1;
+  nextion->txStatsCmdCnt += countCommands(nextion->txPrioBuffer, size);
+
+  //Nie wiadomo ile komend sendme przerwanego transferu dotarlo do wyswietlacza, licznik startuje od potwierdzenia tej strony
+  nextion->sendmeInFlight = 0;
+  nextion->sendmePrioSync = 1;
+  nextion->txStatsByteCnt += size;
+  nextion->txStatsBurstCnt++;
+
+  requestPage(nextion, pageId, 1);
+
+  return 1;
 }
 
 /*
- * Modify progress bar value in control:
- * ex. Nextion_Enhanced_NX3224K028_writeValueToProgressBar((const uint8_t *)"j0", 76);
+ * Returns 1 when pageId is the page currently shown by the display, writes to its components are not wasted.
+ * Without a sendme reply the page is assumed to be loaded after NEXTION_PAGE_LOAD_TIMEOUT:
+ * ex. if (Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 1)) ...
  */
-uint8_t Nextion_Enhanced_NX3224K028_writeValueToProgressBar(const uint8_t *controlName, uint8_t value, uint8_t maxAllowableValue)
+uint8_t Nextion_Enhanced_NX3224K028_isPageReady(NEXTION_HANDLE *nextion, uint8_t pageId)
 {
-  // Wykonaj mapowanie
-
-  uint16_t valueToWrite = (100 * value) / maxAllowableValue;
+  if (nextion->pageConfirmPending && (HAL_GetTick() - nextion->pageRequestTick >= NEXTION_PAGE_LOAD_TIMEOUT))
+    {
+      nextion->pageConfirmPending = 0;
+      nextion->activePage = nextion->pageRequested;
+      nextion->pageConfirmTimeoutCnt++;
+    }
 
-  uint8_t size = sprintf((char*)dataToWrite, "%s.val=%d", controlName, valueToWrite);
+  return (!nextion->pageConfirmPending && (nextion->activePage == pageId));
+}
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+/*
+ * Page command was queued, wait for its confirmation
+ */
+static void requestPage(NEXTION_HANDLE *nextion, uint8_t pageId, uint8_t isPrio)
+{
+  nextion->activePage = NEXTION_PAGE_UNKNOWN;
+  nextion->pageRequested = pageId;
+  nextion->pageRequestIsPrio = isPrio;
+  nextion->pageConfirmPending = 1;
+  nextion->pageRequestTick = HAL_GetTick();
+}
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+/*
+ * Discard commands waiting in the fill buffer, they were prepared for the page being replaced
+ */
+static void dropNormalTraffic(NEXTION_HANDLE *nextion)
+{
+  nextion->txFillLen = 0;
+  nextion->txFillCmdCnt = 0;
+  nextion->txFillSendmeCnt = 0;
+  nextion->txReserved = 0;
+  nextion->txFrameOpen = 0;
+  nextion->txFrameTimeInFill = 0;
+  nextion->txFrameTimePending = 0;
+
+  if (nextion->addtFsm == NEXTION_ADDT_IN_FILL)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      nextion->addtFsm = NEXTION_ADDT_IDLE;
     }
-
-  return 0;
 }
 
 /*
- * Modify txt value in control:
- * ex. Nextion_Enhanced_NX3224K028_changeControlColor((const uint8_t *)"electrovalve", 31);
+ * Add a chunk of points to a waveform component using transparent data mode (addt), one channel per call.
+ * The chunk is sent after the display answers 0xFE, normal commands wait until it answers 0xFD.
+ * Returns 0 while a previous chunk is in progress or the pending frame has no room:
+ * ex. Nextion_Enhanced_NX3224K028_addTransparentData(&lcd, 2, 0, points, 10);
  */
-uint8_t Nextion_Enhanced_NX3224K028_changeControlColor(const uint8_t *controlName, uint16_t color_value_565)
+uint8_t Nextion_Enhanced_NX3224K028_addTransparentData(NEXTION_HANDLE *nextion, uint8_t componentId, uint8_t channel, const uint8_t *data, uint16_t length)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "%s.pco=%d", controlName, color_value_565);
+  if ( (nextion->addtFsm != NEXTION_ADDT_IDLE) || (length == 0) || (length > NEXTION_ADDT_MAX_LENGTH) || nextion->txFrameOpen )
+    {
+      return 0;
+    }
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  if (!Nextion_Enhanced_NX3224K028_sendCommand(nextion, "addt %d,%d,%d", componentId, channel, length))
+    {
+      return 0;
+    }
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  //Wartosc 0xFF nie moze wystapic w danych, inaczej po przekroczeniu czasu oczekiwania na 0xFE dane nie konczylyby sie terminatorem
+  for (uint16_t i = 0; i < length; i++)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      nextion->addtBuffer[i] = (data[i] == 0xFF) ? 0xFE : data[i];
     }
+  nextion->addtBuffer[length] = 0xFF;
+  nextion->addtBuffer[length + 1] = 0xFF;
+  nextion->addtBuffer[length + 2] = 0xFF;
+  nextion->addtLength = length + 3;
 
-  return 0;
+  nextion->addtReady = 0;
+  nextion->addtDone = 0;
+  nextion->addtFsm = NEXTION_ADDT_IN_FILL;
+
+  return 1;
 }
 
-uint8_t Nextion_Enhanced_NX3224K028_drawRectangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint8_t *color)
+/*
+ * Transparent data exchange, returns 1 while normal traffic has to wait
+ */
+static uint8_t transparentDataStep(NEXTION_HANDLE *nextion)
 {
-  uint16_t size = sprintf((char*)dataToWrite, "draw %d,%d,%d,%d,%s", x1, y1, x2, y2, color);
+  uint32_t now = HAL_GetTick();
+  uint32_t timeout = nextion->addtPrioPending ? NEXTION_ADDT_PRIO_TIMEOUT : NEXTION_ADDT_TIMEOUT;
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  switch (nextion->addtFsm)
+  {
+    //Komenda addt wyslana, czekaj na 0xFE
+    case NEXTION_ADDT_WAIT_READY:
+      if (!nextion->addtReady)
+	{
+	  if (now - nextion->addtStateTick < timeout) return 1;
+
+	  //Dane zakonczone terminatorem sa bezpieczne takze gdy wyswietlacz nie wszedl w tryb przezroczysty (zostana odrzucone jako bledna komenda)
+	  nextion->addtTimeoutCnt++;
+	}
+
+      nextion->addtFsm = NEXTION_ADDT_SEND;
+      //Fall through - wyslij dane w tym samym kroku
+
+    case NEXTION_ADDT_SEND:
+      if ( (nextion->huart->gState != HAL_UART_STATE_READY)
+	  || (HAL_UART_Transmit_DMA(nextion->huart, nextion->addtBuffer, nextion->addtLength) != HAL_OK) )
+	{
+	  return 1;
+	}
+
+      nextion->txDmaIsPrio = 0;
+      nextion->txStatsByteCnt += nextion->addtLength;
+      nextion->txStatsAddtByteCnt += nextion->addtLength - 3;
+      nextion->txStatsBurstCnt++;
+
+      nextion->addtFsm = NEXTION_ADDT_WAIT_DONE;
+      nextion->addtStateTick = now;
+      return 1;
+
+    //Czekaj na 0xFD, strona priorytetowa czeka tylko na wyslanie danych (kolejne bajty wyswietlacz odbierze juz jako komendy)
+    case NEXTION_ADDT_WAIT_DONE:
+      if (!nextion->addtDone)
+	{
+	  if (nextion->addtPrioPending)
+	    {
+	      if (nextion->huart->gState != HAL_UART_STATE_READY) return 1;
+	    }
+	  else
+	    {
+	      if (now - nextion->addtStateTick < NEXTION_ADDT_TIMEOUT) return 1;
+
+	      nextion->addtTimeoutCnt++;
+	    }
+	}
+      else
+	{
+	  nextion->addtTime = now - nextion->addtStartTick;
+	}
+
+      nextion->addtFsm = NEXTION_ADDT_IDLE;
+      nextion->addtPrioPending = 0;
+      return 0;
+
+    default:
+      return 0;
+  }
+}
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+/*
+ * Returns number of bytes still free in the pending frame
+ */
+uint16_t Nextion_Enhanced_NX3224K028_getFreeSpace(NEXTION_HANDLE *nextion)
+{
+  return NEXTION_TX_BUFFER_SIZE - nextion->txFillLen - nextion->txReserved;
+}
+
+/*
+ * Begin a group of widget updates, the display stops refreshing until endFrame():
+ * ex. Nextion_Enhanced_NX3224K028_beginFrame(&lcd); ...writes...; Nextion_Enhanced_NX3224K028_endFrame(&lcd);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_beginFrame(NEXTION_HANDLE *nextion)
+{
+  if (nextion->txFrameOpen)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
       return 1;
     }
 
-  return 0;
+  //Ramka musi zmiescic ref_stop i miec zagwarantowane miejsce na ref_star (oraz sendme do pomiaru czasu)
+  if (Nextion_Enhanced_NX3224K028_getFreeSpace(nextion) < NEXTION_FRAME_OVERHEAD)
+    {
+      return 0;
+    }
+
+  Nextion_Enhanced_NX3224K028_sendCommand(nextion, "ref_stop");
+
+  nextion->txFrameStart = nextion->txFillLen;
+  nextion->txReserved = NEXTION_FRAME_OVERHEAD - NEXTION_REF_STOP_LENGTH;
+  nextion->txFrameOpen = 1;
+
+  return 1;
 }
 
 /*
- * Change picture on LCD
- * ex. Nextion_Enhanced_NX3224K028_dispResoursePicture(8, 192, 3);
+ * End a group of widget updates, the display renders all changes at once.
+ * Empty frames are removed from the pending DMA frame.
  */
-uint8_t Nextion_Enhanced_NX3224K028_dispResoursePicture(uint16_t xPos, uint16_t yPos, uint8_t picId)
+uint8_t Nextion_Enhanced_NX3224K028_endFrame(NEXTION_HANDLE *nextion)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "pic %d,%d,%d", xPos, yPos, picId);
+  if (!nextion->txFrameOpen)
+    {
+      return 0;
+    }
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  nextion->txFrameOpen = 0;
+  nextion->txReserved = 0;
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  //W ramce nie zapisano zadnej komendy, usun ref_stop
+  if (nextion->txFillLen == nextion->txFrameStart)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
+      nextion->txFillLen -= NEXTION_REF_STOP_LENGTH;
+      nextion->txFillCmdCnt--;
       return 1;
     }
 
-  return 0;
+  Nextion_Enhanced_NX3224K028_sendCommand(nextion, "ref_star");
+
+  //Odpowiedz na sendme oznacza ze wyswietlacz przetworzyl cala ramke, mierz tylko jedna ramke na raz
+  if (!nextion->txFrameTimePending && !nextion->txFrameTimeInFill)
+    {
+      Nextion_Enhanced_NX3224K028_sendme(nextion);
+      nextion->txFrameTimeInFill = 1;
+      nextion->txFrameTimeSendme = nextion->txFillSendmeCnt;
+    }
+
+  return 1;
 }
 
 /*
- * Change using page:
- * ex. Nextion_Enhanced_NX3224K028_loadNewPage(1);
+ * Update commands/bytes per second counters (1 s window)
  */
+static void updateTxStats(NEXTION_HANDLE *nextion)
+{
+  uint32_t now = HAL_GetTick();
+
+  //Brak odpowiedzi na sendme (np. utracona ramka), pozwol rozpoczac kolejny pomiar
+  //Odpowiedzi na sendme z przerwanego transferu lub wyslane z bledna predkoscia nie nadejda, licznik oczekujacych zaczyna sie od nowa
+  if (nextion->txFrameTimePending && (now - nextion->txFrameTimeStart >= NEXTION_FRAME_TIME_TIMEOUT))
+    {
+      nextion->txFrameTimePending = 0;
+      nextion->sendmeInFlight = 0;
+      nextion->sendmePrioSync = 0;
+    }
+
+  if (now - nextion->txStatsWindowStart >= 1000)
+    {
+      nextion->txStats.commandsPerSecond = nextion->txStatsCmdCnt;
+      nextion->txStats.bytesPerSecond = nextion->txStatsByteCnt;
+      nextion->txStats.burstsPerSecond = nextion->txStatsBurstCnt;
+      nextion->txStats.transparentBytesPerSecond = nextion->txStatsAddtByteCnt;
+
+      nextion->txStatsCmdCnt = 0;
+      nextion->txStatsByteCnt = 0;
+      nextion->txStatsBurstCnt = 0;
+      nextion->txStatsAddtByteCnt = 0;
+      nextion->txStatsWindowStart = now;
+    }
+}
 
-uint8_t Nextion_Enhanced_NX3224K028_loadNewPage(uint8_t pageId)
+/*
+ * Number of commands in a buffer, a terminator without a preceding command is not counted
+ */
+static uint16_t countCommands(const uint8_t *data, uint16_t length)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "page %d", pageId);
+  uint16_t commands = 0;
+  uint16_t commandLength = 0;
+
+  for (uint16_t i = 0; i + 2 < length; i++)
+    {
+      if ( (data[i] != 0xFF) || (data[i + 1] != 0xFF) || (data[i + 2] != 0xFF) )
+	{
+	  commandLength++;
+	  continue;
+	}
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+      if (commandLength > 0) commands++;
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+      commandLength = 0;
+      i += 2;
+    }
+
+  return commands;
+}
+
+/*
+ * Start receiving data from the display, every byte is passed to rxRing in the interrupt:
+ * ex. Nextion_Enhanced_NX3224K028_startReception(&lcd);
+ */
+void Nextion_Enhanced_NX3224K028_startReception(NEXTION_HANDLE *nextion)
+{
+  HAL_UART_Receive_IT(nextion->huart, (uint8_t*)&nextion->rxByte, 1);
+}
+
+/*
+ * Must be called from HAL_UART_RxCpltCallback(), returns 1 when huart belongs to one of the displays
+ */
+uint8_t Nextion_Enhanced_NX3224K028_rxCpltCallback(UART_HandleTypeDef *huart)
+{
+  for (uint8_t i = 0; i < NEXTION_MAX_INSTANCES; i++)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      if ( (instances[i] != NULL) && (instances[i]->huart->Instance == huart->Instance) )
+	{
+	  rxByteReceived(instances[i]);
+	  return 1;
+	}
     }
 
   return 0;
 }
 
 /*
- * Change brightness:
- * ex. Nextion_Enhanced_NX3224K028_setBacklight(100); means 100%
+ * Byte was written to rxByte of this display
  */
-uint8_t Nextion_Enhanced_NX3224K028_setBacklight(uint8_t dimPercentValue)
+static void rxByteReceived(NEXTION_HANDLE *nextion)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "dims=%d", dimPercentValue);
+  uint8_t byte = nextion->rxByte;
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  nextion->rxLastByteTick = HAL_GetTick();
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  if (!nextionRxRing_push(&nextion->rxRing, &byte))
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      nextion->rxOverflowCnt++;
     }
 
-  return 0;
+  Nextion_Enhanced_NX3224K028_startReception(nextion);
 }
 
 /*
- * Change Pass/Fail return data:
- * ex. Nextion_Enhanced_NX3224K028_setPassFailReturnData(2); level of Return Data on commands processed over Serial.
+ * Parse frames received from the display (in place, inside rxRing), call once per main loop step.
+ * Returns number of new events added to the queue.
  */
-uint8_t Nextion_Enhanced_NX3224K028_setPassFailReturnData(uint8_t bkcmdValue)
+uint8_t Nextion_Enhanced_NX3224K028_parseReceivedData(NEXTION_HANDLE *nextion)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "bkcmd=%d", bkcmdValue);
+  uint8_t eventsBefore = nextionEventQueue_count(&nextion->eventQueue);
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  //Odbior mogl zostac przerwany przez blad transmisji, wznow go
+  if (nextion->huart->RxState == HAL_UART_STATE_READY)
+    {
+      Nextion_Enhanced_NX3224K028_startReception(nextion);
+    }
+
+  uint32_t available = nextionRxRing_count(&nextion->rxRing);
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  while (nextion->rxScan < available)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      if (rxPeek(nextion, nextion->rxScan) == 0xFF)
+	{
+	  nextion->rxEndCnt++;
+	}
+      else
+	{
+	  nextion->rxEndCnt = 0;
+	}
+
+      nextion->rxScan++;
+
+      //Trzy bajty 0xFF oznaczaja koniec ramki
+      if (nextion->rxEndCnt == 3)
+	{
+	  decodeFrame(nextion, nextion->rxScan - 3);
+	  available -= nextionRxRing_skip(&nextion->rxRing, nextion->rxScan);
+	  nextion->rxScan = 0;
+	  nextion->rxEndCnt = 0;
+	}
+      //Zabezpieczenie przed zapelnieniem bufora ramka bez zakonczenia
+      else if (nextion->rxScan >= (NEXTION_RX_RING_SIZE - 1))
+	{
+	  available -= nextionRxRing_skip(&nextion->rxRing, nextion->rxScan);
+	  nextion->rxScan = 0;
+	  nextion->rxEndCnt = 0;
+	}
     }
 
-  return 0;
+  return nextionEventQueue_count(&nextion->eventQueue) - eventsBefore;
 }
 
 /*
- * Change baudrate:
- * ex. Nextion_Enhanced_NX3224K028_setBaudRate(921600); means 921600 bits/s
+ * Get the oldest pending event:
+ * ex. NEXTION_EVENT ev; while (Nextion_Enhanced_NX3224K028_getEvent(&lcd, &ev)) { ... }
  */
-uint8_t Nextion_Enhanced_NX3224K028_setBaudRate(uint32_t baudrateValue)
+uint8_t Nextion_Enhanced_NX3224K028_getEvent(NEXTION_HANDLE *nextion, NEXTION_EVENT *event)
 {
-  UART_PORT_Nextion.Instance = USART_Nextion;
-  UART_PORT_Nextion.Init.BaudRate = 9600;
-  UART_PORT_Nextion.Init.WordLength = UART_WORDLENGTH_8B;
-  UART_PORT_Nextion.Init.StopBits = UART_STOPBITS_1;
-  UART_PORT_Nextion.Init.Parity = UART_PARITY_NONE;
-  UART_PORT_Nextion.Init.Mode = UART_MODE_TX;
-  UART_PORT_Nextion.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-  UART_PORT_Nextion.Init.OverSampling = UART_OVERSAMPLING_8;
-  UART_PORT_Nextion.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_ENABLE;
-  UART_PORT_Nextion.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT|UART_ADVFEATURE_DMADISABLEONERROR_INIT;
-  UART_PORT_Nextion.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
-  UART_PORT_Nextion.AdvancedInit.DMADisableonRxError = UART_ADVFEATURE_DMA_DISABLEONRXERROR;
-  if (HAL_UART_Init(&UART_PORT_Nextion) != HAL_OK)
+  if (!nextionEventQueue_pop(&nextion->eventQueue, event))
+    {
+      return 0;
+    }
+
+  return 1;
+}
+
+/*
+ * Byte of the analysed frame, offset counted from the oldest byte in rxRing
+ */
+static inline uint8_t rxPeek(NEXTION_HANDLE *nextion, uint8_t offset)
+{
+  uint8_t byte = 0;
+
+  nextionRxRing_peek(&nextion->rxRing, offset, &byte);
+
+  return byte;
+}
+
+/*
+ * Decode the frame at the beginning of rxRing without copying it out
+ */
+static void decodeFrame(NEXTION_HANDLE *nextion, uint8_t length)
+{
+  switch (rxPeek(nextion, 0))
   {
-    Error_Handler();
-    return 0;
+    //Touch event: 0x65 page component event
+    case NEXTION_EVENT_TOUCH:
+      if (length == 4)
+	{
+	  pushEvent(nextion, NEXTION_EVENT_TOUCH, rxPeek(nextion, 1), rxPeek(nextion, 2), rxPeek(nextion, 3));
+	}
+      break;
+
+    //Transparent data mode: 0xFE ready to receive, 0xFD all data received
+    case NEXTION_ADDT_READY:
+      if (length == 1) nextion->addtReady = 1;
+      break;
+
+    case NEXTION_ADDT_FINISHED:
+      if (length == 1) nextion->addtDone = 1;
+      break;
+
+    //Current page: 0x66 page
+    case NEXTION_EVENT_SENDME:
+      if (length == 2)
+	{
+	  uint8_t prioConfirmed = 0;
+
+	  nextion->sendmeReplyCnt++;
+
+	  //Odpowiedzi wyslane przed zaladowaniem zleconej strony zawieraja poprzednia strone i sa pomijane
+	  if (!nextion->pageConfirmPending)
+	    {
+	      nextion->activePage = rxPeek(nextion, 1);
+	    }
+	  else if (rxPeek(nextion, 1) == nextion->pageRequested)
+	    {
+	      nextion->pageConfirmPending = 0;
+	      nextion->activePage = nextion->pageRequested;
+
+	      //Wyswietlacz potwierdzil zaladowanie strony priorytetowej
+	      if (nextion->pageRequestIsPrio)
+		{
+		  prioConfirmed = 1;
+		  nextion->prioPageLatency = nextion->rxLastByteTick - nextion->pageRequestTick;
+
+		  if (nextion->prioPageLatency > nextion->maxPrioPageLatency)
+		    {
+		      nextion->maxPrioPageLatency = nextion->prioPageLatency;
+		    }
+		}
+	    }
+
+	  //Odpowiedzi sprzed potwierdzenia strony priorytetowej pochodza z transferow wyslanych przed nia
+	  if (nextion->sendmePrioSync)
+	    {
+	      nextion->sendmePrioSync = !prioConfirmed;
+	    }
+	  else if (nextion->sendmeInFlight > 0)
+	    {
+	      nextion->sendmeInFlight--;
+
+	      //Odpowiedzi na wczesniejsze sendme (potwierdzenie strony, sprawdzenie polaczenia) nie koncza pomiaru
+	      if (nextion->txFrameTimePending && (--nextion->txFrameTimeReplyLeft == 0))
+		{
+		  nextion->txFrameTimePending = 0;
+		  nextion->frameTime = nextion->rxLastByteTick - nextion->txFrameTimeStart;
+
+		  if (nextion->frameTime > nextion->maxFrameTime)
+		    {
+		      nextion->maxFrameTime = nextion->frameTime;
+		    }
+		}
+	    }
+
+	  pushEvent(nextion, NEXTION_EVENT_SENDME, rxPeek(nextion, 1), 0, 0);
+	}
+      break;
+
+    default:
+      break;
   }
+}
 
-  uint8_t size = sprintf((char*)dataToWrite, "bauds=%ld", baudrateValue);
+static void pushEvent(NEXTION_HANDLE *nextion, uint8_t type, uint8_t pageId, uint8_t componentId, uint8_t touchEvent)
+{
+  NEXTION_EVENT event;
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  event.type = type;
+  event.pageId = pageId;
+  event.componentId = componentId;
+  event.touchEvent = touchEvent;
+  event.timestamp = nextion->rxLastByteTick;
 
-  HAL_UART_Transmit(&UART_PORT_Nextion, dataToWrite, size + 3, HAL_MAX_DELAY);
+  if (!nextionEventQueue_push(&nextion->eventQueue, &event))
+    {
+      nextion->droppedEventsCnt++;
+    }
+}
 
+/*
+ * Modify txt value in control:
+ * ex. Nextion_Enhanced_NX3224K028_writeTxtToControl(&lcd, (const uint8_t *)"t0", (const uint8_t *)"20:12");
+ */
+uint8_t Nextion_Enhanced_NX3224K028_writeTxtToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, const uint8_t *valueToWrite)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.txt=\"%s\"", controlName, valueToWrite);
+}
 
-  HAL_UART_DeInit(&UART_PORT_Nextion);
+/*
+ * Modify number value in control:
+ * ex. Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t *)"n0", 25);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_writeNumberToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint16_t valueToWrite)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.val=%d", controlName, valueToWrite);
+}
 
-  UART_PORT_Nextion.Instance = USART_Nextion;
-  UART_PORT_Nextion.Init.BaudRate = baudrateValue;
-  UART_PORT_Nextion.Init.WordLength = UART_WORDLENGTH_8B;
-  UART_PORT_Nextion.Init.StopBits = UART_STOPBITS_1;
-  UART_PORT_Nextion.Init.Parity = UART_PARITY_NONE;
-  UART_PORT_Nextion.Init.Mode = UART_MODE_TX;
-  UART_PORT_Nextion.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-  UART_PORT_Nextion.Init.OverSampling = UART_OVERSAMPLING_8;
-  UART_PORT_Nextion.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_ENABLE;
-  UART_PORT_Nextion.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT|UART_ADVFEATURE_DMADISABLEONERROR_INIT;
-  UART_PORT_Nextion.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
-  UART_PORT_Nextion.AdvancedInit.DMADisableonRxError = UART_ADVFEATURE_DMA_DISABLEONRXERROR;
-  if (HAL_UART_Init(&UART_PORT_Nextion) != HAL_OK)
-  {
-    Error_Handler();
-    return 0;
-  }
+/*
+ * Modify value of a Nextion variable (or any numeric attribute), full 32-bit range:
+ * ex. Nextion_Enhanced_NX3224K028_writeNumberToVariable(&lcd, (const uint8_t *)"va0", 123456);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_writeNumberToVariable(NEXTION_HANDLE *nextion, const uint8_t *variableName, int32_t valueToWrite)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.val=%ld", variableName, (long)valueToWrite);
+}
+
+/*
+ * Modify number value in control:
+ * ex. Nextion_Enhanced_NX3224K028_writeFloatToControl(&lcd, (const uint8_t *)"x0", 25.55);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_writeFloatToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, float valueToWrite)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.txt=\"%.2f\"", controlName, valueToWrite);
+}
+
+/*
+ * Modify number value in control:
+ * ex. Nextion_Enhanced_NX3224K028_writeFltToControl(&lcd, (const uint8_t *)"x0", 25.55);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_writeFltToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint8_t valueToWrite)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.txt=\"0x%.2X\"", controlName, valueToWrite);
+}
+
+/*
+ * Modify progress bar value in control:
+ * ex. Nextion_Enhanced_NX3224K028_writeValueToProgressBar(&lcd, (const uint8_t *)"j0", 76);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_writeValueToProgressBar(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint8_t value, uint8_t maxAllowableValue)
+{
+  // Wykonaj mapowanie
+
+  uint16_t valueToWrite = (100 * value) / maxAllowableValue;
+
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.val=%d", controlName, valueToWrite);
+}
+
+/*
+ * Modify txt value in control:
+ * ex. Nextion_Enhanced_NX3224K028_changeControlColor(&lcd, (const uint8_t *)"electrovalve", 31);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_changeControlColor(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint16_t color_value_565)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "%s.pco=%d", controlName, color_value_565);
+}
+
+uint8_t Nextion_Enhanced_NX3224K028_drawRectangle(NEXTION_HANDLE *nextion, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint8_t *color)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "draw %d,%d,%d,%d,%s", x1, y1, x2, y2, color);
+}
+
+/*
+ * Change picture on LCD
+ * ex. Nextion_Enhanced_NX3224K028_dispResoursePicture(&lcd, 8, 192, 3);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_dispResoursePicture(NEXTION_HANDLE *nextion, uint16_t xPos, uint16_t yPos, uint8_t picId)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "pic %d,%d,%d", xPos, yPos, picId);
+}
+
+/*
+ * Change using page, followed by sendme confirming that the page was loaded (see Nextion_Enhanced_NX3224K028_isPageReady()):
+ * ex. Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1);
+ */
+
+uint8_t Nextion_Enhanced_NX3224K028_loadNewPage(NEXTION_HANDLE *nextion, uint8_t pageId)
+{
+  uint16_t fillLen = nextion->txFillLen;
+
+  if (!Nextion_Enhanced_NX3224K028_sendCommand(nextion, "page %d", pageId))
+    {
+      return 0;
+    }
+
+  //Obie komendy trafiaja do paczki razem albo wcale
+  if (!Nextion_Enhanced_NX3224K028_sendme(nextion))
+    {
+      nextion->txFillLen = fillLen;
+      nextion->txFillCmdCnt--;
+      return 0;
+    }
+
+  requestPage(nextion, pageId, 0);
 
   return 1;
 }
 
 /*
- * Removes bytes from Serial Buffer:
- * ex. Nextion_Enhanced_NX3224K028_removeBytesFromSerialBuffer(24); delete first 24 bytes on Buffer
+ * Change brightness:
+ * ex. Nextion_Enhanced_NX3224K028_setBacklight(&lcd, 100); means 100%
  */
-uint8_t Nextion_Enhanced_NX3224K028_removeBytesFromSerialBuffer(uint16_t numberOfBytesToRemove)
+uint8_t Nextion_Enhanced_NX3224K028_setBacklight(NEXTION_HANDLE *nextion, uint8_t dimPercentValue)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "udelete %d", numberOfBytesToRemove);
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "dims=%d", dimPercentValue);
+}
+
+/*
+ * Change Pass/Fail return data:
+ * ex. Nextion_Enhanced_NX3224K028_setPassFailReturnData(&lcd, 2); level of Return Data on commands processed over Serial.
+ */
+uint8_t Nextion_Enhanced_NX3224K028_setPassFailReturnData(NEXTION_HANDLE *nextion, uint8_t bkcmdValue)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "bkcmd=%d", bkcmdValue);
+}
+
+/*
+ * Change default baudrate of the display (non-blocking, the UART itself is reconfigured by Nextion_Enhanced_NX3224K028_connectStep()):
+ * ex. Nextion_Enhanced_NX3224K028_setBaudRate(&lcd, 921600); means 921600 bits/s
+ */
+uint8_t Nextion_Enhanced_NX3224K028_setBaudRate(NEXTION_HANDLE *nextion, uint32_t baudrateValue)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "bauds=%lu", (unsigned long)baudrateValue);
+}
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+/*
+ * Asynchronous connection: probes the current baudrate of the display, switches it to targetBaudrate and verifies the link.
+ * Call once per main loop step (together with parseReceivedData() and flush()) until NEXTION_CONNECT_DONE is returned:
+ * ex. if (Nextion_Enhanced_NX3224K028_connectStep(&lcd, 921600) == NEXTION_CONNECT_DONE) ...
+ */
+uint8_t Nextion_Enhanced_NX3224K028_connectStep(NEXTION_HANDLE *nextion, uint32_t targetBaudrate)
+{
+  static const uint32_t probeBaudrates[] = NEXTION_PROBE_BAUDRATES;
 
-  HAL_UART_AbortTransmitCpltCallback(&UART_PORT_Nextion);
+  uint32_t now = HAL_GetTick();
 
-  HAL_UART_Transmit(&UART_PORT_Nextion, dataToWrite, size + 3, HAL_MAX_DELAY);
+  switch (nextion->connectFsm)
+  {
+    //Ustaw kolejna predkosc z listy i zapytaj wyswietlacz o aktualna strone
+    case NEXTION_CONNECT_PROBE:
+      if (!reinitUart(nextion, probeBaudrates[nextion->probeIdx])) return NEXTION_CONNECT_FAILED;
+
+      Nextion_Enhanced_NX3224K028_sendCommand(nextion, "");		//Sam terminator konczy ewentualne smieci w buforze wyswietlacza
+      Nextion_Enhanced_NX3224K028_sendme(nextion);
+
+      nextion->connectReplyCnt = nextion->sendmeReplyCnt;
+      nextion->connectStateTick = now;
+      nextion->connectFsm = NEXTION_CONNECT_PROBE_WAIT;
+      break;
+
+    case NEXTION_CONNECT_PROBE_WAIT:
+      //Wyswietlacz odpowiedzial, predkosc zostala wykryta
+      if (nextion->sendmeReplyCnt != nextion->connectReplyCnt)
+	{
+	  nextion->probeRound = 0;
+
+	  if (probeBaudrates[nextion->probeIdx] == targetBaudrate)
+	    {
+	      nextion->probeIdx = 0;
+	      nextion->connectFsm = NEXTION_CONNECT_PROBE;
+	      return NEXTION_CONNECT_DONE;
+	    }
+
+	  nextion->connectFsm = NEXTION_CONNECT_SWITCH;
+	}
+      else if (now - nextion->connectStateTick >= NEXTION_PROBE_TIMEOUT)
+	{
+	  nextion->probeIdx++;
+	  nextion->connectFsm = NEXTION_CONNECT_PROBE;
+
+	  //Sprawdzono wszystkie predkosci bez odpowiedzi
+	  if (nextion->probeIdx >= sizeof(probeBaudrates) / sizeof(probeBaudrates[0]))
+	    {
+	      nextion->probeIdx = 0;
+	      nextion->probeRound++;
+
+	      if (nextion->probeRound >= NEXTION_PROBE_ROUNDS)
+		{
+		  nextion->probeRound = 0;
+		  return NEXTION_CONNECT_FAILED;
+		}
+	    }
+	}
+      break;
+
+    //Zmien predkosc wyswietlacza (komenda wysylana jeszcze z dotychczasowa predkoscia)
+    case NEXTION_CONNECT_SWITCH:
+      if (Nextion_Enhanced_NX3224K028_setBaudRate(nextion, targetBaudrate)) nextion->connectFsm = NEXTION_CONNECT_SWITCH_WAIT;
+      break;
+
+    //Poczekaj az komenda zostanie w calosci wyslana, dopiero wtedy zmien predkosc UART
+    case NEXTION_CONNECT_SWITCH_WAIT:
+      if ( (nextion->txFillLen == 0) && (nextion->huart->gState == HAL_UART_STATE_READY) )
+	{
+	  if (!reinitUart(nextion, targetBaudrate)) return NEXTION_CONNECT_FAILED;
+
+	  nextion->connectStateTick = now;
+	  nextion->connectFsm = NEXTION_CONNECT_VERIFY;
+	}
+      break;
+
+    //Odczekaj az wyswietlacz przelaczy predkosc, nastepnie sprawdz polaczenie
+    case NEXTION_CONNECT_VERIFY:
+      if (now - nextion->connectStateTick >= NEXTION_BAUD_SWITCH_TIME)
+	{
+	  Nextion_Enhanced_NX3224K028_sendCommand(nextion, "");
+	  Nextion_Enhanced_NX3224K028_sendme(nextion);
+
+	  nextion->connectReplyCnt = nextion->sendmeReplyCnt;
+	  nextion->connectStateTick = now;
+	  nextion->connectFsm = NEXTION_CONNECT_VERIFY_WAIT;
+	}
+      break;
+
+    case NEXTION_CONNECT_VERIFY_WAIT:
+      if (nextion->sendmeReplyCnt != nextion->connectReplyCnt)
+	{
+	  nextion->probeIdx = 0;
+	  nextion->connectFsm = NEXTION_CONNECT_PROBE;
+	  return NEXTION_CONNECT_DONE;
+	}
+
+      //Brak odpowiedzi po zmianie predkosci, zacznij wykrywanie od poczatku
+      if (now - nextion->connectStateTick >= NEXTION_PROBE_TIMEOUT)
+	{
+	  nextion->probeIdx = 0;
+	  nextion->connectFsm = NEXTION_CONNECT_PROBE;
+	}
+      break;
+
+    default:
+      nextion->connectFsm = NEXTION_CONNECT_PROBE;
+      break;
+  }
 
-  /*
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+  return NEXTION_CONNECT_BUSY;
+}
+
+/*
+ * Returns time of the last byte received from the display [ms]
+ */
+uint32_t Nextion_Enhanced_NX3224K028_getLastRxTick(NEXTION_HANDLE *nextion)
+{
+  return nextion->rxLastByteTick;
+}
+
+/*
+ * Reconfigure UART baudrate without blocking, pending TX and RX data is dropped
+ */
+static uint8_t reinitUart(NEXTION_HANDLE *nextion, uint32_t baudrate)
+{
+  HAL_UART_Abort(nextion->huart);
+
+  nextion->huart->Init.BaudRate = baudrate;
+  if (HAL_UART_Init(nextion->huart) != HAL_OK)
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      return 0;
     }
-    */
 
-  return 0;
+  dropNormalTraffic(nextion);
+  nextion->pageConfirmPending = 0;
+  nextion->activePage = NEXTION_PAGE_UNKNOWN;
+  nextion->addtFsm = NEXTION_ADDT_IDLE;
+
+  nextionRxRing_flush(&nextion->rxRing);
+  nextion->rxScan = 0;
+  nextion->rxEndCnt = 0;
+
+  Nextion_Enhanced_NX3224K028_startReception(nextion);
+
+  return 1;
+}
+
+/*
+ * Removes bytes from Serial Buffer:
+ * ex. Nextion_Enhanced_NX3224K028_removeBytesFromSerialBuffer(&lcd, 24); delete first 24 bytes on Buffer
+ */
+uint8_t Nextion_Enhanced_NX3224K028_removeBytesFromSerialBuffer(NEXTION_HANDLE *nextion, uint16_t numberOfBytesToRemove)
+{
+  return Nextion_Enhanced_NX3224K028_sendCommand(nextion, "udelete %d", numberOfBytesToRemove);
 }
 
 
 /*
- * This function reset device:
- * ex. Nextion_Enhanced_NX3224K028_deviceReset();
+ * Ask the display for the current page, answer (0x66) is returned as NEXTION_EVENT_SENDME:
+ * ex. Nextion_Enhanced_NX3224K028_sendme(&lcd);
  */
-uint8_t Nextion_Enhanced_NX3224K028_deviceReset(void)
+uint8_t Nextion_Enhanced_NX3224K028_sendme(NEXTION_HANDLE *nextion)
 {
-  uint8_t size = sprintf((char*)dataToWrite, "rest");
+  if (!Nextion_Enhanced_NX3224K028_sendCommand(nextion, "sendme"))
+    {
+      return 0;
+    }
 
-  dataToWrite[size] = 0xFF;
-  dataToWrite[size + 1] = 0xFF;
-  dataToWrite[size + 2] = 0xFF;
+  nextion->txFillSendmeCnt++;
+
+  return 1;
+}
 
-  if (HAL_UART_GetState(&UART_PORT_Nextion) == HAL_UART_STATE_READY)
+/*
+ * This function reset device:
+ * ex. Nextion_Enhanced_NX3224K028_deviceReset(&lcd);
+ */
+uint8_t Nextion_Enhanced_NX3224K028_deviceReset(NEXTION_HANDLE *nextion)
+{
+  if (!Nextion_Enhanced_NX3224K028_sendCommand(nextion, "rest"))
     {
-      HAL_UART_Transmit_DMA(&UART_PORT_Nextion, dataToWrite, size + 3);
-      return 1;
+      return 0;
     }
 
-  return 0;
+  nextion->pageConfirmPending = 0;
+  nextion->activePage = NEXTION_PAGE_UNKNOWN;
+
+  return 1;
 }
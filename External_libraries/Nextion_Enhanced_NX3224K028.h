@@ -12,23 +12,204 @@
 #pragma once
 
 #include "stdint.h"
+#include "usart.h"
+#include "spsc_ring.h"
 
-#define UART_PORT_Nextion 		huart1
-#define USART_Nextion 			USART1
-
-extern uint8_t dataToWrite[100];
-
-extern uint8_t Nextion_Enhanced_NX3224K028_writeTxtToControl(const uint8_t *controlName, const uint8_t *valueToWrite);
-extern uint8_t Nextion_Enhanced_NX3224K028_writeNumberToControl(const uint8_t *controlName, uint16_t valueToWrite);
-extern uint8_t Nextion_Enhanced_NX3224K028_writeFloatToControl(const uint8_t *controlName, float valueToWrite);
-extern uint8_t Nextion_Enhanced_NX3224K028_writeFltToControl(const uint8_t *controlName, uint8_t valueToWrite);
-extern uint8_t Nextion_Enhanced_NX3224K028_writeValueToProgressBar(const uint8_t *controlName, uint8_t value, uint8_t maxAllowableValue);
-extern uint8_t Nextion_Enhanced_NX3224K028_drawRectangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint8_t *color);
-extern uint8_t Nextion_Enhanced_NX3224K028_changeControlColor(const uint8_t *controlName, uint16_t color_value_565);
-extern uint8_t Nextion_Enhanced_NX3224K028_loadNewPage(uint8_t pageId);
-extern uint8_t Nextion_Enhanced_NX3224K028_setBacklight(uint8_t dimPercentValue);
-extern uint8_t Nextion_Enhanced_NX3224K028_dispResoursePicture(uint16_t xPos, uint16_t yPos, uint8_t picId);
-extern uint8_t Nextion_Enhanced_NX3224K028_setPassFailReturnData(uint8_t bkcmdValue);
-extern uint8_t Nextion_Enhanced_NX3224K028_setBaudRate(uint32_t baudrateValue);
-extern uint8_t Nextion_Enhanced_NX3224K028_deviceReset(void);
-extern uint8_t Nextion_Enhanced_NX3224K028_removeBytesFromSerialBuffer(uint16_t numberOfBytesToRemove);
+#define NEXTION_MAX_INSTANCES		2				///< Liczba wyswietlaczy obslugiwanych jednoczesnie (kazdy na osobnym UART)
+#define NEXTION_TERMINATOR		"\xFF\xFF\xFF"			///< Koniec komendy
+#define NEXTION_TX_BUFFER_SIZE		256				///< Rozmiar jednej paczki komend wysylanej przez DMA
+#define NEXTION_TX_PRIO_BUFFER_SIZE	48				///< Rozmiar bufora komend priorytetowych (terminator + ref_star + page + sendme)
+#define NEXTION_REF_STOP_LENGTH		(8 + 3)				///< "ref_stop" + terminator
+#define NEXTION_FRAME_OVERHEAD		(NEXTION_REF_STOP_LENGTH + (8 + 3) + (6 + 3))	///< ref_stop + ref_star + sendme
+#define NEXTION_FRAME_TIME_TIMEOUT	100				///< Maksymalny czas oczekiwania na odpowiedz konczaca pomiar czasu ramki [ms]
+#define NEXTION_PROBE_BAUDRATES		{ 921600, 9600, 115200, 57600, 38400, 19200 }	///< Predkosci sprawdzane przy wykrywaniu ustawien wyswietlacza
+#define NEXTION_PROBE_TIMEOUT		50				///< Czas oczekiwania na odpowiedz przy jednej predkosci [ms]
+#define NEXTION_PROBE_ROUNDS		3				///< Liczba pelnych prob wykrycia predkosci przed zgloszeniem bledu
+#define NEXTION_BAUD_SWITCH_TIME	50				///< Czas potrzebny wyswietlaczowi na zmiane predkosci [ms]
+#define NEXTION_ADDT_MAX_LENGTH		64				///< Najwieksza liczba punktow wysylana jedna komenda addt
+#define NEXTION_ADDT_TIMEOUT		20				///< Maksymalny czas oczekiwania na odpowiedz 0xFE / 0xFD [ms]
+#define NEXTION_ADDT_PRIO_TIMEOUT	2				///< Czas oczekiwania na 0xFE gdy strona priorytetowa czeka na koniec wymiany addt [ms]
+#define NEXTION_PAGE_LOAD_TIMEOUT	100				///< Czas po ktorym strona jest uznawana za zaladowana mimo braku odpowiedzi sendme [ms]
+#define NEXTION_PAGE_UNKNOWN		0xFF				///< Aktualna strona wyswietlacza nie jest znana
+#define NEXTION_RX_RING_SIZE		64				///< Rozmiar bufora odbiorczego (potega 2)
+#define NEXTION_EVENT_QUEUE_SIZE	8				///< Rozmiar kolejki zdarzen (potega 2)
+
+#define NEXTION_EVENT_TOUCH		0x65				///< Touch event: page, component, event (1 - press, 0 - release)
+#define NEXTION_EVENT_SENDME		0x66				///< Current page number (odpowiedz na sendme)
+#define NEXTION_ADDT_READY		0xFE				///< Wyswietlacz gotowy na dane trybu przezroczystego
+#define NEXTION_ADDT_FINISHED		0xFD				///< Wyswietlacz odebral wszystkie dane trybu przezroczystego
+
+#define NEXTION_CONNECT_BUSY		0				///< Wartosci zwracane przez Nextion_Enhanced_NX3224K028_connectStep()
+#define NEXTION_CONNECT_DONE		1
+#define NEXTION_CONNECT_FAILED		2
+
+#define NEXTION_TOUCH_RELEASE		0
+#define NEXTION_TOUCH_PRESS		1
+
+/**
+* @enum NEXTION_CONNECT_FSM
+* @brief Stany FSM funkcji Nextion_Enhanced_NX3224K028_connectStep()
+*/
+typedef enum
+{
+  NEXTION_CONNECT_PROBE,
+  NEXTION_CONNECT_PROBE_WAIT,
+  NEXTION_CONNECT_SWITCH,
+  NEXTION_CONNECT_SWITCH_WAIT,
+  NEXTION_CONNECT_VERIFY,
+  NEXTION_CONNECT_VERIFY_WAIT
+} NEXTION_CONNECT_FSM;
+
+/**
+* @enum NEXTION_ADDT_FSM
+* @brief Stany wymiany danych w trybie przezroczystym (addt)
+*/
+typedef enum
+{
+  NEXTION_ADDT_IDLE,
+  NEXTION_ADDT_IN_FILL,			///< Komenda addt czeka w paczce na wyslanie
+  NEXTION_ADDT_WAIT_READY,
+  NEXTION_ADDT_SEND,
+  NEXTION_ADDT_WAIT_DONE
+} NEXTION_ADDT_FSM;
+
+/**
+* @struct NEXTION_EVENT
+* @brief Zdarzenie odebrane z wyswietlacza
+*/
+typedef struct
+{
+  uint8_t type;				///< NEXTION_EVENT_TOUCH lub NEXTION_EVENT_SENDME
+  uint8_t pageId;
+  uint8_t componentId;
+  uint8_t touchEvent;			///< NEXTION_TOUCH_PRESS lub NEXTION_TOUCH_RELEASE
+  uint32_t timestamp;			///< Czas odebrania ramki [ms]
+} NEXTION_EVENT;
+
+SPSC_RING_DEFINE(NEXTION_RX_RING, nextionRxRing, uint8_t, NEXTION_RX_RING_SIZE)
+SPSC_RING_DEFINE(NEXTION_EVENT_QUEUE, nextionEventQueue, NEXTION_EVENT, NEXTION_EVENT_QUEUE_SIZE)
+
+/**
+* @struct NEXTION_TX_STATS
+* @brief Statystyki wysylania danych do wyswietlacza z ostatniej pelnej sekundy
+*/
+typedef struct
+{
+  uint32_t commandsPerSecond;
+  uint32_t bytesPerSecond;
+  uint32_t burstsPerSecond;		///< Liczba transferow DMA
+  uint32_t transparentBytesPerSecond;	///< Liczba bajtow danych wyslanych w trybie przezroczystym (addt)
+} NEXTION_TX_STATS;
+
+/**
+* @struct NEXTION_HANDLE
+* @brief Stan jednego wyswietlacza: bufory, FSM oraz statystyki. Kazda instancja korzysta wylacznie z wlasnego UART (i jego kanalu DMA),
+* dzieki czemu wyswietlacze podlaczone do roznych UART sa odswiezane niezaleznie od siebie.
+*/
+typedef struct
+{
+  UART_HandleTypeDef *huart;				///< UART do ktorego podlaczony jest wyswietlacz (TX przez DMA)
+
+  //Wysylanie
+  uint8_t txBuffer[2][NEXTION_TX_BUFFER_SIZE];		///< Dwa bufory: jeden wysylany przez DMA, drugi wypelniany kolejnymi komendami
+  uint8_t txFillIdx;					///< Indeks aktualnie wypelnianego bufora
+  uint16_t txFillLen;					///< Liczba bajtow w wypelnianym buforze
+  uint16_t txFillCmdCnt;				///< Liczba komend w wypelnianym buforze
+  uint16_t txFillSendmeCnt;				///< Liczba komend sendme w wypelnianym buforze
+  uint16_t txReserved;					///< Miejsce zarezerwowane w paczce na zamkniecie ramki (ref_star)
+  uint16_t txFrameStart;				///< Pozycja w paczce za komenda ref_stop otwartej ramki
+  uint8_t txFrameOpen;					///< Flaga otwartej ramki (pomiedzy beginFrame() a endFrame())
+  uint8_t txFrameTimePending;				///< Flaga oczekiwania na odpowiedz sendme konczaca pomiar czasu ramki
+  uint8_t txFrameTimeInFill;				///< Flaga informujaca ze wypelniana paczka zawiera komende konczaca pomiar
+  uint32_t txFrameTimeStart;				///< Czas rozpoczecia wysylania mierzonej ramki [ms]
+  uint16_t txFrameTimeSendme;				///< Numer komendy sendme konczacej pomiar wsrod komend sendme wypelnianego bufora
+  uint16_t txFrameTimeReplyLeft;			///< Liczba odpowiedzi 0x66 do odpowiedzi mierzonej ramki wlacznie
+  uint16_t sendmeInFlight;				///< Liczba wyslanych komend sendme bez odpowiedzi, zerowana po NEXTION_FRAME_TIME_TIMEOUT
+  uint8_t sendmePrioSync;				///< Flaga oczekiwania na potwierdzenie strony priorytetowej, wczesniejsze odpowiedzi 0x66 nie sa liczone
+  uint8_t txPrioBuffer[NEXTION_TX_PRIO_BUFFER_SIZE];	///< Bufor komend priorytetowych (strony bezpieczenstwa), wysylany z pominieciem kolejki
+  uint8_t txDmaIsPrio;					///< Flaga informujaca ze DMA wysyla bufor priorytetowy
+
+  //Tryb przezroczysty (addt)
+  uint8_t addtBuffer[NEXTION_ADDT_MAX_LENGTH + 3];	///< Dane trybu przezroczystego wraz z terminatorem
+  uint16_t addtLength;					///< Liczba bajtow w addtBuffer (wraz z terminatorem)
+  uint8_t addtFsm;					///< FSM trybu przezroczystego, patrz NEXTION_ADDT_FSM
+  volatile uint8_t addtReady;				///< Odebrano 0xFE - wyswietlacz czeka na dane
+  volatile uint8_t addtDone;				///< Odebrano 0xFD - wyswietlacz odebral wszystkie dane
+  uint32_t addtStateTick;				///< Czas wejscia w aktualny stan addtFsm [ms]
+  uint32_t addtStartTick;				///< Czas wyslania komendy addt [ms]
+  uint8_t addtPrioPending;				///< Strona priorytetowa odrzucona w trakcie wymiany addt, oczekiwanie na 0xFE / 0xFD jest skracane
+
+  //Strona
+  uint8_t activePage;					///< Strona potwierdzona przez wyswietlacz (odpowiedz 0x66) lub po uplywie czasu ladowania
+  uint8_t pageConfirmPending;				///< Flaga oczekiwania na potwierdzenie zaladowania strony
+  uint8_t pageRequested;				///< Ostatnio zlecona strona
+  uint8_t pageRequestIsPrio;				///< Flaga informujaca ze strona zostala zlecona komenda priorytetowa
+  uint32_t pageRequestTick;				///< Czas zlecenia zmiany strony [ms]
+
+  //Nawiazywanie polaczenia
+  uint8_t connectFsm;					///< FSM funkcji Nextion_Enhanced_NX3224K028_connectStep()
+  uint8_t probeIdx;					///< Indeks sprawdzanej predkosci w NEXTION_PROBE_BAUDRATES
+  uint8_t probeRound;					///< Numer pelnej proby wykrycia predkosci
+  uint32_t connectReplyCnt;				///< Wartosc sendmeReplyCnt w chwili wyslania zapytania
+  uint32_t connectStateTick;				///< Czas wejscia w aktualny stan connectFsm [ms]
+  uint32_t sendmeReplyCnt;				///< Liczba odebranych odpowiedzi 0x66 (wykorzystywana przy wykrywaniu predkosci)
+
+  //Odbior
+  volatile uint8_t rxByte;				///< Bajt zapisywany przez UART, w przerwaniu przekazywany do rxRing
+  NEXTION_RX_RING rxRing;				///< Bajty odebrane w przerwaniu, najstarszy jest poczatkiem aktualnie analizowanej ramki
+  volatile uint32_t rxLastByteTick;			///< Czas odebrania ostatniego bajtu [ms]
+  uint8_t rxScan;					///< Liczba bajtow rxRing, ktore zostaly juz przeanalizowane
+  uint8_t rxEndCnt;					///< Liczba kolejnych bajtow 0xFF (koniec ramki)
+  NEXTION_EVENT_QUEUE eventQueue;			///< Kolejka zdarzen oczekujacych na obsluge
+
+  //Statystyki
+  uint32_t txStatsWindowStart;				///< Poczatek okna pomiarowego statystyk [ms]
+  uint32_t txStatsCmdCnt;
+  uint32_t txStatsByteCnt;
+  uint32_t txStatsBurstCnt;
+  uint32_t txStatsAddtByteCnt;
+  NEXTION_TX_STATS txStats;				///< Statystyki wysylania z ostatniej pelnej sekundy
+  uint32_t frameTime;					///< Ostatni zmierzony czas wyslania i przetworzenia ramki przez wyswietlacz [ms]
+  uint32_t maxFrameTime;				///< Najdluzszy zmierzony czas wyslania i przetworzenia ramki [ms]
+  uint32_t prioPageLatency;				///< Ostatni zmierzony czas od zlecenia strony priorytetowej do potwierdzenia jej wyswietlenia [ms]
+  uint32_t maxPrioPageLatency;				///< Najdluzszy zmierzony czas od zlecenia strony priorytetowej do jej wyswietlenia [ms]
+  uint32_t abortedBurstCnt;				///< Liczba transferow DMA przerwanych przez komende priorytetowa
+  uint32_t pageConfirmTimeoutCnt;			///< Liczba zmian strony uznanych za zakonczone bez odpowiedzi wyswietlacza
+  uint32_t addtTime;					///< Czas ostatniej wymiany addt od wyslania komendy do potwierdzenia 0xFD [ms]
+  uint32_t addtTimeoutCnt;				///< Liczba wymian addt zakonczonych bez odpowiedzi 0xFE lub 0xFD
+  uint32_t rxOverflowCnt;				///< Liczba bajtow odrzuconych z powodu przepelnienia bufora RX
+  uint32_t droppedEventsCnt;				///< Liczba zdarzen odrzuconych z powodu przepelnienia kolejki
+} NEXTION_HANDLE;
+
+extern uint8_t Nextion_Enhanced_NX3224K028_init(NEXTION_HANDLE *nextion, UART_HandleTypeDef *huart);
+extern uint8_t Nextion_Enhanced_NX3224K028_rxCpltCallback(UART_HandleTypeDef *huart);
+extern uint8_t Nextion_Enhanced_NX3224K028_sendCommand(NEXTION_HANDLE *nextion, const char *format, ...);
+extern uint8_t Nextion_Enhanced_NX3224K028_flush(NEXTION_HANDLE *nextion);
+extern uint16_t Nextion_Enhanced_NX3224K028_getFreeSpace(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_beginFrame(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_endFrame(NEXTION_HANDLE *nextion);
+extern void Nextion_Enhanced_NX3224K028_startReception(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_parseReceivedData(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_getEvent(NEXTION_HANDLE *nextion, NEXTION_EVENT *event);
+
+extern uint8_t Nextion_Enhanced_NX3224K028_writeTxtToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, const uint8_t *valueToWrite);
+extern uint8_t Nextion_Enhanced_NX3224K028_writeNumberToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint16_t valueToWrite);
+extern uint8_t Nextion_Enhanced_NX3224K028_writeNumberToVariable(NEXTION_HANDLE *nextion, const uint8_t *variableName, int32_t valueToWrite);
+extern uint8_t Nextion_Enhanced_NX3224K028_writeFloatToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, float valueToWrite);
+extern uint8_t Nextion_Enhanced_NX3224K028_writeFltToControl(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint8_t valueToWrite);
+extern uint8_t Nextion_Enhanced_NX3224K028_writeValueToProgressBar(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint8_t value, uint8_t maxAllowableValue);
+extern uint8_t Nextion_Enhanced_NX3224K028_drawRectangle(NEXTION_HANDLE *nextion, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint8_t *color);
+extern uint8_t Nextion_Enhanced_NX3224K028_changeControlColor(NEXTION_HANDLE *nextion, const uint8_t *controlName, uint16_t color_value_565);
+extern uint8_t Nextion_Enhanced_NX3224K028_loadNewPage(NEXTION_HANDLE *nextion, uint8_t pageId);
+extern uint8_t Nextion_Enhanced_NX3224K028_loadNewPagePriority(NEXTION_HANDLE *nextion, uint8_t pageId);
+extern uint8_t Nextion_Enhanced_NX3224K028_isPageReady(NEXTION_HANDLE *nextion, uint8_t pageId);
+extern uint8_t Nextion_Enhanced_NX3224K028_addTransparentData(NEXTION_HANDLE *nextion, uint8_t componentId, uint8_t channel, const uint8_t *data, uint16_t length);
+extern uint8_t Nextion_Enhanced_NX3224K028_setBacklight(NEXTION_HANDLE *nextion, uint8_t dimPercentValue);
+extern uint8_t Nextion_Enhanced_NX3224K028_dispResoursePicture(NEXTION_HANDLE *nextion, uint16_t xPos, uint16_t yPos, uint8_t picId);
+extern uint8_t Nextion_Enhanced_NX3224K028_setPassFailReturnData(NEXTION_HANDLE *nextion, uint8_t bkcmdValue);
+extern uint8_t Nextion_Enhanced_NX3224K028_setBaudRate(NEXTION_HANDLE *nextion, uint32_t baudrateValue);
+extern uint8_t Nextion_Enhanced_NX3224K028_deviceReset(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_sendme(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_connectStep(NEXTION_HANDLE *nextion, uint32_t targetBaudrate);
+extern uint32_t Nextion_Enhanced_NX3224K028_getLastRxTick(NEXTION_HANDLE *nextion);
+extern uint8_t Nextion_Enhanced_NX3224K028_removeBytesFromSerialBuffer(NEXTION_HANDLE *nextion, uint16_t numberOfBytesToRemove);
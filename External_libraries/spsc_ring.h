@@ -0,0 +1,187 @@
+/**
+* @file spsc_ring.h
+* @brief Bufor kolowy jeden producent - jeden konsument (np. przerwanie -> petla glowna) bez wylaczania przerwan
+* @details Makro SPSC_RING_DEFINE(TYPE, prefix, itemType, size) generuje strukture TYPE oraz funkcje static inline prefix_xxx().
+* Indeksy head i tail sa licznikami 32-bitowymi bez zawijania, pozycja w buforze to indeks & (size - 1), dlatego size musi byc potega 2.
+* head zapisuje tylko producent, tail tylko konsument, zapis 32-bitowego indeksu na Cortex-M4 jest niepodzielny.
+* Bariera pamieci oddziela dostep do danych od publikacji indeksu, operacje wsadowe (pushBatch, popBatch) wykonuja po jednej
+* parze barier na cala paczke. Naglowek nie zalezy od HAL, na komputerze bariera jest realizowana przez __atomic_thread_fence().
+*
+*   SPSC_RING_DEFINE(RS485_RX_RING, rs485RxRing, uint8_t, 64)
+*   static RS485_RX_RING rxRing;
+*
+*   //Przerwanie (producent)          //Petla glowna (konsument)
+*   rs485RxRing_push(&rxRing, &byte);  while (rs485RxRing_pop(&rxRing, &byte)) { ... }
+*
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// ******************************************************************************************************************************************************** //
+
+#if defined(__arm__)
+#define SPSC_RING_BARRIER()	__asm volatile ("dmb" ::: "memory")		///< Data Memory Barrier (Cortex-M4)
+#else
+#define SPSC_RING_BARRIER()	__atomic_thread_fence(__ATOMIC_SEQ_CST)		///< Kompilacja na komputerze (narzedzia w Tools/)
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @def SPSC_RING_DEFINE(TYPE, prefix, itemType, size)
+* @brief Definicja typu bufora oraz funkcji do jego obslugi
+* @details Producent: prefix_push(), prefix_pushBatch(), prefix_space().
+* Konsument: prefix_pop(), prefix_popBatch(), prefix_peek(), prefix_skip(), prefix_flush(). prefix_count() moze wywolac kazda ze stron.
+*/
+#define SPSC_RING_DEFINE(TYPE, prefix, itemType, size)									\
+															\
+_Static_assert(((size) & ((size) - 1)) == 0, #TYPE ": size must be a power of 2");					\
+															\
+typedef struct														\
+{															\
+  volatile uint32_t head;		/* Liczba zapisanych elementow (modyfikuje tylko producent) */			\
+  volatile uint32_t tail;		/* Liczba odczytanych elementow (modyfikuje tylko konsument) */			\
+  itemType buffer[size];												\
+} TYPE;															\
+															\
+/* Inicjalizacja, wywolac zanim producent lub konsument zaczna korzystac z bufora */					\
+static inline void prefix##_init(TYPE *ring)										\
+{															\
+  ring->head = 0;													\
+  ring->tail = 0;													\
+}															\
+															\
+/* Liczba elementow oczekujacych na odczyt */										\
+static inline uint32_t prefix##_count(const TYPE *ring)									\
+{															\
+  return ring->head - ring->tail;											\
+}															\
+															\
+/* Liczba wolnych miejsc (producent) */											\
+static inline uint32_t prefix##_space(const TYPE *ring)									\
+{															\
+  return (size) - (ring->head - ring->tail);										\
+}															\
+															\
+/* Zapis jednego elementu (producent), zwraca 0 gdy bufor jest pelny */							\
+static inline uint8_t prefix##_push(TYPE *ring, const itemType *item)							\
+{															\
+  uint32_t head = ring->head;												\
+															\
+  if ((head - ring->tail) >= (size))											\
+    {															\
+      return 0;														\
+    }															\
+															\
+  SPSC_RING_BARRIER();			/* Odczyt tail przed nadpisaniem zwolnionego miejsca */			\
+  ring->buffer[head & ((size) - 1)] = *item;										\
+  SPSC_RING_BARRIER();			/* Dane zapisane przed publikacja head */				\
+  ring->head = head + 1;												\
+															\
+  return 1;														\
+}															\
+															\
+/* Zapis do cnt elementow (producent), zwraca liczbe zapisanych */							\
+static inline uint32_t prefix##_pushBatch(TYPE *ring, const itemType *items, uint32_t cnt)				\
+{															\
+  uint32_t head = ring->head;												\
+  uint32_t space = (size) - (head - ring->tail);									\
+															\
+  if (cnt > space) cnt = space;												\
+  if (cnt == 0) return 0;												\
+															\
+  uint32_t pos = head & ((size) - 1);											\
+  uint32_t first = ((size) - pos < cnt) ? ((size) - pos) : cnt;								\
+															\
+  SPSC_RING_BARRIER();													\
+  memcpy(&ring->buffer[pos], items, first * sizeof(itemType));								\
+  memcpy(&ring->buffer[0], items + first, (cnt - first) * sizeof(itemType));						\
+  SPSC_RING_BARRIER();													\
+  ring->head = head + cnt;												\
+															\
+  return cnt;														\
+}															\
+															\
+/* Odczyt najstarszego elementu bez usuwania go z bufora (konsument), offset liczony od najstarszego */		\
+static inline uint8_t prefix##_peek(const TYPE *ring, uint32_t offset, itemType *item)					\
+{															\
+  uint32_t tail = ring->tail;												\
+															\
+  if ((ring->head - tail) <= offset)											\
+    {															\
+      return 0;														\
+    }															\
+															\
+  SPSC_RING_BARRIER();			/* Odczyt head przed odczytem danych */					\
+  *item = ring->buffer[(tail + offset) & ((size) - 1)];									\
+															\
+  return 1;														\
+}															\
+															\
+/* Usuniecie do cnt najstarszych elementow (konsument), zwraca liczbe usunietych */					\
+static inline uint32_t prefix##_skip(TYPE *ring, uint32_t cnt)								\
+{															\
+  uint32_t tail = ring->tail;												\
+  uint32_t available = ring->head - tail;										\
+															\
+  if (cnt > available) cnt = available;											\
+															\
+  SPSC_RING_BARRIER();			/* Odczyty danych zakonczone przed zwolnieniem miejsca */		\
+  ring->tail = tail + cnt;												\
+															\
+  return cnt;														\
+}															\
+															\
+/* Odczyt i usuniecie najstarszego elementu (konsument), zwraca 0 gdy bufor jest pusty */				\
+static inline uint8_t prefix##_pop(TYPE *ring, itemType *item)								\
+{															\
+  uint32_t tail = ring->tail;												\
+															\
+  if (ring->head == tail)												\
+    {															\
+      return 0;														\
+    }															\
+															\
+  SPSC_RING_BARRIER();													\
+  *item = ring->buffer[tail & ((size) - 1)];										\
+  SPSC_RING_BARRIER();													\
+  ring->tail = tail + 1;												\
+															\
+  return 1;														\
+}															\
+															\
+/* Odczyt do maxCnt elementow (konsument), zwraca liczbe odczytanych */							\
+static inline uint32_t prefix##_popBatch(TYPE *ring, itemType *items, uint32_t maxCnt)					\
+{															\
+  uint32_t tail = ring->tail;												\
+  uint32_t cnt = ring->head - tail;											\
+															\
+  if (cnt > maxCnt) cnt = maxCnt;											\
+  if (cnt == 0) return 0;												\
+															\
+  uint32_t pos = tail & ((size) - 1);											\
+  uint32_t first = ((size) - pos < cnt) ? ((size) - pos) : cnt;								\
+															\
+  SPSC_RING_BARRIER();													\
+  memcpy(items, &ring->buffer[pos], first * sizeof(itemType));								\
+  memcpy(items + first, &ring->buffer[0], (cnt - first) * sizeof(itemType));						\
+  SPSC_RING_BARRIER();													\
+  ring->tail = tail + cnt;												\
+															\
+  return cnt;														\
+}															\
+															\
+/* Usuniecie wszystkich oczekujacych elementow (konsument) */								\
+static inline void prefix##_flush(TYPE *ring)										\
+{															\
+  SPSC_RING_BARRIER();													\
+  ring->tail = ring->head;												\
+}
@@ -1,6 +1,17 @@
 /**
 * @file buttons.c
 * @brief Biblioteka do obslugi przyciskow
+* @details Stany wszystkich przyciskow filtrowane sa jednoczesnie licznikami pionowymi (vertical counters): jeden odczyt rejestrow IDR
+* portow A i B na wywolanie tworzy 32-bitowa probke (port A - bity 0..15, port B - bity 16..31), a i-ty bit slow cnt[0..3]
+* tworzy 4-bitowy licznik i-tego przycisku. Licznik zwieksza sie w kazdej probce rozniacej sie od stanu ustalonego,
+* wraca do wartosci poczatkowej gdy probka jest zgodna ze stanem, a jego przepelnienie zmienia stan przycisku.
+* Wartosc poczatkowa licznika (16 - czas filtracji) pozwala ustawic czas filtracji kazdego przycisku osobno.
+* Przyciski krytyczne podczas wyscigu (gaz, klakson, tryby ogniwa paliwowego) dodatkowo zglaszaja zbocza przerwaniem EXTI,
+* ktore zapisuje czas pierwszego zbocza z zegara us (TIM2). Na tej podstawie mierzony jest czas od zbocza do zmiany stanu.
+* Czas pierwszego zbocza jest zachowywany przez drgania styku do zmiany stanu. Zaklocenie jest zglaszane dopiero wtedy, gdy po zboczu
+* probki sa zgodne ze stanem ustalonym przez caly czas filtracji (drugi zestaw licznikow pionowych, quiet[]).
+* Przycisk FUELCELL_OFF (PB4) wspoldzieli linie EXTI4 z FULL_GAS (PA4), dlatego nie zglasza zboczy.
+* Po filtracji zmiany stanow przekazywane sa do gestures_step(), ktore zamienia je na zdarzenia dla odbiorcow.
 * @author Piotr Durakiewicz
 * @date 22.10.2020
 * @todo
@@ -10,115 +21,276 @@
 
 #include "buttons.h"
 #include "gpio.h"
+#include "timers.h"
+#include "trace.h"
+#include "spsc_ring.h"
+#include "gestures.h"
+
+// ******************************************************************************************************************************************************** //
+
+#define EDGE_QUEUE_SIZE			32					///< Rozmiar kolejki zboczy (potega 2)
+#define COUNTER_BITS			4					///< Liczba bitow licznika pionowego
+#define DEBOUNCE_MAX			(1 << COUNTER_BITS)			///< Najdluzszy czas filtracji [wywolanie buttons_step()]
+
+/**
+* @struct BUTTONS_EDGE
+* @brief Zbocze zarejestrowane w przerwaniu EXTI
+*/
+typedef struct
+{
+  uint32_t timeUs;			///< Czas zbocza, mlodsze slowo timers_getUs() [us]
+  uint32_t mask;			///< Przycisk (BUTTONS_xxx)
+} BUTTONS_EDGE;
+
+SPSC_RING_DEFINE(BUTTONS_EDGE_QUEUE, buttonsEdgeQueue, BUTTONS_EDGE, EDGE_QUEUE_SIZE)
+
+/**
+* @struct BUTTONS_CONFIG
+* @brief Konfiguracja przycisku
+*/
+typedef struct
+{
+  uint32_t mask;			///< Przycisk (BUTTONS_xxx)
+  uint8_t *state;			///< Pole struktury BUTTONS
+  uint8_t debounce;			///< Czas filtracji [ms] (1..DEBOUNCE_MAX), zadanie buttons_step() wykonywane jest co 1ms
+} BUTTONS_CONFIG;
 
 // ******************************************************************************************************************************************************** //
 
 BUTTONS_ON_STEERINGWHEEL BUTTONS; 	///< Struktura globalna zawierajaca stany przyciskow
+uint32_t buttons_state;			///< Stany przyciskow po filtracji, maska bitowa BUTTONS_xxx (1 - wcisniety)
+uint32_t buttons_edgeLatency;		///< Czas od pierwszego zbocza do zmiany stanu dla ostatniej zmiany [us]
+uint32_t buttons_maxEdgeLatency;	///< Najdluzszy zanotowany czas od pierwszego zbocza do zmiany stanu [us]
+uint32_t buttons_edgeCnt;		///< Liczba zmian stanu przyciskow zglaszajacych zbocza
+uint32_t buttons_glitchCnt;		///< Liczba zaklocen odrzuconych przez filtr (zmiana krotsza niz czas filtracji)
+uint32_t buttons_edgeOverflowCnt;	///< Liczba zboczy utraconych z powodu przepelnienia kolejki
+
+static BUTTONS_EDGE_QUEUE edgeQueue;	///< Zbocza przekazywane z przerwan EXTI do buttons_step()
+static uint32_t cnt[COUNTER_BITS];	///< Liczniki pionowe, bit i slowa k to bit k licznika przycisku i
+static uint32_t preset[COUNTER_BITS];	///< Wartosci poczatkowe licznikow zapisane tak samo jak cnt[]
+static uint32_t quiet[COUNTER_BITS];	///< Liczniki probek zgodnych ze stanem po zboczu, przepelnienie oznacza zaklocenie
+static uint32_t pendingMask;		///< Przyciski, dla ktorych zarejestrowano zbocze, a stan jeszcze sie nie zmienil
+static uint32_t firstEdgeUs[32];	///< Czas pierwszego zbocza przycisku od ostatniej zmiany stanu (indeks - numer bitu)
+static uint32_t changeUs[32];		///< Czas ostatniej zmiany stanu przycisku (indeks - numer bitu)
+
+static const BUTTONS_CONFIG config[] =
+{
+  { BUTTONS_HALF_GAS,			&BUTTONS.halfGas,		4 },
+  { BUTTONS_FULL_GAS,			&BUTTONS.fullGas,		4 },
+  { BUTTONS_HORN,			&BUTTONS.horn,			4 },
+  { BUTTONS_MODE_1,			&BUTTONS.mode1,			10 },
+  { BUTTONS_MODE_2,			&BUTTONS.mode2,			10 },
+  { BUTTONS_SPEED_RESET,		&BUTTONS.speedReset,		10 },
+  { BUTTONS_SUPPLY,			&BUTTONS.powerSupply,		10 },
+  { BUTTONS_SC_CLOSE,			&BUTTONS.scClose,		10 },
+  { BUTTONS_FUELCELL_OFF,		&BUTTONS.fuelcellOff,		10 },
+  { BUTTONS_FUELCELL_PREPARETORACE,	&BUTTONS.fuelcellPrepareToRace,	10 },
+  { BUTTONS_FUELCELL_RACE,		&BUTTONS.fuelcellRace,		10 },
+};
+
+#define CONFIG_CNT			(sizeof(config) / sizeof(config[0]))
+
+// ******************************************************************************************************************************************************** //
+
+static uint32_t sample(void);
+static uint32_t debounce(uint32_t raw);
+static uint32_t count(uint32_t *counter, uint32_t inc);
+static void processEdges(void);
+static void timestampChanges(uint32_t changed);
+static void updateButtons(void);
 
 // ******************************************************************************************************************************************************** //
 
 /**
-* @fn buttons_step(void)
-* @brief Funkcja sprawdzajaca stany przyciskow przy kazdym obiegu petli, powinna zostac wywolana wewnatrz hydrogreen_step()
+* @fn buttons_init(void)
+* @brief Inicjalizacja obslugi przyciskow, umiescic wewnatrz hydrogreen_init()
 */
-void buttons_step(void)
+void buttons_init(void)
 {
-  if (HAL_GPIO_ReadPin(GPIOA, HALF_GAS_BUTTON_Pin) == GPIO_PIN_RESET)
-    {
-      BUTTONS.halfGas = 1;
-    }
-  else
-    {
-      BUTTONS.halfGas = 0;
-    }
+  buttonsEdgeQueue_init(&edgeQueue);
 
-  if (HAL_GPIO_ReadPin(GPIOA, FULL_GAS_BUTTON_Pin) == GPIO_PIN_RESET)
+  //Wartosc poczatkowa licznika DEBOUNCE_MAX - debounce, przepelnienie nastepuje po debounce kolejnych probkach
+  for (uint8_t i = 0; i < CONFIG_CNT; i++)
     {
-      BUTTONS.fullGas = 1;
-    }
-  else
-    {
-      BUTTONS.fullGas = 0;
-    }
+      uint8_t start = DEBOUNCE_MAX - config[i].debounce;
 
-  if (HAL_GPIO_ReadPin(GPIOA, MODE_1_BUTTON_Pin) == GPIO_PIN_RESET)
-    {
-      BUTTONS.mode1 = 1;
-    }
-  else
-    {
-      BUTTONS.mode1 = 0;
+      for (uint8_t k = 0; k < COUNTER_BITS; k++)
+	{
+	  if (start & (1 << k)) preset[k] |= config[i].mask;
+	}
     }
 
-  if (HAL_GPIO_ReadPin(GPIOB, MODE_2_BUTTON_Pin) == GPIO_PIN_RESET)
-    {
-      BUTTONS.mode2 = 1;
-    }
-  else
+  for (uint8_t k = 0; k < COUNTER_BITS; k++)
     {
-      BUTTONS.mode2 = 0;
+      cnt[k] = preset[k];
+      quiet[k] = preset[k];
     }
 
-  if (HAL_GPIO_ReadPin(GPIOB, HORN_BUTTON_Pin) == GPIO_PIN_RESET)
-    {
-      BUTTONS.horn = 1;
-    }
-  else
-    {
-      BUTTONS.horn = 0;
-    }
+  buttons_state = sample();
+  updateButtons();
+}
 
-  if (HAL_GPIO_ReadPin(GPIOB, SPEED_RESET_BUTTON_Pin) == GPIO_PIN_RESET)
-    {
-      BUTTONS.speedReset = 1;
-    }
-  else
-    {
-      BUTTONS.speedReset = 0;
-    }
+/**
+* @fn buttons_step(void)
+* @brief Funkcja sprawdzajaca stany przyciskow przy kazdym obiegu petli, zadanie planisty (tabela tasks[] w hydrogreen.c)
+*/
+void buttons_step(void)
+{
+  //Zbocza przed probka, aby zbocze widoczne juz w probce mialo zapisany czas
+  processEdges();
+  gestures_step(debounce(sample()));
+}
 
-  if (HAL_GPIO_ReadPin(GPIOB, SUPPLY_BUTTON_Pin) == GPIO_PIN_RESET)
-    {
-      BUTTONS.powerSupply = 1;
-    }
-  else
-    {
-      BUTTONS.powerSupply = 0;
-    }
+/**
+* @fn buttons_getChangeUs(uint8_t bit)
+* @brief Czas ostatniej zmiany stanu przycisku o podanym numerze bitu maski, dla przyciskow zglaszajacych zbocza czas pierwszego zbocza [us]
+*/
+uint32_t buttons_getChangeUs(uint8_t bit)
+{
+  return changeUs[bit & 31];
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  //Czas odczytywany jako pierwszy, przerwania EXTI maja rowny priorytet, wiec zbocza trafiaja do kolejki po kolei (jeden producent)
+  BUTTONS_EDGE edge = { .timeUs = (uint32_t)timers_getUs(), .mask = (BUTTONS_MASK_PA(GPIO_Pin) | BUTTONS_MASK_PB(GPIO_Pin)) & BUTTONS_EDGE_MASK };
 
-  if (HAL_GPIO_ReadPin(GPIOA, SC_CLOSE_BUTTON_Pin) == GPIO_PIN_RESET)
+  //Numer pinu jest jednoznaczny wsrod przyciskow zglaszajacych zbocza, maska wybiera wlasciwy port
+  if (!buttonsEdgeQueue_push(&edgeQueue, &edge))
     {
-      BUTTONS.scClose = 1;
+      buttons_edgeOverflowCnt++;
     }
-  else
+
+  TRACE(TRACE_BUTTON_EDGE, GPIO_Pin);
+}
+
+/**
+* @fn sample(void)
+* @brief Probka stanow wszystkich przyciskow (1 - wcisniety, przyciski zwieraja wejscie do masy)
+*/
+static uint32_t sample(void)
+{
+  return ~(BUTTONS_MASK_PA(GPIOA->IDR) | BUTTONS_MASK_PB(GPIOB->IDR)) & BUTTONS_ALL_MASK;
+}
+
+/**
+* @fn debounce(uint32_t raw)
+* @brief Filtracja wszystkich przyciskow jednoczesnie, zwraca maske przyciskow, ktorych stan sie zmienil
+*/
+static uint32_t debounce(uint32_t raw)
+{
+  uint32_t delta = raw ^ buttons_state;				//Przyciski, ktorych probka rozni sie od stanu ustalonego
+  uint32_t changed = count(cnt, delta);
+
+  //Zbocze bez zmiany stanu: przycisk pozostal w poprzednim stanie przez caly czas filtracji. Pojedyncza probka zgodna ze stanem
+  //(drganie styku) nie konczy oczekiwania, dzieki czemu czas pierwszego zbocza nie jest nadpisywany przez kolejne zbocza drgan
+  if (pendingMask)
     {
-      BUTTONS.scClose = 0;
+      uint32_t glitch = count(quiet, pendingMask & ~delta);
+
+      buttons_glitchCnt += __builtin_popcount(glitch);
+      pendingMask &= ~glitch;
     }
 
-  if (HAL_GPIO_ReadPin(GPIOB, FUELCELL_OFF_MODE_BUTTON_Pin) == GPIO_PIN_RESET)
+  if (changed)
     {
-      BUTTONS.fuelcellOff = 1;
+      buttons_state ^= changed;
+      timestampChanges(changed);
+      updateButtons();
     }
-  else
+
+  return changed;
+}
+
+/**
+* @fn count(uint32_t *counter, uint32_t inc)
+* @brief Inkrementacja licznikow pionowych przyciskow z maski inc (dodawanie z przeniesieniem na maskach), pozostale i przepelnione
+* liczniki wracaja do wartosci poczatkowej. Zwraca maske przepelnionych licznikow.
+*/
+static uint32_t count(uint32_t *counter, uint32_t inc)
+{
+  uint32_t carry = inc;
+  uint32_t next[COUNTER_BITS];
+
+  for (uint8_t k = 0; k < COUNTER_BITS; k++)
     {
-      BUTTONS.fuelcellOff = 0;
+      next[k] = counter[k] ^ carry;
+      carry &= counter[k];
     }
 
-  if (HAL_GPIO_ReadPin(GPIOB, FUELCELL_PREPARETORACE_MODE_BUTTON_Pin) == GPIO_PIN_RESET)
+  //Przeniesienie z najstarszego bitu to przepelnienie licznika
+  uint32_t reload = ~inc | carry;
+
+  for (uint8_t k = 0; k < COUNTER_BITS; k++)
     {
-      BUTTONS.fuelcellPrepareToRace = 1;
+      counter[k] = (next[k] & ~reload) | (preset[k] & reload);
     }
-  else
+
+  return carry;
+}
+
+/**
+* @fn processEdges(void)
+* @brief Zapamietanie czasu pierwszego zbocza kazdego przycisku od ostatniej zmiany jego stanu
+*/
+static void processEdges(void)
+{
+  BUTTONS_EDGE edge;
+
+  while (buttonsEdgeQueue_pop(&edgeQueue, &edge))
     {
-      BUTTONS.fuelcellPrepareToRace = 0;
+      if ( (edge.mask == 0) || (pendingMask & edge.mask) )
+	{
+	  continue;
+	}
+
+      pendingMask |= edge.mask;
+      firstEdgeUs[31 - __CLZ(edge.mask)] = edge.timeUs;
     }
+}
 
-  if (HAL_GPIO_ReadPin(GPIOA, FUELCELL_RACE_MODE_BUTTON_Pin) == GPIO_PIN_RESET)
+/**
+* @fn timestampChanges(uint32_t changed)
+* @brief Zapamietanie czasu zmiany stanu oraz pomiar czasu od pierwszego zbocza do zmiany stanu (zawiera czas filtracji)
+*/
+static void timestampChanges(uint32_t changed)
+{
+  uint32_t nowUs = (uint32_t)timers_getUs();
+
+  while (changed)
     {
-      BUTTONS.fuelcellRace = 1;
+      uint8_t bit = 31 - __CLZ(changed);
+      uint32_t mask = 1UL << bit;
+
+      changed &= ~mask;
+      changeUs[bit] = nowUs;
+
+      //Przyciski bez zarejestrowanego zbocza maja czas probki, w ktorej zmienil sie stan
+      if ( !(pendingMask & mask) )
+	{
+	  continue;
+	}
+
+      pendingMask &= ~mask;
+      changeUs[bit] = firstEdgeUs[bit];
+      buttons_edgeCnt++;
+      buttons_edgeLatency = nowUs - firstEdgeUs[bit];
+
+      if (buttons_edgeLatency > buttons_maxEdgeLatency)
+	{
+	  buttons_maxEdgeLatency = buttons_edgeLatency;
+	}
     }
-  else
+}
+
+/**
+* @fn updateButtons(void)
+* @brief Przepisanie maski buttons_state do pol struktury BUTTONS, wykonywane tylko po zmianie stanu
+*/
+static void updateButtons(void)
+{
+  for (uint8_t i = 0; i < CONFIG_CNT; i++)
     {
-      BUTTONS.fuelcellRace = 0;
+      *config[i].state = (buttons_state & config[i].mask) != 0;
     }
 }
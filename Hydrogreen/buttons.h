@@ -10,6 +10,30 @@
 #pragma once
 
 #include <stdint-gcc.h>
+#include "main.h"
+
+// ******************************************************************************************************************************************************** //
+
+#define BUTTONS_MASK_PA(pin)		((uint32_t)(pin) & 0xFFFF)				///< Bit przycisku z portu A w masce stanow
+#define BUTTONS_MASK_PB(pin)		(((uint32_t)(pin) & 0xFFFF) << 16)			///< Bit przycisku z portu B w masce stanow
+
+#define BUTTONS_HALF_GAS		BUTTONS_MASK_PA(HALF_GAS_BUTTON_Pin)
+#define BUTTONS_FULL_GAS		BUTTONS_MASK_PA(FULL_GAS_BUTTON_Pin)
+#define BUTTONS_MODE_1			BUTTONS_MASK_PA(MODE_1_BUTTON_Pin)
+#define BUTTONS_SC_CLOSE		BUTTONS_MASK_PA(SC_CLOSE_BUTTON_Pin)
+#define BUTTONS_FUELCELL_RACE		BUTTONS_MASK_PA(FUELCELL_RACE_MODE_BUTTON_Pin)
+#define BUTTONS_HORN			BUTTONS_MASK_PB(HORN_BUTTON_Pin)
+#define BUTTONS_MODE_2			BUTTONS_MASK_PB(MODE_2_BUTTON_Pin)
+#define BUTTONS_SPEED_RESET		BUTTONS_MASK_PB(SPEED_RESET_BUTTON_Pin)
+#define BUTTONS_SUPPLY			BUTTONS_MASK_PB(SUPPLY_BUTTON_Pin)
+#define BUTTONS_FUELCELL_OFF		BUTTONS_MASK_PB(FUELCELL_OFF_MODE_BUTTON_Pin)
+#define BUTTONS_FUELCELL_PREPARETORACE	BUTTONS_MASK_PB(FUELCELL_PREPARETORACE_MODE_BUTTON_Pin)
+
+///< Przyciski zglaszajace zbocza przerwaniem EXTI
+#define BUTTONS_EDGE_MASK		(BUTTONS_HALF_GAS | BUTTONS_FULL_GAS | BUTTONS_HORN | BUTTONS_FUELCELL_PREPARETORACE | BUTTONS_FUELCELL_RACE)
+///< Wszystkie przyciski
+#define BUTTONS_ALL_MASK		(BUTTONS_EDGE_MASK | BUTTONS_MODE_1 | BUTTONS_MODE_2 | BUTTONS_SC_CLOSE | BUTTONS_SPEED_RESET | BUTTONS_SUPPLY \
+					 | BUTTONS_FUELCELL_OFF)
 
 // ******************************************************************************************************************************************************** //
 
@@ -32,7 +56,15 @@ typedef struct
   uint8_t fuelcellRace;
 } BUTTONS_ON_STEERINGWHEEL;
 extern BUTTONS_ON_STEERINGWHEEL BUTTONS;
+extern uint32_t buttons_state;					///< Stany przyciskow po filtracji, maska bitowa BUTTONS_xxx (1 - wcisniety)
+extern uint32_t buttons_edgeLatency;				///< Czas od pierwszego zbocza do zmiany stanu dla ostatniej zmiany (z filtracja) [us]
+extern uint32_t buttons_maxEdgeLatency;				///< Najdluzszy zanotowany czas od pierwszego zbocza do zmiany stanu [us]
+extern uint32_t buttons_edgeCnt;				///< Liczba zmian stanu przyciskow zglaszajacych zbocza
+extern uint32_t buttons_glitchCnt;				///< Liczba zaklocen odrzuconych przez filtr
+extern uint32_t buttons_edgeOverflowCnt;			///< Liczba zboczy utraconych z powodu przepelnienia kolejki
 
 // ******************************************************************************************************************************************************** //
 
+extern void buttons_init(void);
 extern void buttons_step(void);
+extern uint32_t buttons_getChangeUs(uint8_t bit);
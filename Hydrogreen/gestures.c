@@ -0,0 +1,208 @@
+/**
+* @file gestures.c
+* @brief Rozpoznawanie gestow przyciskow (wcisniecie, zwolnienie, przytrzymanie, podwojne wcisniecie, kombinacja) na podstawie buttons_state
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include "gestures.h"
+#include "buttons.h"
+#include "timers.h"
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @struct GESTURES_HOLD
+* @brief Przytrzymanie przycisku lub kombinacji przyciskow
+*/
+typedef struct
+{
+  uint32_t buttons;			///< Przyciski, ktore musza byc wcisniete jednoczesnie
+  uint16_t holdMs;			///< Czas przytrzymania, po ktorym wysylane jest GESTURE_HOLD (0 - tylko GESTURE_CHORD)
+  uint8_t active;			///< 1 - wszystkie przyciski sa wcisniete
+  uint8_t fired;			///< 1 - GESTURE_HOLD zostalo juz wyslane w tym przytrzymaniu
+  uint32_t startUs;			///< Czas wcisniecia ostatniego przycisku
+} GESTURES_HOLD;
+
+// ******************************************************************************************************************************************************** //
+
+static GESTURES_SUBSCRIBER *subscribers[GESTURES_MAX_SUBSCRIBERS];	///< Zarejestrowani odbiorcy
+static uint8_t subscribersCnt;
+static GESTURES_HOLD holds[GESTURES_MAX_HOLDS];				///< Zdefiniowane przytrzymania i kombinacje
+static uint8_t holdsCnt;
+static uint32_t pressUs[32];			///< Czas ostatniego wcisniecia przycisku (indeks - numer bitu maski)
+static uint32_t tapArmed;			///< Przyciski, ktorych kolejne wcisniecie w GESTURES_DOUBLE_TAP_MS bedzie podwojnym
+
+// ******************************************************************************************************************************************************** //
+
+static void emit(uint8_t type, uint32_t buttons, uint32_t timeUs, uint32_t durationUs);
+static void buttonChanged(uint8_t bit);
+static void updateHold(GESTURES_HOLD *hold, uint32_t nowUs);
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @fn gestures_subscribe(GESTURES_SUBSCRIBER *subscriber, uint32_t buttons, uint8_t types)
+* @brief Rejestracja odbiorcy zdarzen, wywolac w funkcji inicjalizujacej modulu. Zwraca 0 gdy brak miejsca na odbiorce
+*/
+uint8_t gestures_subscribe(GESTURES_SUBSCRIBER *subscriber, uint32_t buttons, uint8_t types)
+{
+  if (subscribersCnt >= GESTURES_MAX_SUBSCRIBERS)
+    {
+      return 0;
+    }
+
+  gesturesQueue_init(&subscriber->queue);
+  subscriber->buttons = buttons;
+  subscriber->types = types;
+  subscriber->overflowCnt = 0;
+  subscribers[subscribersCnt++] = subscriber;
+
+  return 1;
+}
+
+/**
+* @fn gestures_addHold(uint32_t buttons, uint16_t holdMs)
+* @brief Definicja przytrzymania (jeden przycisk) lub kombinacji (kilka przyciskow w masce). Zwraca 0 gdy brak miejsca
+*/
+uint8_t gestures_addHold(uint32_t buttons, uint16_t holdMs)
+{
+  if ( (holdsCnt >= GESTURES_MAX_HOLDS) || (buttons == 0) )
+    {
+      return 0;
+    }
+
+  holds[holdsCnt].buttons = buttons;
+  holds[holdsCnt].holdMs = holdMs;
+  holds[holdsCnt].active = 0;
+  holdsCnt++;
+
+  return 1;
+}
+
+/**
+* @fn gestures_step(uint32_t changed)
+* @brief Rozpoznawanie gestow, wywolywane z buttons_step() po kazdej filtracji, changed - przyciski, ktorych stan sie zmienil
+*/
+void gestures_step(uint32_t changed)
+{
+  while (changed)
+    {
+      uint8_t bit = 31 - __CLZ(changed);
+
+      changed &= ~(1UL << bit);
+      buttonChanged(bit);
+    }
+
+  //Przytrzymania sprawdzane w kazdym wywolaniu, rowniez bez zmian stanu
+  uint32_t nowUs = (uint32_t)timers_getUs();
+
+  for (uint8_t i = 0; i < holdsCnt; i++)
+    {
+      updateHold(&holds[i], nowUs);
+    }
+}
+
+/**
+* @fn buttonChanged(uint8_t bit)
+* @brief Zdarzenia wcisniecia, zwolnienia i podwojnego wcisniecia przycisku
+*/
+static void buttonChanged(uint8_t bit)
+{
+  uint32_t mask = 1UL << bit;
+  uint32_t timeUs = buttons_getChangeUs(bit);
+
+  if ( !(buttons_state & mask) )
+    {
+      emit(GESTURE_RELEASE, mask, timeUs, timeUs - pressUs[bit]);
+      return;
+    }
+
+  uint32_t sincePressUs = timeUs - pressUs[bit];
+
+  pressUs[bit] = timeUs;
+  emit(GESTURE_PRESS, mask, timeUs, 0);
+
+  //Trzecie szybkie wcisniecie rozpoczyna kolejne podwojne wcisniecie
+  if ( (tapArmed & mask) && (sincePressUs <= GESTURES_DOUBLE_TAP_MS * 1000UL) )
+    {
+      tapArmed &= ~mask;
+      emit(GESTURE_DOUBLE_TAP, mask, timeUs, sincePressUs);
+    }
+  else
+    {
+      tapArmed |= mask;
+    }
+}
+
+/**
+* @fn updateHold(GESTURES_HOLD *hold, uint32_t nowUs)
+* @brief Zdarzenia kombinacji i przytrzymania, zwolnienie dowolnego przycisku konczy przytrzymanie
+*/
+static void updateHold(GESTURES_HOLD *hold, uint32_t nowUs)
+{
+  if ((buttons_state & hold->buttons) != hold->buttons)
+    {
+      hold->active = 0;
+      return;
+    }
+
+  if (!hold->active)
+    {
+      //Poczatek przytrzymania to wcisniecie ostatniego z przyciskow
+      uint32_t buttons = hold->buttons;
+      uint32_t startUs = pressUs[31 - __CLZ(buttons)];
+
+      while (buttons)
+	{
+	  uint8_t bit = 31 - __CLZ(buttons);
+
+	  buttons &= ~(1UL << bit);
+	  if ((int32_t)(pressUs[bit] - startUs) > 0) startUs = pressUs[bit];
+	}
+
+      hold->active = 1;
+      hold->fired = (hold->holdMs == 0);
+      hold->startUs = startUs;
+
+      if (hold->buttons & (hold->buttons - 1))
+	{
+	  emit(GESTURE_CHORD, hold->buttons, startUs, 0);
+	}
+    }
+
+  if ( !hold->fired && ((nowUs - hold->startUs) >= hold->holdMs * 1000UL) )
+    {
+      hold->fired = 1;
+      emit(GESTURE_HOLD, hold->buttons, hold->startUs + hold->holdMs * 1000UL, hold->holdMs * 1000UL);
+    }
+}
+
+/**
+* @fn emit(uint8_t type, uint32_t buttons, uint32_t timeUs, uint32_t durationUs)
+* @brief Przekazanie zdarzenia odbiorcom, ktorych maski obejmuja wszystkie przyciski zdarzenia
+*/
+static void emit(uint8_t type, uint32_t buttons, uint32_t timeUs, uint32_t durationUs)
+{
+  uint32_t durationMs = durationUs / 1000;
+  GESTURE_EVENT event = { .timeUs = timeUs, .buttons = buttons, .state = buttons_state, .type = type,
+			  .durationMs = (durationMs < UINT16_MAX) ? durationMs : UINT16_MAX };
+
+  for (uint8_t i = 0; i < subscribersCnt; i++)
+    {
+      GESTURES_SUBSCRIBER *subscriber = subscribers[i];
+
+      if ( (buttons & ~subscriber->buttons) || !(subscriber->types & GESTURE_TYPE_MASK(type)) )
+	{
+	  continue;
+	}
+
+      if (!gesturesQueue_push(&subscriber->queue, &event))
+	{
+	  subscriber->overflowCnt++;
+	}
+    }
+}
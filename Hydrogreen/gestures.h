@@ -0,0 +1,84 @@
+/**
+* @file gestures.h
+* @brief Rozpoznawanie gestow przyciskow (wcisniecie, zwolnienie, przytrzymanie, podwojne wcisniecie, kombinacja) na podstawie buttons_state
+* @details Odbiorcy rejestruja wlasne kolejki zdarzen (gestures_subscribe()) i odczytuja je funkcja gestures_get() zamiast
+* sprawdzac stany przyciskow w kazdym wywolaniu. Kolejka ma jednego producenta (gestures_step() wywolywane z buttons_step())
+* i jednego odbiorce, ktory moze pracowac w innym kontekscie (np. zadanie RS-485 w przerwaniu PendSV).
+* Czas zdarzenia pochodzi z buttons_getChangeUs(), dla przyciskow obslugiwanych przerwaniami EXTI jest to czas pierwszego zbocza.
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+#pragma once
+
+#include <stdint-gcc.h>
+#include "spsc_ring.h"
+
+// ******************************************************************************************************************************************************** //
+
+#define GESTURES_MAX_SUBSCRIBERS	3			///< Maksymalna liczba odbiorcow zdarzen
+#define GESTURES_MAX_HOLDS		4			///< Maksymalna liczba zdefiniowanych przytrzyman i kombinacji
+#define GESTURES_QUEUE_SIZE		16			///< Rozmiar kolejki zdarzen odbiorcy (potega 2)
+#define GESTURES_DOUBLE_TAP_MS		300			///< Maksymalny czas pomiedzy wcisnieciami podwojnego wcisniecia [ms]
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @enum GESTURE_TYPE
+* @brief Rodzaj zdarzenia
+*/
+typedef enum
+{
+  GESTURE_PRESS,			///< Wcisniecie przycisku
+  GESTURE_RELEASE,			///< Zwolnienie przycisku, durationMs - czas wcisniecia
+  GESTURE_HOLD,				///< Przycisk lub kombinacja przytrzymana przez czas zdefiniowany w gestures_addHold(), durationMs - ten czas
+  GESTURE_DOUBLE_TAP,			///< Drugie wcisniecie w czasie GESTURES_DOUBLE_TAP_MS od pierwszego, durationMs - odstep wcisniec
+  GESTURE_CHORD				///< Wcisniecie ostatniego przycisku kombinacji zdefiniowanej w gestures_addHold()
+} GESTURE_TYPE;
+
+#define GESTURE_TYPE_MASK(type)		(1 << (type))		///< Bit rodzaju zdarzenia w masce odbiorcy
+#define GESTURE_ALL_TYPES		0x1F
+
+/**
+* @struct GESTURE_EVENT
+* @brief Zdarzenie przekazywane odbiorcom
+*/
+typedef struct
+{
+  uint32_t timeUs;			///< Czas zdarzenia, mlodsze slowo timers_getUs() [us]
+  uint32_t buttons;			///< Przycisk lub kombinacja (maska BUTTONS_xxx)
+  uint32_t state;			///< Stany wszystkich przyciskow po zdarzeniu (buttons_state)
+  uint16_t durationMs;			///< Czas zalezny od rodzaju zdarzenia [ms]
+  uint8_t type;				///< GESTURE_TYPE
+} GESTURE_EVENT;
+
+SPSC_RING_DEFINE(GESTURES_QUEUE, gesturesQueue, GESTURE_EVENT, GESTURES_QUEUE_SIZE)
+
+/**
+* @struct GESTURES_SUBSCRIBER
+* @brief Odbiorca zdarzen, struktura musi istniec przez caly czas pracy programu
+*/
+typedef struct
+{
+  GESTURES_QUEUE queue;
+  uint32_t buttons;			///< Przekazywane sa zdarzenia dotyczace wylacznie tych przyciskow
+  uint8_t types;			///< Maska GESTURE_TYPE_MASK() przekazywanych zdarzen
+  volatile uint32_t overflowCnt;	///< Liczba zdarzen utraconych z powodu przepelnienia kolejki
+} GESTURES_SUBSCRIBER;
+
+// ******************************************************************************************************************************************************** //
+
+extern uint8_t gestures_subscribe(GESTURES_SUBSCRIBER *subscriber, uint32_t buttons, uint8_t types);
+extern uint8_t gestures_addHold(uint32_t buttons, uint16_t holdMs);
+extern void gestures_step(uint32_t changed);
+
+/**
+* @fn gestures_get(GESTURES_SUBSCRIBER *subscriber, GESTURE_EVENT *event)
+* @brief Odczyt najstarszego zdarzenia odbiorcy, zwraca 0 gdy kolejka jest pusta
+*/
+static inline uint8_t gestures_get(GESTURES_SUBSCRIBER *subscriber, GESTURE_EVENT *event)
+{
+  return gesturesQueue_pop(&subscriber->queue, event);
+}
@@ -18,10 +18,49 @@
 #include "leds.h"
 #include "gpio.h"
 #include "lcd_control.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "paddle.h"
 
 // ******************************************************************************************************************************************************** //
 
-//#define HYDROGREEN_DEBUG
+/**
+* @enum HYDROGREEN_TASKS
+* @brief Indeksy zadan w tabeli tasks[] (oraz w scheduler_taskStats[])
+*/
+typedef enum
+{
+  TASK_RS485_RX,
+  TASK_RS485_TX,
+  TASK_RS485_SYNC,
+  TASK_LEDS,
+  TASK_PADDLE,
+  TASK_BUTTONS,
+  TASK_LCD,
+  TASK_WATCHDOG,
+  TASK_CNT
+} HYDROGREEN_TASKS;
+
+/**
+* Tabela zadan, okresy i przesuniecia w tickach planisty (0,1ms), budzety w us.
+* Zadania 1kHz maja rozne przesuniecia fazy, dzieki czemu w jednym ticku wykonywane jest co najwyzej jedno z nich obok zadan RS-485.
+* buttons_step() wykonuje sie przed lcd_control_step() w tym samym okresie 1ms.
+* Obsluga RS-485 wykonywana jest w przerwaniu PendSV (SCHEDULER_CONTEXT_ISR), wiec czas kroku wyswietlacza nie opoznia wymiany bajtow,
+* a rs485_syncStep() przekazuje odebrane dane do watku glownego tuz przed lcd_control_step().
+* Zaleglosci: RS-485 uwzglednia pominiete ticki w odliczaniu przerw (scheduler_getReleaseCnt()), leds_step() odlicza okres mrugania
+* liczba wywolan i nadrabia je, spozniona obsluga wyswietlacza jest pomijana, aby planista szybciej odzyskal zapas czasu.
+*/
+static const SCHEDULER_TASK tasks[TASK_CNT] =
+{
+  [TASK_RS485_RX]   = { .step = rs485_rxStep,     .period = 1,                   .offset = 0, .priority = 0, .budget = 10,  .policy = SCHEDULER_POLICY_ONCE, .context = SCHEDULER_CONTEXT_ISR },
+  [TASK_RS485_TX]   = { .step = rs485_txStep,     .period = 1,                   .offset = 0, .priority = 0, .budget = 5,   .policy = SCHEDULER_POLICY_ONCE, .context = SCHEDULER_CONTEXT_ISR },
+  [TASK_RS485_SYNC] = { .step = rs485_syncStep,   .period = SCHEDULER_TICKS_1MS, .offset = 4, .priority = 1, .budget = 10,  .policy = SCHEDULER_POLICY_ONCE },
+  [TASK_LEDS]       = { .step = leds_step,        .period = SCHEDULER_TICKS_1MS, .offset = 1, .priority = 3, .budget = 20,  .policy = SCHEDULER_POLICY_CATCH_UP, .catchUpMax = 10 },
+  [TASK_PADDLE]     = { .step = paddle_step,      .period = SCHEDULER_TICKS_1MS, .offset = 2, .priority = 2, .budget = 20,  .policy = SCHEDULER_POLICY_ONCE },
+  [TASK_BUTTONS]    = { .step = buttons_step,     .period = SCHEDULER_TICKS_1MS, .offset = 3, .priority = 2, .budget = 20,  .policy = SCHEDULER_POLICY_ONCE },
+  [TASK_LCD]        = { .step = lcd_control_step, .period = SCHEDULER_TICKS_1MS, .offset = 5, .priority = 2, .budget = 300, .policy = SCHEDULER_POLICY_SKIP },
+  [TASK_WATCHDOG]   = { .step = watchdog_step,    .period = SCHEDULER_TICKS_1MS, .offset = 8, .priority = 1, .budget = 10,  .policy = SCHEDULER_POLICY_ONCE },
+};
 
 // ******************************************************************************************************************************************************** //
 
@@ -31,36 +70,14 @@
 */
 static void hydrogreen_init(void)
 {
+  trace_init();
   watchdog_init();
   timers_init();
+  buttons_init();
+  paddle_init();
   rs485_init();
-}
-
-/**
-* @fn hydrogreen_step1kHz(void)
-* @brief Glowna funkcja wykonywana co T = 1ms, powinna zostac wywolana wewnatrz hydrogreen_main()
-*/
-static inline void hydrogreen_step1kHz(void)
-{
-#ifdef HYDROGREEN_DEBUG
-  HAL_GPIO_WritePin(GPIOA, DBG_Pin, GPIO_PIN_RESET);
-#endif
-  leds_step();
-  buttons_step();
-  lcd_control_step();
-  watchdog_step();
-#ifdef HYDROGREEN_DEBUG
-  HAL_GPIO_WritePin(GPIOA, DBG_Pin, GPIO_PIN_SET);
-#endif
-}
-
-/**
-* @fn hydrogreen_step(void)
-* @brief Glowna funkcja wykonywana co T = 0,1ms, powinna zostac wywolana wewnatrz hydrogreen_main()
-*/
-static inline void hydrogreen_step10kHz(void)
-{
-  rs485_step();
+  lcd_control_init();
+  scheduler_init(tasks, TASK_CNT);
 }
 
 /**
@@ -73,32 +90,16 @@ void hydrogreen_main(void)
 
   while (1)
     {
-      //Sprawdz czy wystapil tick timera nastepujacy z f = 1kHz
-      if (timers_tick1kHz)
-	{
-	  timers_beforeStep1kHz();
-
-	  hydrogreen_step1kHz();
-
-	  timers_afterStep1kHz();
-
-	  timers_tick1kHz = 0;
-	}
-
-      //Sprawdz czy wystapil tick timera nastepujacy z f = 10kHz
-      if (timers_tick10kHz)
-	{
-	  hydrogreen_step10kHz();
-	  timers_tick10kHz = 0;
-	}
+      scheduler_step();
     }
 }
 
 /**
 * @fn hydrogreen_hardFault(void)
-* @brief Sygnalizacja wystapienia hard fault'a, wywolac w pliku main.c, w funkcji Error_Handler()
+* @brief Sygnalizacja wystapienia hard fault'a i zrzut bufora zdarzen po resecie, wywolac w pliku main.c, w funkcji Error_Handler()
 */
 void hydrogreen_hardFault(void)
 {
   HAL_GPIO_WritePin(GPIOB, LED_NUCLEO_Pin, GPIO_PIN_SET);
+  trace_dump();
 }
@@ -12,28 +12,134 @@
 #include "Nextion_Enhanced_NX3224K028.h"
 #include "Nextion_Enhanced_Expansion_Board.h"
 #include "buttons.h"
+#include "gestures.h"
 #include "rs485.h"
+#include "speed_estimator.h"
+#include "paddle.h"
 #include "timers.h"
 #include "watchdog.h"
 #include "hydrogreen.h"
+#include "main.h"
+#include "trace.h"
 
+#define UART_PORT_LCD				huart1					///< UART wyswietlacza kierowcy
 #define USE_EXPANSION_BOARD 			0
+#define USE_NEXTION_SCRIPTS			0					///< 1 - surowe wartosci trafiaja do zmiennych Nextion, formatowaniem zajmuja sie skrypty HMI (Nextion/HMI_project.md)
+#define USE_TREND_CHART				1					///< 1 - wykres mocy i predkosci na stronie MODE1 (komponent Waveform, Nextion/HMI_project.md)
+#define LCD_TOUCH_REINIT_ID			1					///< ID komponentu na stronie MODE1 ktorego dotkniecie powoduje ponowna inicjalizacje LCD
+#define LCD_EVENT_MAX_LATENCY			(50 * PERIOD_1MS)			///< Zdarzenia starsze niz podany czas sa odrzucane
+#define LCD_BAUDRATE				921600					///< Docelowa predkosc transmisji z wyswietlaczem [bit/s]
+#define LCD_LINK_CHECK_PERIOD			(500 * PERIOD_1MS)			///< Co ile wysylane jest zapytanie sprawdzajace polaczenie z LCD
+#define LCD_LINK_TIMEOUT			(2 * PERIOD_1S)				///< Brak odpowiedzi LCD przez podany czas powoduje ponowna inicjalizacje
+#define LCD_REINIT_BUTTONS			(BUTTONS_MODE_1 | BUTTONS_MODE_2)	///< Kombinacja przyciskow powodujaca ponowna inicjalizacje LCD
+#define LCD_REINIT_HOLD_MS			5000					///< Czas przytrzymania LCD_REINIT_BUTTONS [ms]
+#define LCD_SPEED_BAR_MAX			50					///< Predkosc odpowiadajaca pelnemu paskowi SB [km/h]
+#define LCD_LEAK_BUZZER_IO			7					///< Pin rozszerzenia do ktorego podlaczony jest buzzer
+#define LCD_TREND_ID				20					///< ID komponentu Waveform na stronie MODE1
+#define LCD_TREND_DECIMATION			(100 * PERIOD_1MS)			///< Jeden punkt wykresu jest srednia z probek zebranych w tym czasie
+#define LCD_TREND_RING_SIZE			64					///< Liczba zapamietanych punktow na kanal (potega 2, nie wiecej niz NEXTION_ADDT_MAX_LENGTH)
+#define LCD_TREND_RING_MASK			(LCD_TREND_RING_SIZE - 1)
+#define LCD_TREND_CHUNK				10					///< Liczba punktow wysylanych jedna komenda addt (co 1 s na kanal)
+#define LCD_TREND_HEIGHT			100					///< Wysokosc wykresu [px]
+#define LCD_TREND_SPEED_MAX			50					///< Predkosc odpowiadajaca pelnej wysokosci wykresu
+#define LCD_TREND_POWER_MAX			255					///< Moc calkowita odpowiadajaca pelnej wysokosci wykresu
 
 // ******************************************************************************************************************************************************** //
 
+/**
+* @enum MODE1_VALUES
+* @brief Typ wyliczeniowy zawierajacy wartosci wyswietlane na stronie MODE1_PAGE (najpierw wymagajace czestego odswiezania)
+*/
+typedef enum
+{
+  MODE1_SPEED_BAR,
+#if USE_NEXTION_SCRIPTS == 0
+  MODE1_LAPTIME_MS,
+  MODE1_DELTA_MS,
+#endif
+#if USE_EXPANSION_BOARD == 1
+  MODE1_SPEED_RESET_PIN,
+#endif
+  MODE1_HIGH_VAL_CNT,
+#if USE_NEXTION_SCRIPTS == 1
+  MODE1_SPEED_VAR = MODE1_HIGH_VAL_CNT,
+  MODE1_LAPTIME_VAR,
+  MODE1_DELTA_VAR,
+  MODE1_POWER_VAR,
+  MODE1_HYDROGEN_VAR,
+#else
+  MODE1_SPEED = MODE1_HIGH_VAL_CNT,
+  MODE1_LAPTIME_MIN,
+  MODE1_DELTA_MIN,
+  MODE1_LAPTIME_SEC,
+  MODE1_DELTA_SEC,
+  MODE1_TOTAL_POWER,
+  MODE1_HYDROGEN_USAGE,
+#endif
+  MODE1_PADDLE_STATE,
+  MODE1_BORDER,
+  MODE1_VAL_CNT
+} MODE1_VALUES;
+
+#if USE_TREND_CHART == 1
+/**
+* @enum TREND_CHANNELS
+* @brief Kanaly wykresu na stronie MODE1_PAGE
+*/
+typedef enum
+{
+  TREND_POWER,
+  TREND_SPEED,
+  TREND_CH_CNT
+} TREND_CHANNELS;
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+static NEXTION_HANDLE lcd;			///< Instancja sterownika wyswietlacza kierowcy
 static uint16_t cntTickInitPage;		///< Zmienna odemierzajaca czas przez ktory ma zostac wyswietlana strona startowa w trakcie inicjalizacji
 static uint16_t cntTickMode1Page;		///< Zmienna odmierzajaca czas co ktory maja zostac zaktualizowane wartosci na LCD w trybie MODE1_PAGE
+static uint16_t cntTickMode1LowVal;		///< Licznik odswiezen strony MODE1_PAGE, co 10 odswiezen aktualizowane sa rzadziej zmieniajace sie wartosci
 static uint16_t cntTickEmPage;			///< Zmienna odmierzajaca czas w trybie "EM_PAGE"
 #if USE_EXPANSION_BOARD == 1
-static uint16_t cntTickLeakPage;		///< Zmienna odmierzajaca czas w trybie "LEAK_PAGE"
+static NEXTION_EXPANSION_SEQUENCER leakBuzzer;	///< Sekwencer buzzera alarmu wycieku
+
+//Alarm wycieku: 100 ms przerwy, 50 ms dzwieku (2 komendy pio na okres zamiast jednej komendy co 1 ms)
+static const NEXTION_EXPANSION_PATTERN leakBuzzerPattern = { .pattern = 0x4, .slotCnt = 3, .slotTime = 50 };
 #endif
-static uint16_t cntTickDevReset;		///< Zmienna odmierzajaca czas do resetu urzadzenia
+static GESTURES_SUBSCRIBER gestures;		///< Zdarzenia przyciskow obslugiwanych przez wyswietlacz
+static uint32_t buttonsShown;			///< Stany przyciskow odtworzone ze zdarzen (maska BUTTONS_xxx)
+static uint32_t gesturesOverflowCnt;		///< Wartosc gestures.overflowCnt przy ostatnim odtworzeniu buttonsShown
+static uint8_t mode1Request;			///< Wcisnieto mode1 (bez mode2), oczekuje na zmiane strony
+static uint8_t reinitRequest;			///< Przytrzymano LCD_REINIT_BUTTONS, oczekuje na ponowna inicjalizacje
+static uint16_t cntTickLink;			///< Zmienna odmierzajaca czas od ostatniej odpowiedzi LCD
+static uint32_t lastRxTick;			///< Czas ostatniego bajtu odebranego z LCD, zapamietany przy ostatnim sprawdzeniu polaczenia
 
 static uint8_t mainStepFsm;			///< FSM funkcji lcd_control_step()
 static uint8_t initFsm;				///< FSM funkcji initPage()
 static uint8_t initCplt;			///< Flaga informujaca o zakonczeniu inicjaliacji (jezeli 1 = inicjalizacja zakonczona)
-static uint8_t mode1FsmLowVal;			///< FSM funkcji mode1Page(), dla wartosci wymagajacych czestszego odswiezania
-static uint8_t mode1FsmHighVal;			///< FSM funkcji mode1Page(), dla wartosci ktore moga byc aktualizowane rzadziej
+static uint8_t mode1FsmLowVal;			///< FSM funkcji mode1Page(), dla wartosci ktore moga byc aktualizowane rzadziej
+static uint8_t mode1FsmHighVal;			///< FSM funkcji mode1Page(), dla wartosci wymagajacych czestszego odswiezania
+static int32_t mode1ValCache[MODE1_VAL_CNT];	///< Wartosci ostatnio zapisane na stronie MODE1_PAGE
+static uint16_t mode1ValCacheValid;		///< Maska bitowa poprawnych wpisow w mode1ValCache
+static uint8_t emButtonSet;			///< Flaga informujaca o zapalonym przycisku na stronie EM_PAGE
+static uint8_t pageReady;			///< Flaga informujaca ze wyswietlacz potwierdzil zaladowanie aktualnej strony
+#if USE_TREND_CHART == 1
+static uint16_t cntTickTrend;			///< Licznik probek skladajacych sie na jeden punkt wykresu
+static float trendPowerSum;			///< Suma probek mocy w aktualnym punkcie
+static uint32_t trendSpeedSum;			///< Suma probek predkosci w aktualnym punkcie
+static uint8_t trendRing[TREND_CH_CNT][LCD_TREND_RING_SIZE];	///< Zdecymowane punkty wykresu (wartosci w pikselach)
+static uint8_t trendHead;			///< Liczba zapisanych punktow (modulo 256)
+static uint8_t trendCnt;			///< Liczba poprawnych punktow w trendRing
+static uint8_t trendSent[TREND_CH_CNT];		///< Pozycja pierwszego niewyslanego punktu kazdego kanalu
+static uint8_t trendFullRefresh;		///< Maska kanalow do ponownego wyslania calej historii (po zaladowaniu strony)
+static uint8_t trendChannel;			///< Kanal wysylany w nastepnej kolejnosci
+#endif
+
+uint32_t lcd_control_maxEventLatency;		///< Najdluzszy zanotowany czas od odebrania zdarzenia z LCD do reakcji [ms]
+uint32_t lcd_control_staleEventsCnt;		///< Liczba zdarzen odrzuconych z powodu przekroczenia LCD_EVENT_MAX_LATENCY
+uint32_t lcd_control_linkLostCnt;		///< Liczba ponownych inicjalizacji LCD z powodu utraty polaczenia
+uint32_t lcd_control_connectFailCnt;		///< Liczba nieudanych prob wykrycia predkosci transmisji LCD
 
 // ******************************************************************************************************************************************************** //
 
@@ -49,11 +155,24 @@ typedef enum
   EM_PAGE
 } MAIN_MENU_FSM;
 
+
 // ******************************************************************************************************************************************************** //
 
+void lcd_control_init(void);
 void lcd_control_step(void);
+static void handleDisplayEvents(void);
+static void handleGestures(void);
+static void checkLink(void);
 static void initPage(void);
 static void mode1Page(void);
+static uint8_t updateMode1Value(uint8_t item);
+static int32_t getMode1Value(uint8_t item);
+static uint8_t sendMode1Value(uint8_t item, int32_t value);
+static void speedSample(void);
+#if USE_TREND_CHART == 1
+static void trendSample(void);
+static void trendSend(void);
+#endif
 static void resetAllCntAndFsmState(void);
 static uint8_t emPage(void);
 #if USE_EXPANSION_BOARD == 1
@@ -66,13 +185,50 @@ static uint8_t prevM = 0;
 
 // ******************************************************************************************************************************************************** //
 
+/**
+* @fn lcd_control_init(void)
+* @brief Inicjalizacja obslugi wyswietlacza, umiescic wewnatrz hydrogreen_init()
+*/
+void lcd_control_init(void)
+{
+  Nextion_Enhanced_NX3224K028_init(&lcd, &UART_PORT_LCD);
+  Nextion_Enhanced_NX3224K028_startReception(&lcd);		//Rozpocznij odbior zdarzen z panelu dotykowego
+
+  gestures_subscribe(&gestures, BUTTONS_MODE_1 | BUTTONS_MODE_2 | BUTTONS_SPEED_RESET | BUTTONS_SUPPLY,
+		     GESTURE_TYPE_MASK(GESTURE_PRESS) | GESTURE_TYPE_MASK(GESTURE_RELEASE) | GESTURE_TYPE_MASK(GESTURE_HOLD));
+  gestures_addHold(LCD_REINIT_BUTTONS, LCD_REINIT_HOLD_MS);
+  buttonsShown = buttons_state;
+}
+
 /**
 * @fn lcd_control_step(void)
-* @brief Glowna funkcja obslugujaca wyswietlacz, powinna zostac wywolana wewnatrz hydrogreen_step1kHz()
+* @brief Glowna funkcja obslugujaca wyswietlacz, zadanie planisty wykonywane co 1ms (tabela tasks[] w hydrogreen.c)
 */
 void lcd_control_step(void)
 {
-  if (initCplt) choosePage();	//Zmiana strony jest mozliwa dopiero po zakonczeniu inicjalizacji LCD (initCplt musi wynosic 1)
+  static uint8_t tracedPage = 0xFF;
+  static uint8_t tracedInit = 0xFF;
+
+  TRACE(TRACE_LCD_STEP_BEGIN, 0);
+  Nextion_Enhanced_NX3224K028_parseReceivedData(&lcd);
+  speedSample();
+  handleGestures();
+
+#if USE_TREND_CHART == 1
+  trendSample();		//Historia jest zbierana niezaleznie od wyswietlanej strony
+#endif
+
+  if (initCplt)
+    {
+      handleDisplayEvents();
+      checkLink();
+      choosePage();		//Zmiana strony jest mozliwa dopiero po zakonczeniu inicjalizacji LCD (initCplt musi wynosic 1)
+    }
+
+#if USE_EXPANSION_BOARD == 1
+  //Przed obsluga stron, aby wylaczenie buzzera przy zmianie strony trafilo do paczki przed zapisami nowej strony
+  Nextion_Enhanced_Expansion_Board_sequencerStep(&lcd, &leakBuzzer);
+#endif
 
   switch (mainStepFsm)
   {
@@ -97,6 +253,140 @@ void lcd_control_step(void)
     default:
       break;
   }
+
+  //Wyslij wszystkie komendy zebrane w tym kroku jednym transferem DMA
+  if (Nextion_Enhanced_NX3224K028_flush(&lcd))
+    {
+      TRACE(TRACE_LCD_FLUSH, 0);
+    }
+
+  //Zmiany stanow FSM rejestrowane w jednym miejscu zamiast przy kazdym przejsciu
+  if (mainStepFsm != tracedPage)
+    {
+      tracedPage = mainStepFsm;
+      TRACE(TRACE_LCD_PAGE_STATE, mainStepFsm);
+    }
+
+  if (initFsm != tracedInit)
+    {
+      tracedInit = initFsm;
+      TRACE(TRACE_LCD_INIT_STATE, initFsm);
+    }
+
+  TRACE(TRACE_LCD_STEP_END, 0);
+}
+
+/**
+* @fn handleDisplayEvents(void)
+* @brief Obsluga zdarzen odebranych z wyswietlacza (panel dotykowy)
+*/
+static void handleDisplayEvents(void)
+{
+  NEXTION_EVENT event;
+
+  while (Nextion_Enhanced_NX3224K028_getEvent(&lcd, &event))
+    {
+      uint32_t latency = HAL_GetTick() - event.timestamp;
+
+      //Zbyt stare zdarzenie (np. odebrane w trakcie inicjalizacji) jest odrzucane
+      if (latency > LCD_EVENT_MAX_LATENCY)
+	{
+	  lcd_control_staleEventsCnt++;
+	  continue;
+	}
+
+      if (latency > lcd_control_maxEventLatency) lcd_control_maxEventLatency = latency;
+
+      if (event.type != NEXTION_EVENT_TOUCH) continue;
+
+      //Dotkniecie przycisku na stronie MODE1 zastepuje przytrzymanie mode1 + mode2 przez 5 sekund
+      if ( (mainStepFsm == MODE1_PAGE) && (event.pageId == 1) && (event.componentId == LCD_TOUCH_REINIT_ID)
+	  && (event.touchEvent == NEXTION_TOUCH_RELEASE) )
+	{
+	  resetAllCntAndFsmState();
+	  initCplt = 0;
+	  mainStepFsm = INIT_PAGE;
+	  return;
+	}
+    }
+}
+
+/**
+* @fn handleGestures(void)
+* @brief Obsluga zdarzen przyciskow, zadania zmiany strony wykonywane sa w choosePage()
+*/
+static void handleGestures(void)
+{
+  GESTURE_EVENT event;
+
+  while (gestures_get(&gestures, &event))
+    {
+      switch (event.type)
+      {
+	case GESTURE_PRESS:
+	  buttonsShown |= event.buttons;
+
+	  //Wcisniecie mode1 przy wcisnietym mode2 rozpoczyna kombinacje ponownej inicjalizacji, a nie zmiane strony
+	  if ( (event.buttons == BUTTONS_MODE_1) && !(event.state & BUTTONS_MODE_2) ) mode1Request = 1;
+	  break;
+
+	case GESTURE_RELEASE:
+	  buttonsShown &= ~event.buttons;
+	  break;
+
+	case GESTURE_HOLD:
+	  if (event.buttons == LCD_REINIT_BUTTONS) reinitRequest = 1;
+	  break;
+
+	default:
+	  break;
+      }
+    }
+
+  //Czesc zdarzen zostala utracona, stany przyciskow odtwarzane sa z buttons_state
+  if (gestures.overflowCnt != gesturesOverflowCnt)
+    {
+      gesturesOverflowCnt = gestures.overflowCnt;
+      buttonsShown = buttons_state;
+    }
+
+  //W trakcie inicjalizacji zadania sa odrzucane
+  if (!initCplt)
+    {
+      mode1Request = 0;
+      reinitRequest = 0;
+    }
+}
+
+/**
+* @fn checkLink(void)
+* @brief Okresowe sprawdzanie polaczenia z wyswietlaczem, po utracie polaczenia LCD jest ponownie inicjalizowany
+*/
+static void checkLink(void)
+{
+  cntTickLink++;
+
+  //Dowolny odebrany bajt (zdarzenie dotyku, odpowiedz na sendme) potwierdza polaczenie
+  if (Nextion_Enhanced_NX3224K028_getLastRxTick(&lcd) != lastRxTick)
+    {
+      lastRxTick = Nextion_Enhanced_NX3224K028_getLastRxTick(&lcd);
+      cntTickLink = 0;
+    }
+
+  if (cntTickLink >= LCD_LINK_TIMEOUT)
+    {
+      lcd_control_linkLostCnt++;
+      TRACE(TRACE_LCD_LINK_LOST, lcd_control_linkLostCnt);
+      resetAllCntAndFsmState();
+      initCplt = 0;
+      mainStepFsm = INIT_PAGE;
+      return;
+    }
+
+  if ( (cntTickLink > 0) && (cntTickLink % LCD_LINK_CHECK_PERIOD == 0) )
+    {
+      Nextion_Enhanced_NX3224K028_sendme(&lcd);
+    }
 }
 
 /**
@@ -111,66 +401,54 @@ static void initPage(void)
   {
     //Zresetuj wyswietlacz
     case 0:
-      if (Nextion_Enhanced_NX3224K028_deviceReset()) initFsm++;
+      if (Nextion_Enhanced_NX3224K028_deviceReset(&lcd)) initFsm++;
       break;
 
-    //Odczekaj 150ms (jest to czas inicjalizacji wyswietlacza)
+    //Odczekaj 150ms (jest to czas inicjalizacji wyswietlacza), nastepnie wykryj i ustaw predkosc transmisji bez blokowania petli glownej
     case 1:
       if (cntTickInitPage > 150 * PERIOD_1MS)
 	{
-	  cntTickInitPage = 0;
-	  initFsm++;
+	  switch (Nextion_Enhanced_NX3224K028_connectStep(&lcd, LCD_BAUDRATE))
+	  {
+	    case NEXTION_CONNECT_DONE:
+	      cntTickInitPage = 0;
+	      initFsm++;
+	      break;
+
+	    //Wyswietlacz nie odpowiada przy zadnej predkosci, sprobuj ponownie od resetu
+	    case NEXTION_CONNECT_FAILED:
+	      lcd_control_connectFailCnt++;
+	      cntTickInitPage = 0;
+	      initFsm = 0;
+	      break;
+
+	    default:
+	      break;
+	  }
 	}
       break;
 
       //Narysuj prostokat wyznaczajacy krawedzie LCD
     case 2:
-      if (Nextion_Enhanced_NX3224K028_drawRectangle(0, 0, 320, 240, (const uint8_t *)"GRAY"))
+      if (Nextion_Enhanced_NX3224K028_drawRectangle(&lcd, 0, 0, 320, 240, (const uint8_t *)"GRAY"))
 	{
 #if USE_EXPANSION_BOARD == 1
 	  initFsm++;
 #else
-	  initFsm = 11;
+	  initFsm = 4;
 #endif
 	}
       break;
 
 #if USE_EXPANSION_BOARD == 1
+      //Wszystkie piny rozszerzenia jako wyjscia push-pull, jedna paczka DMA
     case 3:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(0, 2, 0)) initFsm++;
-      break;
-
-    case 4:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(1, 2, 0)) initFsm++;
-      break;
-
-    case 5:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(2, 2, 0)) initFsm++;
-      break;
-
-    case 6:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(3, 2, 0)) initFsm++;
-      break;
-
-    case 7:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(4, 2, 0)) initFsm++;
-      break;
-
-    case 8:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(5, 2, 0)) initFsm++;
-      break;
-
-    case 9:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(6, 2, 0)) initFsm++;
-      break;
-
-    case 10:
-      if (Nextion_Enhanced_Expansion_Board_configureGPIO(7, 2, 0)) initFsm++;
+      if (Nextion_Enhanced_Expansion_Board_configureGPIOMask(&lcd, 0xFF, 2, 0)) initFsm++;
       break;
 #endif
 
       //Wyswietlaj przez 3 sekundy strone startowa
-    case 11:
+    case 4:
       if (cntTickInitPage >= 3 * PERIOD_1S)
 	{
 	  cntTickInitPage = 0;
@@ -178,12 +456,12 @@ static void initPage(void)
 	}
       break;
 
-    case 12:
+    case 5:
       //Sprawdz czy wykryto wyciek wodoru
       if (RS485_RX_VERIFIED_DATA.h2SensorDigitalPin == 1)
 	{
 	  //Wyciek wodoru wykryty, przejdz do strony LEAK_PAGE
-	  if (Nextion_Enhanced_NX3224K028_loadNewPage(3))
+	  if (Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 3))
 	    {
 	      mainStepFsm = LEAK_PAGE;
 	      initCplt = 1;
@@ -196,7 +474,7 @@ static void initPage(void)
       if (RS485_RX_VERIFIED_DATA.emergencyButton == 1)
 	{
 	  //Przycisk bezpieczenstwa jest wcisniety, przejdz do strony EM_PAGE
-	  if (Nextion_Enhanced_NX3224K028_loadNewPage(4))
+	  if (Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 4))
 	    {
 	      mainStepFsm = EM_PAGE;
 	      initCplt = 1;
@@ -206,7 +484,7 @@ static void initPage(void)
 	}
 
       // Nie spelniono zadnej z powyzszych opcji, przejdz do domyslnego MODE1_PAGE
-      if (Nextion_Enhanced_NX3224K028_loadNewPage(1))
+      if (Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1))
 	{
 	  mainStepFsm = MODE1_PAGE;
 	  initCplt = 1;
@@ -225,118 +503,344 @@ static void initPage(void)
 */
 static void mode1Page(void)
 {
+  //Do czasu potwierdzenia zaladowania strony kontrolki moga jeszcze nie istniec, nie wysylaj nic
+  if (!pageReady)
+    {
+      if (!Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 1)) return;
+
+      //Pierwsze odswiezenie po potwierdzeniu jest pelne (pamiec podreczna wyczyszczona przy zmianie strony), kolejne przyrostowe
+      pageReady = 1;
+      cntTickMode1Page = 5 * PERIOD_1MS - 1;		//Odswiez w tym samym kroku
+      cntTickMode1LowVal = 0;
+      mode1FsmLowVal = MODE1_HIGH_VAL_CNT;
+#if USE_TREND_CHART == 1
+      trendFullRefresh = (1 << TREND_CH_CNT) - 1;	//Zaladowanie strony czysci wykres, wyslij cala zapamietana historie
+#endif
+    }
+
   cntTickMode1Page++;
 
   //Sprawdz czy czas miedzy aktualizacjami minal
   if (cntTickMode1Page >= 5 * PERIOD_1MS)
     {
       cntTickMode1Page = 0;
+      cntTickMode1LowVal++;
+
+      //Wartosci nie wymagajace tak czestego odswiezania aktualizuj co 50ms
+      if (cntTickMode1LowVal >= 10)
+	{
+	  cntTickMode1LowVal = 0;
+	  mode1FsmLowVal = MODE1_HIGH_VAL_CNT;
+	}
+
+      //Wszystkie zmiany z jednego odswiezenia sa rysowane przez wyswietlacz jednoczesnie
+      if (!Nextion_Enhanced_NX3224K028_beginFrame(&lcd)) return;
 
       //Wyswietlaj w pierwszej kolejnosci wartosci krytyczne (m.in paski postepu wymagajace czestego odswiezania)
-      switch (mode1FsmHighVal)
+      for (mode1FsmHighVal = 0; mode1FsmHighVal < MODE1_HIGH_VAL_CNT; mode1FsmHighVal++)
+	{
+	  if (!updateMode1Value(mode1FsmHighVal)) break;	//Paczka DMA jest pelna
+	}
+
+      //Dopisz do paczki tyle wartosci ile sie zmiesci, pozostale zostana wyslane przy kolejnym odswiezeniu
+      if (mode1FsmHighVal >= MODE1_HIGH_VAL_CNT)
+	{
+	  for (; mode1FsmLowVal < MODE1_VAL_CNT; mode1FsmLowVal++)
+	    {
+	      if (!updateMode1Value(mode1FsmLowVal)) break;
+	    }
+	}
+
+      Nextion_Enhanced_NX3224K028_endFrame(&lcd);
+
+#if USE_TREND_CHART == 1
+      //Komenda addt zamyka paczke, wysylana jest po wszystkich wartosciach
+      trendSend();
+#endif
+    }
+}
+
+#if USE_TREND_CHART == 1
+/**
+* @fn trendSample(void)
+* @brief Zbieranie probek mocy i predkosci, co LCD_TREND_DECIMATION zapisywana jest ich srednia jako punkt wykresu
+*/
+static void trendSample(void)
+{
+  trendPowerSum += RS485_RX_VERIFIED_DATA.TOTAL_POWER.value;
+  trendSpeedSum += RS485_RX_VERIFIED_DATA.interimSpeed;
+
+  if (++cntTickTrend < LCD_TREND_DECIMATION) return;
+
+  float power = trendPowerSum * LCD_TREND_HEIGHT / (LCD_TREND_POWER_MAX * (float)LCD_TREND_DECIMATION);
+  uint32_t speed = trendSpeedSum * LCD_TREND_HEIGHT / (LCD_TREND_SPEED_MAX * LCD_TREND_DECIMATION);
+
+  trendRing[TREND_POWER][trendHead & LCD_TREND_RING_MASK] = (power <= 0.0f) ? 0 : (power >= LCD_TREND_HEIGHT) ? LCD_TREND_HEIGHT : (uint8_t)power;
+  trendRing[TREND_SPEED][trendHead & LCD_TREND_RING_MASK] = (speed >= LCD_TREND_HEIGHT) ? LCD_TREND_HEIGHT : (uint8_t)speed;
+  trendHead++;
+  if (trendCnt < LCD_TREND_RING_SIZE) trendCnt++;
+
+  //Najstarsze niewyslane punkty zostaly nadpisane
+  for (uint8_t ch = 0; ch < TREND_CH_CNT; ch++)
+    {
+      if ((uint8_t)(trendHead - trendSent[ch]) > trendCnt) trendSent[ch] = trendHead - trendCnt;
+    }
+
+  cntTickTrend = 0;
+  trendPowerSum = 0.0f;
+  trendSpeedSum = 0;
+}
+
+/**
+* @fn trendSend(void)
+* @brief Wysylanie niewyslanych punktow wykresu paczkami (jeden kanal na wymiane addt)
+*/
+static void trendSend(void)
+{
+  uint8_t ch = trendChannel;
+  uint8_t chMask = 1 << ch;
+
+  //Po zaladowaniu strony wysylana jest cala historia, pozniej tylko pelne paczki
+  if (trendFullRefresh & chMask) trendSent[ch] = trendHead - trendCnt;
+
+  uint8_t pending = trendHead - trendSent[ch];
+
+  if ( (pending == 0) || ( (pending < LCD_TREND_CHUNK) && !(trendFullRefresh & chMask) ) ) return;
+
+  uint8_t points[LCD_TREND_RING_SIZE];
+
+  for (uint8_t i = 0; i < pending; i++)
+    {
+      points[i] = trendRing[ch][(uint8_t)(trendSent[ch] + i) & LCD_TREND_RING_MASK];
+    }
+
+  if (!Nextion_Enhanced_NX3224K028_addTransparentData(&lcd, LCD_TREND_ID, ch, points, pending)) return;
+
+  trendSent[ch] += pending;
+  trendFullRefresh &= ~chMask;
+  trendChannel = (ch + 1) % TREND_CH_CNT;
+}
+#endif
+
+/**
+* @fn updateMode1Value(uint8_t item)
+* @brief Zapis wartosci na stronie MODE1_PAGE tylko jezeli zmienila sie od ostatniego zapisu, zwraca 0 jezeli komenda nie zmiescila sie w paczce
+*/
+static uint8_t updateMode1Value(uint8_t item)
+{
+  int32_t value = getMode1Value(item);
+  uint16_t itemMask = 1 << item;
+
+  //Wartosc na wyswietlaczu jest aktualna, nie wysylaj jej ponownie
+  if ( (mode1ValCacheValid & itemMask) && (mode1ValCache[item] == value) ) return 1;
+
+  if (!sendMode1Value(item, value)) return 0;
+
+  mode1ValCache[item] = value;
+  mode1ValCacheValid |= itemMask;
+
+  return 1;
+}
+
+/**
+* @fn getMode1Value(uint8_t item)
+* @brief Aktualna wartosc do wyswietlenia na stronie MODE1_PAGE
+*/
+static int32_t getMode1Value(uint8_t item)
+{
+  switch (item)
+  {
+    //Pasek jest aktualizowany z estymaty, w procentach, dzieki czemu porusza sie plynnie takze pomiedzy ramkami telemetrii
+    case MODE1_SPEED_BAR:
       {
+	int32_t percent = (int32_t)(speed_estimator_getSpeed(HAL_GetTick()) * 100.0f / LCD_SPEED_BAR_MAX);
 
-	  //Pasek postepu predkosc chwilowa
-	case 0:
-	  if (Nextion_Enhanced_NX3224K028_writeValueToProgressBar((const uint8_t*) "SB", RS485_RX_VERIFIED_DATA.interimSpeed, 50)) mode1FsmHighVal++;
-	  break;
+	return (percent > 100) ? 100 : percent;
+      }
 
-	  //Czas okrazenia (milisekundy)
-	case 1:
-	  if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "ms", RS485_RX_VERIFIED_DATA.laptime_miliseconds.value))
-	    {
-#if USE_EXPANSION_BOARD == 1
-	      mode1FsmHighVal++;
+#if USE_NEXTION_SCRIPTS == 1
+    //Czasy sa przesylane jako calkowita liczba milisekund, moc i zuzycie wodoru w setnych czesciach
+    case MODE1_SPEED_VAR:
+      return RS485_RX_VERIFIED_DATA.interimSpeed;
+
+    case MODE1_LAPTIME_VAR:
+      return (RS485_RX_VERIFIED_DATA.laptime_minutes.value * 60 + RS485_RX_VERIFIED_DATA.laptime_seconds) * 1000
+	  + RS485_RX_VERIFIED_DATA.laptime_miliseconds.value;
+
+    case MODE1_DELTA_VAR:
+      return (RS485_RX_VERIFIED_DATA.delta_laptime_minutes.value * 60 + RS485_RX_VERIFIED_DATA.delta_laptime_seconds) * 1000
+	  + RS485_RX_VERIFIED_DATA.delta_laptime_miliseconds.value;
+
+    case MODE1_POWER_VAR:
+      return (int32_t)(RS485_RX_VERIFIED_DATA.TOTAL_POWER.value * 100.0f);
+
+    case MODE1_HYDROGEN_VAR:
+      return (int32_t)(RS485_RX_VERIFIED_DATA.hydrogen_usage.value * 100.0f);
 #else
-	      mode1FsmHighVal = 9;
+    case MODE1_LAPTIME_MS:
+      return RS485_RX_VERIFIED_DATA.laptime_miliseconds.value;
+
+    case MODE1_DELTA_MS:
+      return RS485_RX_VERIFIED_DATA.delta_laptime_miliseconds.value;
+
+    case MODE1_SPEED:
+      return RS485_RX_VERIFIED_DATA.interimSpeed;
+
+    case MODE1_LAPTIME_MIN:
+      return RS485_RX_VERIFIED_DATA.laptime_minutes.value;
+
+    case MODE1_DELTA_MIN:
+      return RS485_RX_VERIFIED_DATA.delta_laptime_minutes.value;
+
+    case MODE1_LAPTIME_SEC:
+      return RS485_RX_VERIFIED_DATA.laptime_seconds;
+
+    case MODE1_DELTA_SEC:
+      return RS485_RX_VERIFIED_DATA.delta_laptime_seconds;
+
+    case MODE1_TOTAL_POWER:
+      return (uint8_t)RS485_RX_VERIFIED_DATA.TOTAL_POWER.value;
+
+    case MODE1_HYDROGEN_USAGE:
+      return (uint8_t)RS485_RX_VERIFIED_DATA.hydrogen_usage.value;
 #endif
-	    }
-	  break;
-	  //delta okrazenia(milisekundy)
-	case 2:
-		if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "msd", RS485_RX_VERIFIED_DATA.delta_laptime_miliseconds.value))
-		{
-			mode1FsmHighVal++;
-		}
-		break;
 
 #if USE_EXPANSION_BOARD == 1
-	    case 3:
-	      if (BUTTONS.speedReset == 1)
-		{
-		  if (Nextion_Enhanced_Expansion_Board_pinState(7, 1)) mode1FsmHighVal++;
-		}
-	      else
-		{
-		  if (Nextion_Enhanced_Expansion_Board_pinState(7, 0)) mode1FsmHighVal++;
-		}
-	      break;
+    case MODE1_SPEED_RESET_PIN:
+      return (buttonsShown & BUTTONS_SPEED_RESET) != 0;
 #endif
 
-	  //Wyswietlaj wartosci nie wymagajace tak czestego odswiezania
-	case 4:
-	  mode1FsmHighVal = 0;
+    case MODE1_PADDLE_STATE:
+      return ( (paddle_mode == PADDLE_MODE_CALIBRATION) || (paddle_mode == PADDLE_MODE_FAULT) ) ? paddle_mode : 0;
 
-	  switch (mode1FsmLowVal)
-	    {
+    case MODE1_BORDER:
+      return (buttonsShown & BUTTONS_SUPPLY) != 0;
 
-	      //Predkosc chwilowa
-	    case 1:
-	      if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "V", RS485_RX_VERIFIED_DATA.interimSpeed)) mode1FsmLowVal++;
-	      break;
+    default:
+      return 0;
+  }
+}
 
-	      //Czas okrazenia (minuty)
-	    case 2:
-	      if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "mi", RS485_RX_VERIFIED_DATA.laptime_minutes.value))mode1FsmLowVal++;
-	      break;
+/**
+* @fn speedSample(void)
+* @brief Przekazanie kazdej nowej ramki telemetrii do estymatora predkosci
+*/
+static void speedSample(void)
+{
+  static uint32_t lastFrameCnt;
 
-	      //Delta okrazenia (minuty)
-	    case 3:
-	    	if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "mid", RS485_RX_VERIFIED_DATA.delta_laptime_minutes.value))mode1FsmLowVal++;
-	    	break;
+  if (rs485_flt != RS485_FLT_NONE)
+    {
+      //Transmisja zerwana - pasek wraca do zera razem z wyzerowanymi danymi
+      speed_estimator_reset();
+    }
+  else if (rs485_rxFrameCnt != lastFrameCnt)
+    {
+      speed_estimator_addSample(RS485_RX_VERIFIED_DATA.interimSpeed, rs485_rxFrameTick);
+    }
 
-	      //Czas okrazenia (sekundy)
-	    case 4:
-	      if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "sec", RS485_RX_VERIFIED_DATA.laptime_seconds)) mode1FsmLowVal++;
-	      break;
+  lastFrameCnt = rs485_rxFrameCnt;
+}
 
-	      //Delta okrazenia (sekundy)
-	    case 5:
-	      if (Nextion_Enhanced_NX3224K028_writeNumberToControl((const uint8_t*) "secd", RS485_RX_VERIFIED_DATA.delta_laptime_seconds)) mode1FsmLowVal++;
-	      break;
+/**
+* @fn sendMode1Value(uint8_t item, int32_t value)
+* @brief Zapis wartosci na stronie MODE1_PAGE, zwraca 0 jezeli komenda nie zmiescila sie w paczce
+*/
+static uint8_t sendMode1Value(uint8_t item, int32_t value)
+{
+  switch (item)
+  {
+    //Pasek postepu predkosc chwilowa
+    case MODE1_SPEED_BAR:
+      return Nextion_Enhanced_NX3224K028_writeValueToProgressBar(&lcd, (const uint8_t*) "SB", value, 100);
+
+#if USE_NEXTION_SCRIPTS == 1
+    //Predkosc chwilowa (skrypt HMI aktualizuje pole V)
+    case MODE1_SPEED_VAR:
+      return Nextion_Enhanced_NX3224K028_writeNumberToVariable(&lcd, (const uint8_t*) "sp", value);
+
+    //Czas okrazenia [ms] (skrypt HMI rozdziela go na mi, sec, ms)
+    case MODE1_LAPTIME_VAR:
+      return Nextion_Enhanced_NX3224K028_writeNumberToVariable(&lcd, (const uint8_t*) "lt", value);
+
+    //Delta okrazenia [ms] (skrypt HMI rozdziela ja na mid, secd, msd)
+    case MODE1_DELTA_VAR:
+      return Nextion_Enhanced_NX3224K028_writeNumberToVariable(&lcd, (const uint8_t*) "dt", value);
+
+    //Moc calkowita [0,01]
+    case MODE1_POWER_VAR:
+      return Nextion_Enhanced_NX3224K028_writeNumberToVariable(&lcd, (const uint8_t*) "pw", value);
+
+    //Zuzycie wodoru [0,01]
+    case MODE1_HYDROGEN_VAR:
+      return Nextion_Enhanced_NX3224K028_writeNumberToVariable(&lcd, (const uint8_t*) "hu", value);
+#else
+    //Czas okrazenia (milisekundy)
+    case MODE1_LAPTIME_MS:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "ms", value);
 
-	      //Moc calkowita
-	    case 6:
-	    	if (Nextion_Enhanced_NX3224K028_writeFltToControl((const uint8_t*) "TP", RS485_RX_VERIFIED_DATA.TOTAL_POWER.value)) mode1FsmLowVal++;
-	    	break;
-
-	    	//zuzycie wodoru
-	    case 7:
-	    	if (Nextion_Enhanced_NX3224K028_writeFltToControl((const uint8_t*) "hydusg", RS485_RX_VERIFIED_DATA.hydrogen_usage.value)) mode1FsmLowVal++;
-	    	break;
-
-	      //Sygnalizuj stan przycisku SUPPLY_BUTTON w postaci kolorowej obwodki na wokol ekranu (jezeli czerwona - zasilanie jest wylaczone)
-	    case 8:
-	      if (BUTTONS.powerSupply == 1)
-		{
-		  if (Nextion_Enhanced_NX3224K028_drawRectangle(0, 0, 320, 240, (const uint8_t*) "GRAY")) mode1FsmLowVal++;
-		}
-	      else
-		{
-		  if (Nextion_Enhanced_NX3224K028_drawRectangle(0, 0, 320, 240, (const uint8_t*) "RED")) mode1FsmLowVal++;
-		}
-	      break;
+    //Delta okrazenia (milisekundy)
+    case MODE1_DELTA_MS:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "msd", value);
 
-	    default:
-	      break;
+    //Predkosc chwilowa
+    case MODE1_SPEED:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "V", value);
 
-	  break;
-	    }
+    //Czas okrazenia (minuty)
+    case MODE1_LAPTIME_MIN:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "mi", value);
 
-	default:
-	  break;
+    //Delta okrazenia (minuty)
+    case MODE1_DELTA_MIN:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "mid", value);
+
+    //Czas okrazenia (sekundy)
+    case MODE1_LAPTIME_SEC:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "sec", value);
+
+    //Delta okrazenia (sekundy)
+    case MODE1_DELTA_SEC:
+      return Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*) "secd", value);
+
+    //Moc calkowita
+    case MODE1_TOTAL_POWER:
+      return Nextion_Enhanced_NX3224K028_writeFltToControl(&lcd, (const uint8_t*) "TP", value);
+
+    //Zuzycie wodoru
+    case MODE1_HYDROGEN_USAGE:
+      return Nextion_Enhanced_NX3224K028_writeFltToControl(&lcd, (const uint8_t*) "hydusg", value);
+#endif
+
+#if USE_EXPANSION_BOARD == 1
+    case MODE1_SPEED_RESET_PIN:
+      return Nextion_Enhanced_Expansion_Board_pinState(&lcd, LCD_LEAK_BUZZER_IO, value);
+#endif
+
+    //Kalibracja lub blad manetki gazu (paddle_value = 0), pole puste w normalnej pracy
+    case MODE1_PADDLE_STATE:
+      if (value == PADDLE_MODE_CALIBRATION)
+	{
+	  return Nextion_Enhanced_NX3224K028_writeTxtToControl(&lcd, (const uint8_t*) "pd", (const uint8_t*) "CAL");
 	}
-    }
+      if (value == PADDLE_MODE_FAULT)
+	{
+	  return Nextion_Enhanced_NX3224K028_writeTxtToControl(&lcd, (const uint8_t*) "pd", (const uint8_t*) "FAULT");
+	}
+      return Nextion_Enhanced_NX3224K028_writeTxtToControl(&lcd, (const uint8_t*) "pd", (const uint8_t*) "");
+
+    //Sygnalizuj stan przycisku SUPPLY_BUTTON w postaci kolorowej obwodki na wokol ekranu (jezeli czerwona - zasilanie jest wylaczone)
+    //Obwodka jest rysowana ponownie tylko przy zmianie stanu przycisku
+    case MODE1_BORDER:
+      if (value == 1)
+	{
+	  return Nextion_Enhanced_NX3224K028_drawRectangle(&lcd, 0, 0, 320, 240, (const uint8_t*) "GRAY");
+	}
+      return Nextion_Enhanced_NX3224K028_drawRectangle(&lcd, 0, 0, 320, 240, (const uint8_t*) "RED");
+
+    default:
+      return 1;
+  }
 }
 
 #if USE_EXPANSION_BOARD == 1
@@ -346,16 +850,10 @@ static void mode1Page(void)
 */
 static void leakPage(void)
 {
-  cntTickLeakPage++;
-
-  if ( (cntTickLeakPage >= 100 * PERIOD_1MS) && (cntTickLeakPage < 150 * PERIOD_1MS) )
+  //Wzorzec jest odtwarzany przez sekwencer, zatrzymuje go resetAllCntAndFsmState() przy zmianie strony
+  if (leakBuzzer.pattern == NULL)
     {
-      Nextion_Enhanced_Expansion_Board_pinState(7, 1);
-    }
-  else if (cntTickLeakPage >= 150 * PERIOD_1MS)
-    {
-      Nextion_Enhanced_Expansion_Board_pinState(7, 0);
-      cntTickLeakPage = 0;
+      Nextion_Enhanced_Expansion_Board_sequencerStart(&leakBuzzer, LCD_LEAK_BUZZER_IO, &leakBuzzerPattern);
     }
 }
 #endif
@@ -366,19 +864,30 @@ static void leakPage(void)
 */
 static uint8_t emPage(void)
 {
+  if (!pageReady)
+    {
+      if (!Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 4)) return 0;
+
+      pageReady = 1;
+    }
+
   cntTickEmPage++;
 
   if ( (cntTickEmPage >= PERIOD_1S) && (cntTickEmPage < 2 * PERIOD_1S) )
     {
-      Nextion_Enhanced_NX3224K028_writeValueToProgressBar((const uint8_t *)"em_button", 100, 100);
+      //Komenda jest wysylana tylko raz na okres (ponawiana jezeli paczka DMA byla pelna)
+      if (!emButtonSet) emButtonSet = Nextion_Enhanced_NX3224K028_writeValueToProgressBar(&lcd, (const uint8_t *)"em_button", 100, 100);
 
       return 0;
     }
   else if (cntTickEmPage >= 2 * PERIOD_1S)
     {
-      Nextion_Enhanced_NX3224K028_writeValueToProgressBar((const uint8_t *)"em_button", 0, 100);
-      cntTickEmPage = 0;
-      return 1;
+      if (Nextion_Enhanced_NX3224K028_writeValueToProgressBar(&lcd, (const uint8_t *)"em_button", 0, 100))
+	{
+	  emButtonSet = 0;
+	  cntTickEmPage = 0;
+	  return 1;
+	}
     }
 
   return 0;
@@ -390,11 +899,12 @@ static uint8_t emPage(void)
 */
 static uint8_t choosePage(void)
 {
-  //Sprawdz czy wykryto wyciek wodoru
+  //Sprawdz czy wykryto wyciek wodoru (strona bezpieczenstwa wysylana z pominieciem kolejki, stan zmieniany dopiero po jej zleceniu)
   if ( (RS485_RX_VERIFIED_DATA.h2SensorDigitalPin == 1) && mainStepFsm != LEAK_PAGE )
     {
+      if (!Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 3)) return 0;
+
       resetAllCntAndFsmState();
-      Nextion_Enhanced_NX3224K028_loadNewPage(3);
       mainStepFsm = LEAK_PAGE;
 
       return 1;
@@ -403,8 +913,9 @@ static uint8_t choosePage(void)
   else if ( (RS485_RX_VERIFIED_DATA.h2SensorDigitalPin != 1) && (RS485_RX_VERIFIED_DATA.emergencyButton != 1)
       && mainStepFsm == LEAK_PAGE )
     {
+      if (!Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1)) return 0;
+
       resetAllCntAndFsmState();
-      Nextion_Enhanced_NX3224K028_loadNewPage(1);
       mainStepFsm = MODE1_PAGE;
 
       return 1;
@@ -412,8 +923,9 @@ static uint8_t choosePage(void)
   //Jezeli nie wykryto wycieku wodoru a przycisk bezpieczenstwa jest wcisniety
   else if ( (RS485_RX_VERIFIED_DATA.emergencyButton == 1) &&  (RS485_RX_VERIFIED_DATA.h2SensorDigitalPin == 0) && mainStepFsm != EM_PAGE  )
     {
+      if (!Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 4)) return 0;
+
       resetAllCntAndFsmState();
-      Nextion_Enhanced_NX3224K028_loadNewPage(4);
       mainStepFsm = EM_PAGE;
 
       return 1;
@@ -421,38 +933,40 @@ static uint8_t choosePage(void)
   else if ( (RS485_RX_VERIFIED_DATA.emergencyButton != 1) && (RS485_RX_VERIFIED_DATA.h2SensorDigitalPin != 1)
       && mainStepFsm == EM_PAGE  && mainStepFsm != LEAK_PAGE)
     {
+      if (!Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1)) return 0;
+
       resetAllCntAndFsmState();
-      Nextion_Enhanced_NX3224K028_loadNewPage(1);
       mainStepFsm = MODE1_PAGE;
 
       return 1;
     }
-  //Sprawdz czy przycisk mode1 jest wcisniety
-  else if ( (BUTTONS.mode1 == 1) && (BUTTONS.mode2 == 0) && (mainStepFsm != MODE1_PAGE) &&
+  //Sprawdz czy wcisnieto przycisk mode1
+  else if ( mode1Request && (mainStepFsm != MODE1_PAGE) &&
       (RS485_RX_VERIFIED_DATA.h2SensorDigitalPin != 1) && (RS485_RX_VERIFIED_DATA.emergencyButton != 1) )
     {
+      //Zadanie pozostaje aktywne do czasu zlecenia zmiany strony
+      if (!Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1)) return 0;
+
+      mode1Request = 0;
       resetAllCntAndFsmState();
-      Nextion_Enhanced_NX3224K028_loadNewPage(1);
       mainStepFsm = MODE1_PAGE;
 
       return 1;
     }
-  //Sprawdz czy przyciski mode1 oraz mode2 sa wcisniete jednoczesne
-  else if ((BUTTONS.mode1 == 1) && (BUTTONS.mode2 == 1))
+  //Sprawdz czy przyciski mode1 oraz mode2 przytrzymano jednoczesnie przez LCD_REINIT_HOLD_MS
+  else if (reinitRequest)
     {
-      cntTickDevReset++;
-
-      //Odczekaj 5 sekund, nastepnie ponownie zainicjalizuj wyswietlacz
-      if (cntTickDevReset >= 5 * PERIOD_1S)
-	{
-	  resetAllCntAndFsmState();
-	  initCplt = 0;
-	  mainStepFsm = INIT_PAGE;
+      reinitRequest = 0;
+      resetAllCntAndFsmState();
+      initCplt = 0;
+      mainStepFsm = INIT_PAGE;
 
-	  return 1;
-	}
+      return 1;
     }
 
+  //Wcisniecie mode1 na stronie MODE1 lub w trakcie alarmu nie zmienia strony
+  mode1Request = 0;
+
   return 0;
 }
 
@@ -464,15 +978,17 @@ static void resetAllCntAndFsmState(void)
 {
   cntTickInitPage = 0;
   cntTickMode1Page = 0;
-  cntTickMode2Page = 0;
+  cntTickLink = 0;
+  cntTickMode1LowVal = 0;
   cntTickEmPage = 0;
 #if USE_EXPANSION_BOARD == 1
-  cntTickLeakPage = 0;
+  Nextion_Enhanced_Expansion_Board_sequencerStop(&leakBuzzer);
 #endif
-  cntTickDevReset = 0;
 
   initFsm = 0;
-  mode1FsmLowVal = 0;
+  mode1FsmLowVal = MODE1_HIGH_VAL_CNT;
   mode1FsmHighVal = 0;
-  mode2Fsm = 0;
+  mode1ValCacheValid = 0;
+  emButtonSet = 0;
+  pageReady = 0;
 }
@@ -14,4 +14,12 @@
 
 // ******************************************************************************************************************************************************** //
 
+extern void lcd_control_init(void);
 extern void lcd_control_step(void);
+
+// ******************************************************************************************************************************************************** //
+
+extern uint32_t lcd_control_maxEventLatency;		///< Najdluzszy zanotowany czas od odebrania zdarzenia z LCD do reakcji [ms]
+extern uint32_t lcd_control_staleEventsCnt;		///< Liczba zdarzen odrzuconych z powodu przekroczenia dopuszczalnego opoznienia
+extern uint32_t lcd_control_linkLostCnt;		///< Liczba ponownych inicjalizacji LCD z powodu utraty polaczenia
+extern uint32_t lcd_control_connectFailCnt;		///< Liczba nieudanych prob wykrycia predkosci transmisji LCD
@@ -31,7 +31,7 @@ typedef enum
 
 /**
 * @fn leds_step(void)
-* @brief Obsluga diody LED_STS, wywolac wewnatrz hydrogreen_step1kHz()
+* @brief Obsluga diody LED_STS, zadanie planisty wykonywane co 1ms (tabela tasks[] w hydrogreen.c)
 */
 void leds_step(void)
 {
@@ -0,0 +1,392 @@
+/**
+* @file paddle.c
+* @brief Analogowa manetka gazu na PA5 (ADC2_IN2): pomiar wyzwalany przez TIM6, DMA do bufora kolowego, usrednianie, filtr IIR, kalibracja
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include "paddle.h"
+
+#ifndef PADDLE_HOST
+#include "main.h"
+#include "timers.h"
+#include "buttons.h"
+#include "gestures.h"
+#include "rs485.h"
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+#ifndef PADDLE_HOST
+#define PADDLE_ADC			ADC2
+#define PADDLE_ADC_CHANNEL		2			///< PA5 = ADC2_IN2
+#define PADDLE_ADC_SAMPLE_TIME		7			///< 601,5 cykli zegara ADC (18,8us przy 32MHz), duza impedancja potencjometru
+#define PADDLE_ADC_EXTSEL_TIM6_TRGO	13			///< EXT13 w tabeli wyzwalaczy grupy regularnej ADC1/ADC2
+#define PADDLE_DMA_CHANNEL		DMA1_Channel2		///< ADC2 po przemapowaniu SYSCFG_CFGR3_ADC2_DMA_RMP = 10
+#define PADDLE_INIT_TIMEOUT_US		1000			///< Maksymalny czas oczekiwania na kalibracje i gotowosc ADC [us]
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+volatile uint8_t paddle_value;
+PADDLE_MODE paddle_mode;
+PADDLE_CALIBRATION paddle_calibration;
+uint16_t paddle_raw;
+uint16_t paddle_filtered;
+uint32_t paddle_faultCnt;
+
+static int32_t filterQ8;			///< Stan filtru IIR (zakres 16-bit, 8 bitow czesci ulamkowej)
+static uint8_t filterReady;			///< 0 - filtr zostanie ustawiony na pierwszy pomiar zamiast narastac od zera
+static uint8_t faultSteps;			///< Liczba kolejnych pomiarow poza zakresem kalibracji
+static uint8_t releaseSteps;			///< Liczba kolejnych pomiarow zwolnionej manetki w PADDLE_MODE_WAIT_RELEASE
+static uint16_t calMin;				///< Skrajne pomiary zebrane w trakcie kalibracji
+static uint16_t calMax;
+static uint8_t calArmed;			///< 1 - MODE_2 wcisniety sam, zwolnienie po PADDLE_CAL_HOLD_MS przelacza kalibracje
+static uint8_t stopped;				///< 1 - pojazd stoi, kalibracja moze zostac rozpoczeta
+
+#ifndef PADDLE_HOST
+static volatile uint16_t adcWindow[PADDLE_WINDOW];	///< Bufor kolowy zapisywany przez DMA
+static GESTURES_SUBSCRIBER gestures;			///< Wcisniecia i zwolnienia przyciskow (kalibracja)
+static uint8_t adcReady;				///< 0 - ADC nie zostal uruchomiony, paddle_mode pozostaje PADDLE_MODE_FAULT
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+static uint8_t quantise(uint16_t filtered);
+
+#ifndef PADDLE_HOST
+static uint8_t waitFor(volatile uint32_t *reg, uint32_t mask, uint32_t value);
+static void handleGestures(void);
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+#ifndef PADDLE_HOST
+/**
+* @fn paddle_init(void)
+* @brief Inicjalizacja ADC2 i DMA, wywolac po timers_init() (TIM6 wyzwala pomiary) i przed scheduler_init()
+*/
+void paddle_init(void)
+{
+  paddle_reset();
+  gestures_subscribe(&gestures, BUTTONS_ALL_MASK, GESTURE_TYPE_MASK(GESTURE_PRESS) | GESTURE_TYPE_MASK(GESTURE_RELEASE));
+
+  //DMA: bufor kolowy, bez przerwan, kazdy pomiar trafia do kolejnego elementu adcWindow[]
+  SYSCFG->CFGR3 = (SYSCFG->CFGR3 & ~SYSCFG_CFGR3_ADC2_DMA_RMP) | SYSCFG_CFGR3_ADC2_DMA_RMP_1;
+  PADDLE_DMA_CHANNEL->CCR = 0;
+  PADDLE_DMA_CHANNEL->CPAR = (uint32_t)&PADDLE_ADC->DR;
+  PADDLE_DMA_CHANNEL->CMAR = (uint32_t)adcWindow;
+  PADDLE_DMA_CHANNEL->CNDTR = PADDLE_WINDOW;
+  PADDLE_DMA_CHANNEL->CCR = DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_0 | DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_EN;
+
+  //Zegar ADC synchroniczny HCLK/2 = 32MHz
+  __HAL_RCC_ADC12_CLK_ENABLE();
+  ADC12_COMMON->CCR = (ADC12_COMMON->CCR & ~ADC_CCR_CKMODE) | ADC_CCR_CKMODE_1;
+
+  //Wlaczenie regulatora napiecia (10 -> 00 -> 01), czas stabilizacji 10us
+  PADDLE_ADC->CR &= ~ADC_CR_ADVREGEN;
+  PADDLE_ADC->CR |= ADC_CR_ADVREGEN_0;
+  uint64_t startUs = timers_getUs();
+  while ( (timers_getUs() - startUs) < 10 );
+
+  //Kalibracja dla pomiaru niesymetrycznego
+  PADDLE_ADC->CR &= ~ADC_CR_ADCALDIF;
+  PADDLE_ADC->CR |= ADC_CR_ADCAL;
+
+  if (!waitFor(&PADDLE_ADC->CR, ADC_CR_ADCAL, 0))
+    {
+      paddle_mode = PADDLE_MODE_FAULT;
+      return;
+    }
+
+  PADDLE_ADC->ISR = ADC_ISR_ADRDY;
+  PADDLE_ADC->CR |= ADC_CR_ADEN;
+
+  if (!waitFor(&PADDLE_ADC->ISR, ADC_ISR_ADRDY, ADC_ISR_ADRDY))
+    {
+      paddle_mode = PADDLE_MODE_FAULT;
+      return;
+    }
+
+  //Jeden kanal, pomiar na zbocze narastajace TIM6 TRGO, DMA w trybie kolowym, przepelnienie nadpisuje DR
+  PADDLE_ADC->SMPR1 = PADDLE_ADC_SAMPLE_TIME << ADC_SMPR1_SMP2_Pos;
+  PADDLE_ADC->SQR1 = PADDLE_ADC_CHANNEL << ADC_SQR1_SQ1_Pos;
+  PADDLE_ADC->CFGR = ADC_CFGR_DMAEN | ADC_CFGR_DMACFG | ADC_CFGR_OVRMOD | ADC_CFGR_EXTEN_0
+      | (PADDLE_ADC_EXTSEL_TIM6_TRGO << ADC_CFGR_EXTSEL_Pos);
+  PADDLE_ADC->CR |= ADC_CR_ADSTART;
+  adcReady = 1;
+}
+
+/**
+* @fn paddle_step(void)
+* @brief Przetworzenie bufora DMA, wywolywane co 1ms
+*/
+void paddle_step(void)
+{
+  if (!adcReady)
+    {
+      return;
+    }
+
+  paddle_setStopped( (rs485_flt == RS485_FLT_NONE) && (RS485_RX_VERIFIED_DATA.interimSpeed == 0) );
+  handleGestures();
+  paddle_process(adcWindow);
+}
+#endif
+
+/**
+* @fn paddle_reset(void)
+* @brief Przywrocenie kalibracji domyslnej i wyzerowanie filtru
+*/
+void paddle_reset(void)
+{
+  paddle_calibration.rawMin = PADDLE_DEFAULT_RAW_MIN;
+  paddle_calibration.rawMax = PADDLE_DEFAULT_RAW_MAX;
+  paddle_mode = PADDLE_MODE_WAIT_RELEASE;
+  paddle_value = 0;
+  paddle_faultCnt = 0;
+  filterReady = 0;
+  faultSteps = 0;
+  releaseSteps = 0;
+  calArmed = 0;
+  stopped = 0;
+}
+
+/**
+* @fn paddle_process(const volatile uint16_t *window)
+* @brief Usrednienie PADDLE_WINDOW ostatnich pomiarow, filtracja i aktualizacja paddle_value
+* @details DMA zapisuje bufor w trakcie sumowania, suma obejmuje wtedy kolejne pomiary zamiast najstarszych, co nie zmienia dlugosci okna.
+*/
+void paddle_process(const volatile uint16_t *window)
+{
+  uint32_t sum = 0;
+
+  for (uint8_t i = 0; i < PADDLE_WINDOW; i++)
+    {
+      sum += window[i];
+    }
+
+  paddle_raw = sum >> PADDLE_SUM_SHIFT;
+
+  if (!filterReady)
+    {
+      filterQ8 = (int32_t)paddle_raw << 8;
+      filterReady = 1;
+    }
+  else
+    {
+      filterQ8 += (((int32_t)paddle_raw << 8) - filterQ8) >> PADDLE_IIR_SHIFT;
+    }
+
+  paddle_filtered = filterQ8 >> 8;
+
+  if (paddle_mode == PADDLE_MODE_CALIBRATION)
+    {
+      if (paddle_filtered < calMin) calMin = paddle_filtered;
+      if (paddle_filtered > calMax) calMax = paddle_filtered;
+      return;
+    }
+
+  //Blad czujnika na podstawie sredniej bez filtru IIR, aby przerwany przewod zostal wykryty jak najszybciej
+  uint8_t outOfRange = ( ((int32_t)paddle_raw < (int32_t)paddle_calibration.rawMin - PADDLE_FAULT_MARGIN)
+      || ((int32_t)paddle_raw > (int32_t)paddle_calibration.rawMax + PADDLE_FAULT_MARGIN) );
+
+  if (!outOfRange)
+    {
+      faultSteps = 0;
+    }
+  else if (faultSteps < PADDLE_FAULT_STEPS)
+    {
+      faultSteps++;
+    }
+
+  if ( (faultSteps >= PADDLE_FAULT_STEPS) && (paddle_mode != PADDLE_MODE_FAULT) )
+    {
+      paddle_mode = PADDLE_MODE_FAULT;
+      paddle_value = 0;
+      paddle_faultCnt++;
+    }
+
+  switch (paddle_mode)
+  {
+    case PADDLE_MODE_FAULT:
+      if (faultSteps == 0)
+	{
+	  paddle_mode = PADDLE_MODE_WAIT_RELEASE;
+	  releaseSteps = 0;
+	}
+      break;
+
+    //Pomiar narastajacy po naprawie przewodu przechodzi przez martwa strefe, dlatego zwolnienie musi trwac PADDLE_RELEASE_STEPS
+    case PADDLE_MODE_WAIT_RELEASE:
+      if ( !outOfRange && (quantise(paddle_filtered) == 0) ) releaseSteps++;
+      else releaseSteps = 0;
+
+      if (releaseSteps >= PADDLE_RELEASE_STEPS) paddle_mode = PADDLE_MODE_RUN;
+      break;
+
+    case PADDLE_MODE_RUN:
+      paddle_value = quantise(paddle_filtered);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+* @fn paddle_startCalibration(void)
+* @brief Rozpoczecie zbierania skrajnych pomiarow, do zakonczenia kalibracji paddle_value wynosi 0
+*/
+void paddle_startCalibration(void)
+{
+  paddle_mode = PADDLE_MODE_CALIBRATION;
+  paddle_value = 0;
+  calMin = UINT16_MAX;
+  calMax = 0;
+}
+
+/**
+* @fn paddle_finishCalibration(void)
+* @brief Zakonczenie kalibracji, zwraca 0 gdy zebrany zakres jest mniejszy od PADDLE_CAL_MIN_SPAN (obowiazuje poprzednia kalibracja)
+*/
+uint8_t paddle_finishCalibration(void)
+{
+  uint8_t ok = (paddle_mode == PADDLE_MODE_CALIBRATION) && (calMax > calMin) && ((calMax - calMin) >= PADDLE_CAL_MIN_SPAN);
+
+  if (ok)
+    {
+      paddle_calibration.rawMin = calMin;
+      paddle_calibration.rawMax = calMax;
+    }
+
+  paddle_mode = PADDLE_MODE_WAIT_RELEASE;
+  faultSteps = 0;
+  releaseSteps = 0;
+
+  return ok;
+}
+
+/**
+* @fn paddle_button(PADDLE_BUTTON button, uint16_t heldMs)
+* @brief Gest kalibracji: zwolnienie samego MODE_2 po co najmniej PADDLE_CAL_HOLD_MS (heldMs) rozpoczyna lub konczy kalibracje
+* @details Rozpoczecie wymaga postoju (paddle_setStopped()), zakonczenie jest mozliwe zawsze. Wcisniecie innego przycisku
+* w trakcie przytrzymania anuluje gest, dlatego kombinacja MODE_1 + MODE_2 rozpoczeta od MODE_2 nie zmienia kalibracji.
+*/
+void paddle_button(PADDLE_BUTTON button, uint16_t heldMs)
+{
+  switch (button)
+  {
+    case PADDLE_BUTTON_PRESS:
+      calArmed = 1;
+      break;
+
+    case PADDLE_BUTTON_OTHER:
+      calArmed = 0;
+      break;
+
+    case PADDLE_BUTTON_RELEASE:
+      if ( calArmed && (heldMs >= PADDLE_CAL_HOLD_MS) )
+	{
+	  if (paddle_mode == PADDLE_MODE_CALIBRATION) paddle_finishCalibration();
+	  else if (stopped) paddle_startCalibration();
+	}
+
+      calArmed = 0;
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+* @fn paddle_setStopped(uint8_t isStopped)
+* @brief Informacja o postoju pojazdu, ruszenie w trakcie kalibracji przerywa ja bez zmiany poprzedniej kalibracji
+*/
+void paddle_setStopped(uint8_t isStopped)
+{
+  stopped = isStopped;
+
+  if ( !stopped && (paddle_mode == PADDLE_MODE_CALIBRATION) )
+    {
+      paddle_mode = PADDLE_MODE_WAIT_RELEASE;
+      faultSteps = 0;
+      releaseSteps = 0;
+    }
+}
+
+/**
+* @fn quantise(uint16_t filtered)
+* @brief Przeliczenie pomiaru na 0 - PADDLE_VALUE_MAX, nowa wartosc przyjmowana jest dopiero po przekroczeniu histerezy
+*/
+static uint8_t quantise(uint16_t filtered)
+{
+  int32_t span = paddle_calibration.rawMax - paddle_calibration.rawMin;
+  int32_t low = paddle_calibration.rawMin + span * PADDLE_DEADBAND_LOW_PERMILLE / 1000;
+  int32_t high = paddle_calibration.rawMax - span * PADDLE_DEADBAND_HIGH_PERMILLE / 1000;
+
+  if (filtered <= low) return 0;
+  if (filtered >= high) return PADDLE_VALUE_MAX;
+
+  //Iloczyn miesci sie w 32 bitach bez znaku: (high - low) * (PADDLE_VALUE_MAX << 8) < 2^16 * 2^16
+  int32_t targetQ8 = ((uint32_t)(filtered - low) * (PADDLE_VALUE_MAX << 8)) / (uint32_t)(high - low);
+  int32_t currentQ8 = (int32_t)paddle_value << 8;
+  int32_t distance = (targetQ8 > currentQ8) ? (targetQ8 - currentQ8) : (currentQ8 - targetQ8);
+
+  if (distance < (128 + PADDLE_HYSTERESIS_Q8))
+    {
+      return paddle_value;
+    }
+
+  return (targetQ8 + 128) >> 8;
+}
+
+#ifndef PADDLE_HOST
+/**
+* @fn waitFor(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+* @brief Oczekiwanie na stan bitow rejestru ADC, zwraca 0 po przekroczeniu PADDLE_INIT_TIMEOUT_US
+*/
+static uint8_t waitFor(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+{
+  uint64_t startUs = timers_getUs();
+
+  while ((*reg & mask) != value)
+    {
+      if ((timers_getUs() - startUs) > PADDLE_INIT_TIMEOUT_US)
+	{
+	  return 0;
+	}
+    }
+
+  return 1;
+}
+
+/**
+* @fn handleGestures(void)
+* @brief Przekazanie wcisniec i zwolnien przyciskow do paddle_button()
+*/
+static void handleGestures(void)
+{
+  GESTURE_EVENT event;
+
+  while (gestures_get(&gestures, &event))
+    {
+      if (event.type == GESTURE_RELEASE)
+	{
+	  if (event.buttons == BUTTONS_MODE_2) paddle_button(PADDLE_BUTTON_RELEASE, event.durationMs);
+	}
+      else if ( (event.buttons == BUTTONS_MODE_2) && (event.state == BUTTONS_MODE_2) )
+	{
+	  paddle_button(PADDLE_BUTTON_PRESS, 0);
+	}
+      else
+	{
+	  paddle_button(PADDLE_BUTTON_OTHER, 0);
+	}
+    }
+}
+#endif
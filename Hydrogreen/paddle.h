@@ -0,0 +1,98 @@
+/**
+* @file paddle.h
+* @brief Analogowa manetka gazu na PA5 (ADC2_IN2): pomiar wyzwalany przez TIM6, DMA do bufora kolowego, usrednianie, filtr IIR, kalibracja
+* @details ADC2 wykonuje jeden pomiar na kazde przepelnienie TIM6 (TRGO, 10kHz), DMA1 kanal 2 zapisuje wyniki w buforze kolowym
+* PADDLE_WINDOW probek bez udzialu procesora. paddle_step() co 1ms sumuje caly bufor (nadprobkowanie, srednia z 6,4ms),
+* filtruje wynik filtrem IIR pierwszego rzedu i przelicza go na paddle_value (0 - PADDLE_VALUE_MAX) z histereza kwantyzacji.
+* Zwolnienie samego MODE_2 po przytrzymaniu przez co najmniej PADDLE_CAL_HOLD_MS rozpoczyna kalibracje (nalezy przejsc manetka pelen zakres),
+* kolejne takie zwolnienie ja konczy. Wcisniecie innego przycisku w trakcie przytrzymania (np. kombinacja MODE_1 + MODE_2) anuluje gest.
+* Kalibracja rozpoczyna sie tylko na postoju (predkosc 0 z ramki RS-485 przy poprawnej transmisji), ruszenie w trakcie kalibracji
+* ja przerywa i obowiazuje poprzednia. Stan kalibracji i bledu czujnika wyswietlany jest na stronie MODE1 (pole pd).
+* Kalibracja przechowywana jest w RAM, po resecie obowiazuja wartosci domyslne.
+* Po starcie, kalibracji i bledzie czujnika paddle_value wynosi 0 do czasu zwolnienia manetki.
+* Na plytce Nucleo-F303K8 PA5 jest polaczony z PB6 (SUPPLY_BUTTON) mostkiem SB16, ktory nalezy usunac.
+* Przetwarzanie (paddle_reset(), paddle_process(), kalibracja) kompiluje sie na komputerze z -DPADDLE_HOST (Tools/paddle_sim).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+#pragma once
+
+#include <stdint.h>
+
+// ******************************************************************************************************************************************************** //
+
+#define PADDLE_WINDOW			64			///< Liczba probek w buforze DMA (potega 2), 6,4ms przy 10kHz
+#define PADDLE_SUM_SHIFT		2			///< Suma 64 probek 12-bit przesunieta do zakresu 16-bit
+#define PADDLE_IIR_SHIFT		2			///< Wspolczynnik filtru IIR 1/2^n (stala czasowa ok. 4ms przy kroku 1ms)
+#define PADDLE_VALUE_MAX		255			///< Wartosc paddle_value przy pelnym wcisnieciu
+#define PADDLE_HYSTERESIS_Q8		64			///< Histereza kwantyzacji ponad pol LSB paddle_value [1/256 LSB]
+#define PADDLE_DEADBAND_LOW_PERMILLE	40			///< Martwa strefa przy zwolnionej manetce [promile zakresu kalibracji]
+#define PADDLE_DEADBAND_HIGH_PERMILLE	20			///< Nasycenie przy pelnym wcisnieciu [promile zakresu kalibracji]
+#define PADDLE_DEFAULT_RAW_MIN		6000			///< Domyslny pomiar przy zwolnionej manetce (zakres 16-bit)
+#define PADDLE_DEFAULT_RAW_MAX		58000			///< Domyslny pomiar przy pelnym wcisnieciu (zakres 16-bit)
+#define PADDLE_FAULT_MARGIN		2000			///< Odchylenie poza zakres kalibracji traktowane jako blad czujnika (zakres 16-bit)
+#define PADDLE_FAULT_STEPS		20			///< Liczba kolejnych pomiarow poza zakresem, po ktorej zglaszany jest blad [ms]
+#define PADDLE_RELEASE_STEPS		50			///< Czas zwolnienia manetki wymagany do zdjecia blokady paddle_value [ms]
+#define PADDLE_CAL_MIN_SPAN		16000			///< Minimalny zakres kalibracji, mniejszy jest odrzucany (zakres 16-bit)
+#define PADDLE_CAL_HOLD_MS		3000			///< Minimalny czas przytrzymania MODE_2 rozpoczynajacego i konczacego kalibracje [ms]
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @enum PADDLE_MODE
+* @brief Stan przetwarzania pomiaru manetki
+*/
+typedef enum
+{
+  PADDLE_MODE_WAIT_RELEASE,		///< paddle_value = 0 do czasu zwolnienia manetki
+  PADDLE_MODE_RUN,			///< paddle_value odpowiada polozeniu manetki
+  PADDLE_MODE_CALIBRATION,		///< Zbieranie skrajnych pomiarow, paddle_value = 0
+  PADDLE_MODE_FAULT			///< Pomiar poza zakresem kalibracji (np. przerwany przewod), paddle_value = 0
+} PADDLE_MODE;
+
+/**
+* @struct PADDLE_CALIBRATION
+* @brief Skrajne pomiary manetki po filtracji (zakres 16-bit)
+*/
+typedef struct
+{
+  uint16_t rawMin;			///< Manetka zwolniona
+  uint16_t rawMax;			///< Manetka wcisnieta do konca
+} PADDLE_CALIBRATION;
+
+/**
+* @enum PADDLE_BUTTON
+* @brief Zdarzenie przycisku przekazywane do paddle_button()
+*/
+typedef enum
+{
+  PADDLE_BUTTON_PRESS,			///< Wcisniecie samego MODE_2
+  PADDLE_BUTTON_OTHER,			///< Wcisniecie innego przycisku lub MODE_2 przy wcisnietym innym przycisku
+  PADDLE_BUTTON_RELEASE			///< Zwolnienie MODE_2
+} PADDLE_BUTTON;
+
+// ******************************************************************************************************************************************************** //
+
+extern volatile uint8_t paddle_value;			///< Polozenie manetki 0 - PADDLE_VALUE_MAX (wysylane w ramce RS-485)
+extern PADDLE_MODE paddle_mode;
+extern PADDLE_CALIBRATION paddle_calibration;
+extern uint16_t paddle_raw;				///< Srednia z bufora DMA (zakres 16-bit)
+extern uint16_t paddle_filtered;			///< paddle_raw po filtrze IIR
+extern uint32_t paddle_faultCnt;			///< Liczba wykrytych bledow czujnika
+
+// ******************************************************************************************************************************************************** //
+
+#ifndef PADDLE_HOST
+extern void paddle_init(void);
+extern void paddle_step(void);
+#endif
+
+extern void paddle_reset(void);
+extern void paddle_process(const volatile uint16_t *window);
+extern void paddle_startCalibration(void);
+extern uint8_t paddle_finishCalibration(void);
+extern void paddle_button(PADDLE_BUTTON button, uint16_t heldMs);
+extern void paddle_setStopped(uint8_t isStopped);
@@ -0,0 +1,43 @@
+/**
+* @file profiler.c
+* @brief Pomiar czasu wykonania kodu licznikiem cykli rdzenia (DWT CYCCNT), bez przerwan i z rozdzielczoscia jednego cyklu
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include "profiler.h"
+
+// ******************************************************************************************************************************************************** //
+
+static uint32_t cyclesPerUs = 1;		///< Liczba cykli licznika przypadajaca na 1us
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @fn profiler_init(void)
+* @brief Uruchomienie licznika cykli, wywolac po konfiguracji zegara systemowego
+*/
+void profiler_init(void)
+{
+#ifdef PROFILER_HOST
+  cyclesPerUs = PROFILER_HOST_CPU_FREQ / 1000000;
+#else
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;		//Wlacz blok DWT (wlaczany rowniez przez debugger)
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  cyclesPerUs = SystemCoreClock / 1000000;
+#endif
+}
+
+/**
+* @fn profiler_cyclesToUs(uint32_t cycles)
+* @brief Przeliczenie liczby cykli na mikrosekundy
+*/
+uint32_t profiler_cyclesToUs(uint32_t cycles)
+{
+  return cycles / cyclesPerUs;
+}
@@ -0,0 +1,49 @@
+/**
+* @file profiler.h
+* @brief Pomiar czasu wykonania kodu licznikiem cykli rdzenia (DWT CYCCNT), bez przerwan i z rozdzielczoscia jednego cyklu
+* @details Przy kompilacji na komputerze (zdefiniowane PROFILER_HOST) licznik cykli jest wyznaczany z clock_gettime(CLOCK_MONOTONIC)
+* dla czestotliwosci PROFILER_HOST_CPU_FREQ, dzieki czemu modul korzystajacy z profilera mozna uruchomic bez mikrokontrolera
+* (kompilacja z -std=gnu99 -DPROFILER_HOST).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+#pragma once
+
+#include <stdint-gcc.h>
+
+#ifdef PROFILER_HOST
+#include <time.h>
+#else
+#include "stm32f3xx.h"
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+#define PROFILER_HOST_CPU_FREQ		64000000ULL		///< Czestotliwosc emulowanego licznika cykli na komputerze [Hz]
+
+// ******************************************************************************************************************************************************** //
+
+extern void profiler_init(void);
+extern uint32_t profiler_cyclesToUs(uint32_t cycles);
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @fn profiler_getCycles(void)
+* @brief Aktualna wartosc licznika cykli, roznica dwoch odczytow jest poprawna dla odcinkow krotszych niz 2^32 cykli (67s przy 64MHz)
+*/
+static inline uint32_t profiler_getCycles(void)
+{
+#ifdef PROFILER_HOST
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint32_t)((uint64_t)now.tv_sec * PROFILER_HOST_CPU_FREQ + (uint64_t)now.tv_nsec * PROFILER_HOST_CPU_FREQ / 1000000000ULL);
+#else
+  return DWT->CYCCNT;
+#endif
+}
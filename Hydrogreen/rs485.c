@@ -1,6 +1,8 @@
 /**
 * @file rs485.c
 * @brief Biblioteka do obslugi komunikacji UART <-> RS485 <-> UART
+* @details rs485_rxStep() i rs485_txStep() wykonywane sa w przerwaniu PendSV (SCHEDULER_CONTEXT_ISR), dlatego nie moga blokowac.
+* Wynik odbioru zapisywany jest w prywatnej kopii, ktora rs485_syncStep() przepisuje w watku glownym do zmiennych publicznych.
 * @author Piotr Durakiewicz
 * @date 08.12.2020
 * @todo
@@ -12,22 +14,44 @@
 #include "buttons.h"
 #include "usart.h"
 #include "crc.h"
+#include "Nextion_Enhanced_NX3224K028.h"
+#include "spsc_ring.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "gestures.h"
+#include "paddle.h"
 
 // ******************************************************************************************************************************************************** //
 
 #define UART_PORT_RS485 		huart2
-#define TX_FRAME_LENGHT 		11					///< Dlugosc wysylanej ramki danych (z suma CRC)
+#define TX_FRAME_LENGHT 		12					///< Dlugosc wysylanej ramki danych (z suma CRC)
 #define RX_FRAME_LENGHT 		39					///< Dlugosc otrzymywanej ramki danych (z suma CRC)
 #define EOT_BYTE			0x17					///< Bajt wskazujacy na koniec ramki
+#define RX_RING_SIZE			64					///< Rozmiar bufora bajtow przekazywanych z przerwania (potega 2)
+#define TX_BUTTONS			(BUTTONS_HALF_GAS | BUTTONS_FULL_GAS | BUTTONS_HORN | BUTTONS_SPEED_RESET | BUTTONS_SUPPLY | BUTTONS_SC_CLOSE \
+					 | BUTTONS_FUELCELL_OFF | BUTTONS_FUELCELL_PREPARETORACE | BUTTONS_FUELCELL_RACE)	///< Przyciski wysylane w ramce
+
+SPSC_RING_DEFINE(RS485_RX_RING, rs485RxRing, uint8_t, RX_RING_SIZE)
 
 // ******************************************************************************************************************************************************** //
 
-volatile static uint8_t dataFromRx[RX_FRAME_LENGHT]; 				///< Tablica w ktorej zawarte sa nieprzetworzone przychodzace dane
-volatile static uint16_t posInRxTab;						///< Aktualna pozycja w tabeli wykorzystywanej do odbioru danych
-volatile static uint8_t intRxCplt; 						///< Flaga informujaca o otrzymaniu nowego bajtu (gdy 1 - otrzymanowy nowy bajt)
+static RS485_RX_RING rxRing;							///< Bajty odebrane w przerwaniu, oczekujace na rs485_rxStep()
+static uint8_t dataFromRx[RX_FRAME_LENGHT]; 					///< Tablica w ktorej zawarte sa nieprzetworzone przychodzace dane
+static uint16_t posInRxTab;							///< Aktualna pozycja w tabeli wykorzystywanej do odbioru danych
+uint32_t rs485_rxOverflowCnt;							///< Liczba bajtow utraconych z powodu przepelnienia rxRing
 static uint8_t dataToTx[TX_FRAME_LENGHT]; 					///< Tablica w ktorej zawarta jest ramka danych do wyslania
 static uint16_t posInTxTab;							///< Aktualna pozycja w tabeli wykorzystywanej do wysylania danych
+static GESTURES_SUBSCRIBER txGestures;						///< Zmiany stanow przyciskow wysylanych w ramce
+static uint32_t txButtons;							///< Stany przyciskow odtworzone ze zdarzen (maska BUTTONS_xxx)
+static uint32_t txGesturesOverflowCnt;						///< Wartosc txGestures.overflowCnt przy ostatnim odtworzeniu txButtons
+static RS485_RECEIVED_VERIFIED_DATA rxData;					///< Sprawdzone dane modyfikowane w przerwaniu
+static uint8_t rxFlt = RS485_NEW_DATA_TIMEOUT;					///< Kod bledu magistrali modyfikowany w przerwaniu
+static uint32_t rxFrameCnt;							///< Liczba poprawnie odebranych ramek (przerwanie)
+static uint32_t rxFrameTick;							///< Czas odebrania ostatniej poprawnej ramki [ms] (przerwanie)
+static volatile uint32_t rxDataSeq;						///< Numer wersji danych odbiorczych, zwiekszany po kazdej zmianie w przerwaniu
 uint8_t rs485_flt = RS485_NEW_DATA_TIMEOUT;					///< Zmienna przechowujaca aktualny kod bledu magistrali
+uint32_t rs485_rxFrameCnt;							///< Liczba poprawnie odebranych ramek
+uint32_t rs485_rxFrameTick;							///< Czas odebrania ostatniej poprawnej ramki [ms]
 
 // ******************************************************************************************************************************************************** //
 
@@ -37,18 +61,16 @@ uint8_t rs485_flt = RS485_NEW_DATA_TIMEOUT;					///< Zmienna przechowujaca aktua
 */
 typedef struct
 {
-  uint8_t tx;
   uint8_t rx;
 } RS485_BUFFER;
 static RS485_BUFFER RS485_BUFF;
 
-RS485_RECEIVED_VERIFIED_DATA RS485_RX_VERIFIED_DATA; 				///< Struktura w ktorej zawarte sa SPRAWDZONE przychodzace dane
+RS485_RECEIVED_VERIFIED_DATA RS485_RX_VERIFIED_DATA; 				///< Struktura w ktorej zawarte sa SPRAWDZONE przychodzace dane (kopia z rs485_syncStep())
 
 // ******************************************************************************************************************************************************** //
 
-static void sendData(void);
-static void receiveData(void);
 static void prepareNewDataToSend(void);
+static void updateTxButtons(void);
 static void processReceivedData(void);
 static void resetActData(void);
 
@@ -60,45 +82,37 @@ static void resetActData(void);
 */
 void rs485_init(void)
 {
-  HAL_UART_Receive_DMA(&UART_PORT_RS485, &RS485_BUFF.rx, 1);				//Rozpocznij nasluchiwanie
+  rs485RxRing_init(&rxRing);
+  gestures_subscribe(&txGestures, TX_BUTTONS, GESTURE_TYPE_MASK(GESTURE_PRESS) | GESTURE_TYPE_MASK(GESTURE_RELEASE));
+  txButtons = buttons_state;
+  HAL_UART_Receive_IT(&UART_PORT_RS485, &RS485_BUFF.rx, 1);				//Rozpocznij nasluchiwanie
   prepareNewDataToSend();								//Przygotuj nowy pakiet danych
 }
 
 /**
-* @fn rs485_step(void)
-* @brief Funkcja obslugujaca magistrale, umiescic wewnatrz hydrogreen_step(void)
-*/
-void rs485_step(void)
-{
-  receiveData();
-  sendData();
-}
-
-/**
-* @fn sendData(void)
-* @brief Funkcja ktorej zadaniem jest obsluga linii TX, powinna zostac umieszczona w wewnatrz rs485_step()
+* @fn rs485_txStep(void)
+* @brief Obsluga linii TX, zadanie planisty wykonywane co 0,1ms w przerwaniu PendSV (tabela tasks[] w hydrogreen.c)
+* @details Bajt wpisywany jest bezposrednio do rejestru nadawczego, gdy ten jest pusty. Przy 57600 bit/s bajt wysylany jest
+* w ok. 174us, dlatego gdy rejestr jest zajety, wysylka przesuwa sie na kolejny tick zamiast czekac w przerwaniu.
 */
-static void sendData(void)
+void rs485_txStep(void)
 {
   static uint16_t cntEndOfTxTick;							//Zmienna wykorzystywana do odliczenia czasu wskazujacego na koniec transmisji
 
   //Sprawdz czy wyslano cala ramke danych
   if (posInTxTab < TX_FRAME_LENGHT)
     {
-      //Nie, wysylaj dalej
-      RS485_BUFF.tx = dataToTx[posInTxTab];
-
-      //Na czas wysylania danych wylacz przerwania
-      __disable_irq();
-      HAL_UART_Transmit(&UART_PORT_RS485, &RS485_BUFF.tx, 1, HAL_MAX_DELAY);
-      __enable_irq();
-
-      posInTxTab++;
+      //Nie, wysylaj dalej jezeli rejestr nadawczy jest pusty
+      if (__HAL_UART_GET_FLAG(&UART_PORT_RS485, UART_FLAG_TXE))
+	{
+	  UART_PORT_RS485.Instance->TDR = dataToTx[posInTxTab];
+	  posInTxTab++;
+	}
     }
   else if (cntEndOfTxTick < TX_FRAME_LENGHT)
     {
-      //Cala ramka danych zostala wyslana, zacznij odliczac "czas przerwy" pomiedzy przeslaniem kolejnej ramki
-      cntEndOfTxTick++;
+      //Cala ramka danych zostala wyslana, zacznij odliczac "czas przerwy" pomiedzy przeslaniem kolejnej ramki (rowniez ticki pominiete przez planiste)
+      cntEndOfTxTick += scheduler_getReleaseCnt();
     }
   else
     {
@@ -107,36 +121,42 @@ static void sendData(void)
       posInTxTab = 0;
 
       prepareNewDataToSend();
+      TRACE(TRACE_RS485_TX_FRAME, 0);
     }
 }
 
 /**
-* @fn receiveData(void)
-* @brief Funkcja ktorej zadaniem jest obsluga linii RX, umiescic wewnatrz rs485_step()
+* @fn rs485_rxStep(void)
+* @brief Obsluga linii RX, zadanie planisty wykonywane co 0,1ms w przerwaniu PendSV (tabela tasks[] w hydrogreen.c)
 */
-static void receiveData(void)
+void rs485_rxStep(void)
 {
   static uint32_t rejectedFramesInRow;							//Zmienna przechowujaca liczbe straconych ramek z rzedu
   static uint32_t cntEndOfRxTick;							//Zmienna wykorzystywana do odliczenia czasu wskazujacego na koniec transmisji
+  uint8_t received[RX_RING_SIZE];
+  uint32_t ticks = scheduler_getReleaseCnt();						//Liczba tickow od poprzedniego wywolania (wiecej niz 1 gdy planista nie nadazal)
+
+  //Przepisz bajty odebrane od ostatniego wywolania do ramki
+  uint32_t receivedCnt = rs485RxRing_popBatch(&rxRing, received, RX_RING_SIZE);
 
-  //Sprawdz czy otrzymano nowe dane
-  if (!intRxCplt)
+  for (uint32_t i = 0; i < receivedCnt; i++)
     {
-      //Nie otrzymano nowych danych, zacznij odliczac czas
-      cntEndOfRxTick++;
+      if (posInRxTab >= RX_FRAME_LENGHT) posInRxTab = 0;			//Zabezpieczenie przed wyjsciem poza zakres tablicy
+
+      dataFromRx[posInRxTab] = received[i];
+      posInRxTab++;
     }
-  else if (intRxCplt)
+
+  //Sprawdz czy otrzymano nowe dane, przy 57600 bit/s w jednym ticku odbierany jest co najwyzej jeden bajt
+  if (receivedCnt < ticks)
     {
-      //Nowe dane zostaly otrzymane, zeruj flage informujaca o zakonczeniu transmisji
-      intRxCplt = 0;
+      //W czesci tickow nie otrzymano nowych danych, zacznij odliczac czas
+      cntEndOfRxTick += ticks - receivedCnt;
     }
 
   //Sprawdz czy minal juz czas wynoszacy RX_FRAME_LENGHT
   if (cntEndOfRxTick > RX_FRAME_LENGHT)
     {
-      //Na czas przetwarzania danych wylacz przerwania
-      __disable_irq();
-
       //Czas minal, oznacza to koniec ramki
       cntEndOfRxTick = 0;
       posInRxTab = 0;
@@ -148,18 +168,25 @@ static void receiveData(void)
       if ( (dataFromRx[RX_FRAME_LENGHT - 2] == EOT_BYTE) && (crcSumOnMCU == dataFromRx[RX_FRAME_LENGHT - 1]) )
 	{
 	  processReceivedData();
-	  rs485_flt = RS485_FLT_NONE;
+	  rxFlt = RS485_FLT_NONE;
+	  rxFrameTick = HAL_GetTick();
+	  rxFrameCnt++;
+	  rxDataSeq++;
 	  rejectedFramesInRow = 0;
+	  TRACE(TRACE_RS485_FRAME_OK, rxFrameCnt);
 	}
       else
 	{
 	  rejectedFramesInRow++;
+	  TRACE(TRACE_RS485_FRAME_BAD, rejectedFramesInRow);
 
 	  //Jezeli odrzucono wiecej niz 50 ramek z rzedu uznaj ze tranmisja zostala zerwana
 	  if (rejectedFramesInRow > 50)
 	    {
 	      resetActData();
-	      rs485_flt = RS485_NEW_DATA_TIMEOUT;
+	      rxFlt = RS485_NEW_DATA_TIMEOUT;
+	      rxDataSeq++;
+	      TRACE(TRACE_RS485_LINK_LOST, 0);
 	    }
 	}
 
@@ -168,41 +195,93 @@ static void receiveData(void)
 	{
 	  dataFromRx[i] = 0x00;
 	}
+    }
+}
+
+/**
+* @fn rs485_syncStep(void)
+* @brief Przepisanie danych odebranych w przerwaniu do zmiennych publicznych, zadanie planisty wykonywane w watku glownym
+* @details Kopia jest powtarzana, jezeli w jej trakcie przerwanie PendSV zmienilo dane (zmienil sie rxDataSeq),
+* dzieki czemu watek glowny zawsze widzi dane z jednej ramki bez wylaczania przerwan.
+*/
+void rs485_syncStep(void)
+{
+  static uint32_t syncedSeq;
+  uint32_t seq;
 
-      __enable_irq();
+  if (rxDataSeq == syncedSeq)
+    {
+      return;
     }
+
+  do
+    {
+      seq = rxDataSeq;
+      __DMB();
+
+      RS485_RX_VERIFIED_DATA = rxData;
+      rs485_flt = rxFlt;
+      rs485_rxFrameCnt = rxFrameCnt;
+      rs485_rxFrameTick = rxFrameTick;
+
+      __DMB();
+    }
+  while (seq != rxDataSeq);
+
+  syncedSeq = seq;
+  TRACE(TRACE_RS485_SYNC, seq);
 }
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-  HAL_UART_Receive_DMA(&UART_PORT_RS485, &RS485_BUFF.rx, 1);			//Ponownie rozpocznij nasluchiwanie nasluchiwanie
+  //Bajt odebrany z wyswietlacza, przekaz go do biblioteki Nextion
+  if (Nextion_Enhanced_NX3224K028_rxCpltCallback(huart))
+    {
+      return;
+    }
 
-  intRxCplt = 1;								//Ustaw flage informujaca o otrzymaniu nowych danych
+  //Przekaz bajt do rs485_rxStep(), bufor jest zwalniany przed ponownym rozpoczeciem nasluchiwania
+  if (!rs485RxRing_push(&rxRing, &RS485_BUFF.rx))
+    {
+      rs485_rxOverflowCnt++;
+      TRACE(TRACE_RS485_RX_OVERFLOW, rs485_rxOverflowCnt);
+    }
 
-  if (posInRxTab > RX_FRAME_LENGHT) posInRxTab = 0;				//Zabezpieczenie przed wyjsciem poza zakres tablicy
+  HAL_UART_Receive_IT(&UART_PORT_RS485, &RS485_BUFF.rx, 1);			//Ponownie rozpocznij nasluchiwanie nasluchiwanie
+}
 
-  dataFromRx[posInRxTab] = RS485_BUFF.rx;					//Przypisz otrzymany bajt do analizowanej tablicy
-  posInRxTab++;
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  //HAL przerywa odbior po bledzie (np. przepelnienie rejestru odbiorczego), utracona ramka zostanie odrzucona przez CRC
+  if (huart->Instance == UART_PORT_RS485.Instance)
+    {
+      HAL_UART_Receive_IT(&UART_PORT_RS485, &RS485_BUFF.rx, 1);
+    }
 }
 
 /**
 * @fn prepareNewDataToSend(void)
-* @brief Funkcja przygotowujaca dane do wysylki, wykorzystana wewnatrz sendData(void)
+* @brief Funkcja przygotowujaca dane do wysylki, wykorzystana wewnatrz rs485_txStep(void)
 */
 static void prepareNewDataToSend(void)
 {
   uint8_t j = 0;
 
+  updateTxButtons();
+
   ///< Stany przyciskow
-  dataToTx[j] = BUTTONS.halfGas;
-  dataToTx[++j] = BUTTONS.fullGas;
-  dataToTx[++j] = BUTTONS.horn;
-  dataToTx[++j] = BUTTONS.speedReset;
-  dataToTx[++j] = BUTTONS.powerSupply;
-  dataToTx[++j] = BUTTONS.scClose;
-  dataToTx[++j] = BUTTONS.fuelcellOff;
-  dataToTx[++j] = BUTTONS.fuelcellPrepareToRace;
-  dataToTx[++j] = BUTTONS.fuelcellRace;
+  dataToTx[j] = (txButtons & BUTTONS_HALF_GAS) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_FULL_GAS) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_HORN) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_SPEED_RESET) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_SUPPLY) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_SC_CLOSE) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_FUELCELL_OFF) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_FUELCELL_PREPARETORACE) != 0;
+  dataToTx[++j] = (txButtons & BUTTONS_FUELCELL_RACE) != 0;
+
+  ///< Polozenie manetki (0 - PADDLE_VALUE_MAX)
+  dataToTx[++j] = paddle_value;
 
   dataToTx[++j] = EOT_BYTE;
 
@@ -213,6 +292,28 @@ static void prepareNewDataToSend(void)
   dataToTx[TX_FRAME_LENGHT - 1] = calculatedCrcSumOnMCU;
 }
 
+/**
+* @fn updateTxButtons(void)
+* @brief Odtworzenie stanow przyciskow ze zdarzen wcisniecia i zwolnienia zebranych od poprzedniej ramki
+*/
+static void updateTxButtons(void)
+{
+  GESTURE_EVENT event;
+
+  while (gestures_get(&txGestures, &event))
+    {
+      if (event.type == GESTURE_PRESS) txButtons |= event.buttons;
+      else txButtons &= ~event.buttons;
+    }
+
+  //Czesc zdarzen zostala utracona, stany odczytywane sa bezposrednio z buttons_state
+  if (txGestures.overflowCnt != txGesturesOverflowCnt)
+    {
+      txGesturesOverflowCnt = txGestures.overflowCnt;
+      txButtons = buttons_state;
+    }
+}
+
 /**
 * @fn processReveivedData()
 * @brief Funkcja przypisujaca odebrane dane do zmiennych docelowych
@@ -223,43 +324,43 @@ static void processReceivedData(void)
 
   for (uint8_t k = 0; k < 4; k++)
       {
-        RS485_RX_VERIFIED_DATA.TOTAL_POWER.array[k] = dataFromRx[++i];
+        rxData.TOTAL_POWER.array[k] = dataFromRx[++i];
       }
 
   for (uint8_t k = 0; k < 4; k++)
         {
-          RS485_RX_VERIFIED_DATA.hydrogen_usage.array[k] = dataFromRx[++i];
+          rxData.hydrogen_usage.array[k] = dataFromRx[++i];
         }
 
   for (uint8_t k = 0; k < 2; k++)
     {
-      RS485_RX_VERIFIED_DATA.laptime_minutes.array[k] = dataFromRx[++i];
+      rxData.laptime_minutes.array[k] = dataFromRx[++i];
     }
 
   for (uint8_t k = 0; k < 2; k++)
       {
-        RS485_RX_VERIFIED_DATA.delta_laptime_minutes.array[k] = dataFromRx[++i];
+        rxData.delta_laptime_minutes.array[k] = dataFromRx[++i];
       }
 
   for (uint8_t k = 0; k < 2; k++)
       {
-        RS485_RX_VERIFIED_DATA.laptime_miliseconds.array[k] = dataFromRx[++i];
+        rxData.laptime_miliseconds.array[k] = dataFromRx[++i];
       }
 
   for (uint8_t k = 0; k < 2; k++)
         {
-          RS485_RX_VERIFIED_DATA.delta_laptime_miliseconds.array[k] = dataFromRx[++i];
+          rxData.delta_laptime_miliseconds.array[k] = dataFromRx[++i];
         }
 
-  RS485_RX_VERIFIED_DATA.interimSpeed = dataFromRx[++i];
-  RS485_RX_VERIFIED_DATA.laptime_seconds = dataFromRx[++i];
-  RS485_RX_VERIFIED_DATA.delta_laptime_seconds = dataFromRx[++i];
+  rxData.interimSpeed = dataFromRx[++i];
+  rxData.laptime_seconds = dataFromRx[++i];
+  rxData.delta_laptime_seconds = dataFromRx[++i];
 
-  RS485_RX_VERIFIED_DATA.electrovalve = dataFromRx[++i];
-  RS485_RX_VERIFIED_DATA.purgeValve = dataFromRx[++i];
+  rxData.electrovalve = dataFromRx[++i];
+  rxData.purgeValve = dataFromRx[++i];
 
-  RS485_RX_VERIFIED_DATA.h2SensorDigitalPin = dataFromRx[++i];
-  RS485_RX_VERIFIED_DATA.emergencyButton = dataFromRx[++i];
+  rxData.h2SensorDigitalPin = dataFromRx[++i];
+  rxData.emergencyButton = dataFromRx[++i];
 }
 
 /**
@@ -268,20 +369,20 @@ static void processReceivedData(void)
 */
 static void resetActData(void)
 {
-  RS485_RX_VERIFIED_DATA.interimSpeed = 0;
+  rxData.interimSpeed = 0;
 
-  RS485_RX_VERIFIED_DATA.laptime_minutes.value = 0;
-  RS485_RX_VERIFIED_DATA.laptime_seconds = 0;
-  RS485_RX_VERIFIED_DATA.laptime_miliseconds.value = 0;
-  RS485_RX_VERIFIED_DATA.delta_laptime_miliseconds.value = 0;
-  RS485_RX_VERIFIED_DATA.delta_laptime_seconds = 0;
-  RS485_RX_VERIFIED_DATA.delta_laptime_minutes.value = 0;
+  rxData.laptime_minutes.value = 0;
+  rxData.laptime_seconds = 0;
+  rxData.laptime_miliseconds.value = 0;
+  rxData.delta_laptime_miliseconds.value = 0;
+  rxData.delta_laptime_seconds = 0;
+  rxData.delta_laptime_minutes.value = 0;
 
   for (uint8_t k = 0; k < 4; k++)
     {
-      RS485_RX_VERIFIED_DATA.TOTAL_POWER.array[k] = 0;
+      rxData.TOTAL_POWER.array[k] = 0;
     }
 
-  RS485_RX_VERIFIED_DATA.h2SensorDigitalPin = 0;
-  RS485_RX_VERIFIED_DATA.emergencyButton = 0;
+  rxData.h2SensorDigitalPin = 0;
+  rxData.emergencyButton = 0;
 }
@@ -17,11 +17,16 @@
 #define RS485_NEW_DATA_TIMEOUT 0x11				///< Nie otrzymano nowych dane (polaczenie zostalo zerwane)
 
 extern uint8_t rs485_flt; 					///< Zmienna przechowujaca aktualny kod bledu magistrali
+extern uint32_t rs485_rxFrameCnt;				///< Liczba poprawnie odebranych ramek
+extern uint32_t rs485_rxFrameTick;				///< Czas odebrania ostatniej poprawnej ramki [ms]
+extern uint32_t rs485_rxOverflowCnt;				///< Liczba bajtow utraconych z powodu przepelnienia bufora odbiorczego
 
 // ******************************************************************************************************************************************************** //
 
 extern void rs485_init(void);					///< Inicjalizacja magistrali RS-485, umiescic wewnatrz hydrogreen_init(void)
-extern void rs485_step(void);					///< Funkcja obslugujaca magistrale, umiescic wewnatrz hydrogreen_step(void)
+extern void rs485_rxStep(void);					///< Obsluga linii RX, zadanie planisty wykonywane co 0,1ms (tabela tasks[] w hydrogreen.c)
+extern void rs485_txStep(void);					///< Obsluga linii TX, zadanie planisty wykonywane co 0,1ms (tabela tasks[] w hydrogreen.c)
+extern void rs485_syncStep(void);				///< Przepisanie danych odebranych w przerwaniu do zmiennych publicznych (watek glowny)
 
 // ******************************************************************************************************************************************************** //
 
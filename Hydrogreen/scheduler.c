@@ -0,0 +1,424 @@
+/**
+* @file scheduler.c
+* @brief Planista zadan kooperacyjnych sterowany statyczna tabela (okres, przesuniecie fazy, priorytet, budzet czasu)
+* @details Podstawa czasu jest tick TIM6 (10kHz). Zadania o tym samym okresie otrzymuja rozne przesuniecia fazy,
+* dzieki czemu nie sa wykonywane w jednym ticku jedno po drugim, a obciazenie rozklada sie na caly okres.
+* Gdy zaden tick nie oczekuje, rdzen jest usypiany instrukcja WFI, a czas uspienia sluzy do wyznaczenia obciazenia procesora.
+* Przerwanie TIM6 zwieksza licznik tickow, dlatego ticki, ktore wystapily w trakcie zbyt dlugiego kroku, nie sa gubione:
+* kazde zadanie wie ile razy bylo gotowe od ostatniego sprawdzenia i postepuje z zaleglymi wywolaniami zgodnie ze swoim policy.
+* Zadania SCHEDULER_CONTEXT_ISR wykonywane sa w przerwaniu PendSV zglaszanym przez przerwanie TIM6. PendSV (1:0) jest w tej samej grupie
+* wywlaszczania co TIM2 (1:0), TIM6 i EXTI (1:1), wiec zadne z nich nie przerywa pozostalych: PendSV moga wywlaszczyc tylko USART2 (RS-485)
+* i SysTick (0:0), a samo PendSV wywlaszcza watek glowny i przerwania wyswietlacza (USART1, DMA1 kanal 4, 2:0). Tick TIM6 i zbocza EXTI
+* zgloszone w trakcie PendSV czekaja na jego zakonczenie, dlatego suma budzetow zadan ISR musi byc znacznie krotsza od ticku (0,1ms).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include "scheduler.h"
+#include "timers.h"
+#include "profiler.h"
+#include "gpio.h"
+
+// ******************************************************************************************************************************************************** //
+
+//#define SCHEDULER_DEBUG						///< Stan niski na DBG_Pin w trakcie wykonywania zadan jednego ticku (pomiar oscyloskopem)
+#define SCHEDULER_IDLE_SLEEP						///< Usypianie rdzenia (WFI) pomiedzy tickami, bez tej definicji petla glowna aktywnie czeka na tick
+
+// ******************************************************************************************************************************************************** //
+
+static const SCHEDULER_TASK *tasks;		///< Tabela zadan
+static uint8_t tasksCnt;			///< Liczba zadan w tabeli
+static uint8_t order[SCHEDULER_MAX_TASKS];	///< Indeksy zadan uporzadkowane wedlug priorytetu
+static uint32_t budgetCycles[SCHEDULER_MAX_TASKS];	///< Budzety zadan przeliczone na cykle rdzenia
+static uint32_t tick;				///< Numer ostatniego ticku obsluzonego w watku glownym (wartosc timers_tick10kHzCnt)
+static uint32_t isrTick;			///< Numer ostatniego ticku obsluzonego w przerwaniu PendSV
+static uint32_t nextRelease[SCHEDULER_MAX_TASKS];	///< Numer ticku, w ktorym zadanie bedzie gotowe
+static uint32_t releaseCnt[2];			///< Liczba tickow gotowosci obslugiwanych przez aktualnie wykonywane zadanie (indeks SCHEDULER_CONTEXT)
+SCHEDULER_TASK_STATS scheduler_taskStats[SCHEDULER_MAX_TASKS];	///< Statystyki zadan
+uint32_t scheduler_tickOverrunCnt;		///< Liczba tickow, w ktorych zadania nie zakonczyly sie przed kolejnym tickiem
+uint32_t scheduler_lateTickCnt;			///< Liczba tickow obsluzonych z opoznieniem
+uint16_t scheduler_maxTickBacklog;		///< Najwieksza zanotowana liczba tickow oczekujacych na obsluge
+static uint32_t idleCycles;			///< Czas bezczynnosci w aktualnym oknie 1s [cykl]
+static uint32_t loadWindowStart;		///< Wartosc licznika cykli na poczatku aktualnego okna 1s
+static uint16_t loadWindowTicks;		///< Liczba tickow w aktualnym oknie 1s
+static uint16_t loadHistory[SCHEDULER_LOAD_LONG_WINDOW];	///< Obciazenie w kolejnych sekundach dluzszego okna [0,1%]
+static uint8_t loadHistoryPos;			///< Pozycja w loadHistory[] do zapisu kolejnej wartosci
+uint16_t scheduler_cpuLoad1s;			///< Obciazenie procesora w ostatniej sekundzie [0,1%]
+uint16_t scheduler_cpuLoad10s;			///< Obciazenie procesora w ostatnich SCHEDULER_LOAD_LONG_WINDOW sekundach [0,1%]
+SCHEDULER_LATENCY scheduler_threadLatency = { .min = UINT16_MAX };	///< Opoznienie rozpoczecia zadan watku glownego
+SCHEDULER_LATENCY scheduler_isrLatency = { .min = UINT16_MAX };		///< Opoznienie rozpoczecia zadan wykonywanych w przerwaniu PendSV
+
+// ******************************************************************************************************************************************************** //
+
+static inline void releaseTask(uint8_t idx, uint32_t now);
+static inline void runTask(uint8_t idx, uint32_t releases);
+static inline void idle(void);
+static inline void measureLatency(SCHEDULER_LATENCY *latency);
+static inline void updateLoad(uint32_t ticks);
+static inline uint8_t histBucket(uint32_t cycles);
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @fn scheduler_init(const SCHEDULER_TASK *table, uint8_t taskCnt)
+* @brief Inicjalizacja planisty, tabela musi istniec przez caly czas pracy programu. Zwraca 0 jezeli tabela jest niepoprawna
+*/
+uint8_t scheduler_init(const SCHEDULER_TASK *table, uint8_t taskCnt)
+{
+  if (taskCnt > SCHEDULER_MAX_TASKS)
+    {
+      return 0;
+    }
+
+  for (uint8_t i = 0; i < taskCnt; i++)
+    {
+      if ( (table[i].step == 0) || (table[i].period == 0) || (table[i].offset >= table[i].period) || (table[i].policy > SCHEDULER_POLICY_SKIP)
+	  || (table[i].context > SCHEDULER_CONTEXT_ISR) )
+	{
+	  return 0;
+	}
+
+      budgetCycles[i] = table[i].budget * (SystemCoreClock / 1000000);
+    }
+
+  //TIM6 pracuje juz od timers_init(), pierwszy obslugiwany tick to kolejny po aktualnym
+  tick = timers_tick10kHzCnt;
+  isrTick = tick;
+
+  for (uint8_t i = 0; i < taskCnt; i++)
+    {
+      uint32_t first = tick + 1;
+
+      nextRelease[i] = first + (table[i].period + table[i].offset - (first % table[i].period)) % table[i].period;
+    }
+
+  //Sortowanie przez wstawianie, zadania o rownym priorytecie zachowuja kolejnosc z tabeli
+  for (uint8_t i = 0; i < taskCnt; i++)
+    {
+      uint8_t j = i;
+
+      while ( (j > 0) && (table[order[j - 1]].priority > table[i].priority) )
+	{
+	  order[j] = order[j - 1];
+	  j--;
+	}
+
+      order[j] = i;
+    }
+
+  loadWindowStart = profiler_getCycles();
+
+#ifdef DEBUG
+  //Debugger pozostaje polaczony w trakcie uspienia rdzenia
+  DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP;
+#endif
+
+  //Tabela udostepniana na koncu, od tej chwili przerwanie PendSV wykonuje zadania
+  tasksCnt = taskCnt;
+  __DMB();
+  tasks = table;
+
+  return 1;
+}
+
+/**
+* @fn scheduler_step(void)
+* @brief Wykonanie zadan gotowych w aktualnym ticku, wywolywac w petli glownej programu
+*/
+void scheduler_step(void)
+{
+  //Przerwania wylaczone pomiedzy sprawdzeniem licznika a WFI, aby tick zgloszony w tym czasie nie zostal przespany
+  __disable_irq();
+
+  if (timers_tick10kHzCnt == tick)
+    {
+      idle();
+      __enable_irq();
+      return;
+    }
+
+  __enable_irq();
+
+  uint32_t now = timers_tick10kHzCnt;
+  uint32_t backlog = now - tick;
+
+  if (backlog == 1)
+    {
+      measureLatency(&scheduler_threadLatency);
+    }
+  else
+    {
+      //Poprzedni krok trwal dluzej niz tick
+      scheduler_lateTickCnt += backlog - 1;
+
+      if (backlog > scheduler_maxTickBacklog)
+	{
+	  scheduler_maxTickBacklog = (backlog < UINT16_MAX) ? backlog : UINT16_MAX;
+	}
+    }
+
+#ifdef SCHEDULER_DEBUG
+  HAL_GPIO_WritePin(GPIOA, DBG_Pin, GPIO_PIN_RESET);
+#endif
+  timers_beforeStep();
+
+  for (uint8_t i = 0; i < tasksCnt; i++)
+    {
+      if (tasks[order[i]].context == SCHEDULER_CONTEXT_THREAD)
+	{
+	  releaseTask(order[i], now);
+	}
+    }
+
+  timers_afterStep();
+#ifdef SCHEDULER_DEBUG
+  HAL_GPIO_WritePin(GPIOA, DBG_Pin, GPIO_PIN_SET);
+#endif
+
+  //Kolejny tick nastapil zanim zakonczono wykonywanie zadan
+  if (timers_tick10kHzCnt != now)
+    {
+      scheduler_tickOverrunCnt++;
+    }
+
+  tick = now;
+  updateLoad(backlog);
+}
+
+/**
+* @fn scheduler_isrStep(void)
+* @brief Wykonanie zadan SCHEDULER_CONTEXT_ISR gotowych w aktualnym ticku, wywolywac w PendSV_Handler()
+*/
+void scheduler_isrStep(void)
+{
+  if (tasks == 0)
+    {
+      return;
+    }
+
+  uint32_t now = timers_tick10kHzCnt;
+
+  if (now == isrTick)
+    {
+      return;
+    }
+
+  if ((now - isrTick) == 1)
+    {
+      measureLatency(&scheduler_isrLatency);
+    }
+
+  for (uint8_t i = 0; i < tasksCnt; i++)
+    {
+      if (tasks[order[i]].context == SCHEDULER_CONTEXT_ISR)
+	{
+	  releaseTask(order[i], now);
+	}
+    }
+
+  isrTick = now;
+}
+
+/**
+* @fn scheduler_getReleaseCnt(void)
+* @brief Liczba okresow zadania obslugiwanych przez aktualne wykonanie (1 gdy planista nadaza), wywolywac wewnatrz zadania
+* @details Pozwala zadaniom odliczajacym czas liczba wywolan (np. przerwy w transmisji RS-485) uwzglednic wywolania pominiete.
+*/
+uint32_t scheduler_getReleaseCnt(void)
+{
+  return releaseCnt[(__get_IPSR() != 0) ? SCHEDULER_CONTEXT_ISR : SCHEDULER_CONTEXT_THREAD];
+}
+
+/**
+* @fn releaseTask(uint8_t idx, uint32_t now)
+* @brief Wykonanie zadania, jezeli od ostatniego sprawdzenia bylo gotowe co najmniej raz, zgodnie z jego policy
+*/
+static inline void releaseTask(uint8_t idx, uint32_t now)
+{
+  const SCHEDULER_TASK *task = &tasks[idx];
+  SCHEDULER_TASK_STATS *stats = &scheduler_taskStats[idx];
+  int32_t due = (int32_t)(now - nextRelease[idx]);
+
+  if (due < 0)
+    {
+      return;
+    }
+
+  //Liczba tickow gotowosci od ostatniego sprawdzenia, spoznione jest wykonanie, ktorego ostatni tick gotowosci nie jest aktualnym
+  uint32_t releases = (uint32_t)due / task->period + 1;
+  uint8_t late = ((uint32_t)due % task->period) != 0;
+
+  nextRelease[idx] += releases * task->period;
+
+  switch (task->policy)
+  {
+    case SCHEDULER_POLICY_ONCE:
+      runTask(idx, releases);
+      stats->missedCnt += releases - 1;
+      break;
+
+    case SCHEDULER_POLICY_CATCH_UP:
+      {
+	uint32_t runs = (releases <= task->catchUpMax) ? releases : (task->catchUpMax + 1U);
+
+	//Ostatnie wykonanie obejmuje rowniez wywolania, ktore nie zmiescily sie w limicie
+	for (uint32_t i = 1; i < runs; i++)
+	  {
+	    runTask(idx, 1);
+	  }
+
+	runTask(idx, releases - runs + 1);
+	stats->missedCnt += releases - runs;
+	late |= (releases > 1);
+      }
+      break;
+
+    case SCHEDULER_POLICY_SKIP:
+      if (late)
+	{
+	  stats->missedCnt += releases;
+	  return;
+	}
+
+      runTask(idx, releases);
+      stats->missedCnt += releases - 1;
+      break;
+
+    default:
+      break;
+  }
+
+  if (late)
+    {
+      stats->lateCnt++;
+    }
+}
+
+/**
+* @fn idle(void)
+* @brief Uspienie rdzenia do najblizszego przerwania, wywolywac przy wylaczonych przerwaniach
+* @details Przy wylaczonych przerwaniach WFI budzi rdzen, ale obsluga przerwania nastepuje dopiero po __enable_irq(),
+* dzieki czemu czas wykonania przerwan nie jest wliczany do czasu bezczynnosci.
+*/
+static inline void idle(void)
+{
+  uint32_t start = profiler_getCycles();
+
+#ifdef SCHEDULER_IDLE_SLEEP
+  __WFI();
+#endif
+
+  idleCycles += profiler_getCycles() - start;
+}
+
+/**
+* @fn measureLatency(SCHEDULER_LATENCY *latency)
+* @brief Pomiar opoznienia rozpoczecia zadan wzgledem przepelnienia TIM6
+*/
+static inline void measureLatency(SCHEDULER_LATENCY *latency)
+{
+  latency->last = timers_getTickPhase();
+
+  if (latency->last < latency->min)
+    {
+      latency->min = latency->last;
+    }
+
+  if (latency->last > latency->max)
+    {
+      latency->max = latency->last;
+    }
+
+  if (latency->last > SCHEDULER_WAKE_LATENCY_BUDGET)
+    {
+      latency->overBudgetCnt++;
+    }
+}
+
+/**
+* @fn updateLoad(uint32_t ticks)
+* @brief Wyznaczenie obciazenia procesora po kazdej pelnej sekundzie pracy planisty
+*/
+static inline void updateLoad(uint32_t ticks)
+{
+  loadWindowTicks += ticks;
+
+  if (loadWindowTicks < SCHEDULER_TICKS_1S)
+    {
+      return;
+    }
+
+  uint32_t now = profiler_getCycles();
+  uint32_t cyclesPerPermille = (now - loadWindowStart) / 1000;
+  uint32_t idlePermille = idleCycles / cyclesPerPermille;
+
+  scheduler_cpuLoad1s = (idlePermille < 1000) ? (1000 - idlePermille) : 0;
+
+  loadHistory[loadHistoryPos] = scheduler_cpuLoad1s;
+  loadHistoryPos = (loadHistoryPos + 1) % SCHEDULER_LOAD_LONG_WINDOW;
+
+  uint32_t sum = 0;
+
+  for (uint8_t i = 0; i < SCHEDULER_LOAD_LONG_WINDOW; i++)
+    {
+      sum += loadHistory[i];
+    }
+
+  //Do czasu zapelnienia historii dluzsze okno obejmuje sekundy z zerowym obciazeniem
+  scheduler_cpuLoad10s = sum / SCHEDULER_LOAD_LONG_WINDOW;
+
+  idleCycles = 0;
+  loadWindowStart = now;
+  loadWindowTicks = 0;
+}
+
+/**
+* @fn runTask(uint8_t idx, uint32_t releases)
+* @brief Wykonanie zadania wraz z pomiarem czasu, releases - liczba okresow obslugiwanych przez to wykonanie
+*/
+static inline void runTask(uint8_t idx, uint32_t releases)
+{
+  SCHEDULER_TASK_STATS *stats = &scheduler_taskStats[idx];
+  uint32_t start = profiler_getCycles();
+
+  releaseCnt[tasks[idx].context] = releases;
+
+  tasks[idx].step();
+
+  stats->lastCycles = profiler_getCycles() - start;
+  stats->runCnt++;
+  stats->histogram[histBucket(stats->lastCycles)]++;
+
+  if (stats->lastCycles > stats->maxCycles)
+    {
+      stats->maxCycles = stats->lastCycles;
+      stats->maxStartCycles = start;
+      stats->maxRunCnt = stats->runCnt;
+    }
+
+  if (stats->lastCycles > budgetCycles[idx])
+    {
+      stats->overrunCnt++;
+    }
+}
+
+/**
+* @fn histBucket(uint32_t cycles)
+* @brief Numer przedzialu histogramu dla czasu wykonania, dlugosc w bitach wartosci cycles >> SCHEDULER_HIST_SHIFT (jedna instrukcja CLZ)
+*/
+static inline uint8_t histBucket(uint32_t cycles)
+{
+  cycles >>= SCHEDULER_HIST_SHIFT;
+
+  if (cycles == 0)
+    {
+      return 0;
+    }
+
+  uint8_t bucket = 32 - __CLZ(cycles);
+
+  return (bucket < SCHEDULER_HIST_BUCKETS) ? bucket : (SCHEDULER_HIST_BUCKETS - 1);
+}
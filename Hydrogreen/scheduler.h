@@ -0,0 +1,113 @@
+/**
+* @file scheduler.h
+* @brief Planista zadan kooperacyjnych sterowany statyczna tabela (okres, przesuniecie fazy, priorytet, budzet czasu)
+* @details Zadania wykonywane sa na dwoch poziomach: w watku glownym (scheduler_step()) oraz w przerwaniu PendSV (scheduler_isrStep()),
+* ktore wywlaszcza watek glowny i przerwania wyswietlacza, dzieki czemu opoznienie zadan krytycznych nie zalezy od obciazenia interfejsu.
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+#pragma once
+
+#include <stdint-gcc.h>
+
+// ******************************************************************************************************************************************************** //
+
+#define SCHEDULER_MAX_TASKS		8			///< Maksymalna liczba zadan w tabeli
+#define SCHEDULER_TICK_US		100			///< Okres ticku planisty [us] (TIM6, 10kHz)
+#define SCHEDULER_TICKS_1MS		(1000 / SCHEDULER_TICK_US)	///< Liczba tickow planisty przypadajaca na 1ms
+#define SCHEDULER_TICKS_1S		(1000 * SCHEDULER_TICKS_1MS)	///< Liczba tickow planisty przypadajaca na 1s
+#define SCHEDULER_LOAD_LONG_WINDOW	10			///< Dlugosc dluzszego okna pomiaru obciazenia [s]
+#define SCHEDULER_WAKE_LATENCY_BUDGET	10			///< Dopuszczalne opoznienie rozpoczecia zadan wzgledem przepelnienia TIM6 [us]
+#define SCHEDULER_HIST_BUCKETS		16			///< Liczba przedzialow histogramu czasu wykonania
+#define SCHEDULER_HIST_SHIFT		5			///< Przedzial 0 to czasy krotsze niz 2^SCHEDULER_HIST_SHIFT cykli (0,5us przy 64MHz)
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @enum SCHEDULER_POLICY
+* @brief Postepowanie z wywolaniami zadania, ktore nie zostaly wykonane w swoim ticku (planista nie nadazal)
+*/
+typedef enum
+{
+  SCHEDULER_POLICY_ONCE,		///< Jedno wykonanie za wszystkie zalegle, pozostale zliczane jako pominiete
+  SCHEDULER_POLICY_CATCH_UP,		///< Do catchUpMax dodatkowych wykonan pod rzad, pozostale zliczane jako pominiete
+  SCHEDULER_POLICY_SKIP			///< Wykonanie tylko w ticku, w ktorym zadanie bylo gotowe, spoznione wywolania sa pomijane
+} SCHEDULER_POLICY;
+
+/**
+* @enum SCHEDULER_CONTEXT
+* @brief Poziom, na ktorym wykonywane jest zadanie
+*/
+typedef enum
+{
+  SCHEDULER_CONTEXT_THREAD,		///< Watek glowny (petla w hydrogreen_main()), wywlaszczany przez przerwania
+  SCHEDULER_CONTEXT_ISR			///< Przerwanie PendSV zglaszane w przerwaniu TIM6, zadanie musi byc krotkie i nieblokujace
+} SCHEDULER_CONTEXT;
+
+/**
+* @struct SCHEDULER_TASK
+* @brief Wpis tabeli zadan
+*/
+typedef struct
+{
+  void (*step)(void);			///< Funkcja zadania
+  uint16_t period;			///< Okres wywolania [tick planisty]
+  uint16_t offset;			///< Przesuniecie fazy wzgledem poczatku okresu [tick planisty], mniejsze od period
+  uint8_t priority;			///< Kolejnosc wykonania zadan gotowych w tym samym ticku (0 - najwyzszy priorytet)
+  uint16_t budget;			///< Dopuszczalny czas wykonania [us], przekroczenie jest zliczane w overrunCnt
+  SCHEDULER_POLICY policy;		///< Postepowanie z zaleglymi wywolaniami
+  uint8_t catchUpMax;			///< Maksymalna liczba dodatkowych wykonan (SCHEDULER_POLICY_CATCH_UP)
+  SCHEDULER_CONTEXT context;		///< Poziom wykonania zadania
+} SCHEDULER_TASK;
+
+/**
+* @struct SCHEDULER_LATENCY
+* @brief Opoznienie rozpoczecia wykonywania zadan wzgledem przepelnienia TIM6 [us], rozrzut (jitter) to max - min
+*/
+typedef struct
+{
+  uint16_t last;			///< Opoznienie w ostatnim ticku
+  uint16_t min;				///< Najmniejsze zanotowane opoznienie
+  uint16_t max;				///< Najwieksze zanotowane opoznienie
+  uint32_t overBudgetCnt;		///< Liczba tickow rozpoczetych pozniej niz SCHEDULER_WAKE_LATENCY_BUDGET
+} SCHEDULER_LATENCY;
+
+/**
+* @struct SCHEDULER_TASK_STATS
+* @brief Statystyki zadania (czasy w cyklach rdzenia, patrz profiler_cyclesToUs()), nie sa zerowane w trakcie pracy programu
+* @details Przedzial k > 0 histogramu zlicza czasy z zakresu [2^(k+4), 2^(k+5)) cykli, ostatni przedzial rowniez wszystkie dluzsze
+* (przy 64MHz: 0 - ponizej 0,5us, 1 - 0,5..1us, 2 - 1..2us, ..., 15 - powyzej 8ms).
+*/
+typedef struct
+{
+  uint32_t runCnt;			///< Liczba wykonan
+  uint32_t overrunCnt;			///< Liczba wykonan dluzszych niz budzet zadania
+  uint32_t lateCnt;			///< Liczba wykonan rozpoczetych w pozniejszym ticku niz ten, w ktorym zadanie bylo gotowe
+  uint32_t missedCnt;			///< Liczba wywolan pominietych zgodnie z policy
+  uint32_t lastCycles;			///< Czas ostatniego wykonania [cykl]
+  uint32_t maxCycles;			///< Najdluzszy zanotowany czas wykonania (WCET) [cykl]
+  uint32_t maxStartCycles;		///< Wartosc licznika cykli na poczatku wykonania, w ktorym zanotowano maxCycles
+  uint32_t maxRunCnt;			///< Numer wykonania (runCnt), w ktorym zanotowano maxCycles
+  uint32_t histogram[SCHEDULER_HIST_BUCKETS];	///< Histogram czasow wykonania w przedzialach logarytmicznych
+} SCHEDULER_TASK_STATS;
+
+// ******************************************************************************************************************************************************** //
+
+extern SCHEDULER_TASK_STATS scheduler_taskStats[SCHEDULER_MAX_TASKS];	///< Statystyki zadan (indeksy jak w tabeli przekazanej do scheduler_init())
+extern uint32_t scheduler_tickOverrunCnt;				///< Liczba tickow, w ktorych zadania nie zakonczyly sie przed kolejnym tickiem
+extern uint32_t scheduler_lateTickCnt;					///< Liczba tickow obsluzonych z opoznieniem (zaleglych w chwili rozpoczecia kroku planisty)
+extern uint16_t scheduler_maxTickBacklog;				///< Najwieksza zanotowana liczba tickow oczekujacych na obsluge
+extern uint16_t scheduler_cpuLoad1s;					///< Obciazenie procesora w ostatniej sekundzie [0,1%]
+extern uint16_t scheduler_cpuLoad10s;					///< Obciazenie procesora w ostatnich SCHEDULER_LOAD_LONG_WINDOW sekundach [0,1%]
+extern SCHEDULER_LATENCY scheduler_threadLatency;			///< Opoznienie rozpoczecia zadan watku glownego (ticki bez zaleglosci)
+extern SCHEDULER_LATENCY scheduler_isrLatency;				///< Opoznienie rozpoczecia zadan wykonywanych w przerwaniu PendSV
+
+// ******************************************************************************************************************************************************** //
+
+extern uint8_t scheduler_init(const SCHEDULER_TASK *table, uint8_t taskCnt);
+extern void scheduler_step(void);
+extern void scheduler_isrStep(void);
+extern uint32_t scheduler_getReleaseCnt(void);
@@ -0,0 +1,113 @@
+/**
+* @file speed_estimator.c
+* @brief Estymator predkosci (filtr alfa-beta) wyznaczajacy predkosc pomiedzy ramkami telemetrii
+* @details Biblioteka nie korzysta z HAL (czas jest przekazywany w argumentach), dzieki czemu moze zostac
+* skompilowana na komputerze i sprawdzona na zapisanych przebiegach predkosci (Tools/speed_estimator_sim).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include "speed_estimator.h"
+
+// ******************************************************************************************************************************************************** //
+
+static uint8_t initialized;			///< Flaga informujaca o otrzymaniu pierwszej probki
+static float estSpeed;				///< Estymowana predkosc w chwili ostatniej probki [km/h]
+static float estAcceleration;			///< Estymowane przyspieszenie [km/h/ms]
+static float lastSample;			///< Ostatnia zmierzona predkosc [km/h]
+static uint32_t lastTimestamp;			///< Czas ostatniej probki [ms]
+static uint32_t samplePeriod;			///< Odstep pomiedzy dwiema ostatnimi probkami [ms]
+static float blendStart;			///< Wynik w chwili odebrania ostatniej probki, od ktorego wynik przechodzi do nowej estymaty przez samplePeriod
+
+// ******************************************************************************************************************************************************** //
+
+static float extrapolate(uint32_t dt);
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @fn speed_estimator_reset(void)
+* @brief Zerowanie estymatora (np. po zerwaniu transmisji)
+*/
+void speed_estimator_reset(void)
+{
+  initialized = 0;
+  estSpeed = 0.0f;
+  estAcceleration = 0.0f;
+  lastSample = 0.0f;
+  blendStart = 0.0f;
+  samplePeriod = 0;
+}
+
+/**
+* @fn speed_estimator_addSample(float speed, uint32_t timestamp)
+* @brief Korekcja estymatora nowa probka predkosci, wywolac po odebraniu kazdej ramki telemetrii
+*/
+void speed_estimator_addSample(float speed, uint32_t timestamp)
+{
+  uint32_t dt = timestamp - lastTimestamp;
+  float previousOutput = speed_estimator_getSpeed(timestamp);
+
+  //Pierwsza probka lub zbyt dluga przerwa - rozpocznij od zmierzonej wartosci
+  if (!initialized || (dt == 0) || (dt > SPEED_ESTIMATOR_MAX_SAMPLE_PERIOD))
+    {
+      estSpeed = speed;
+      estAcceleration = 0.0f;
+      samplePeriod = initialized ? SPEED_ESTIMATOR_MAX_EXTRAPOLATION : 0;
+    }
+  else
+    {
+      float predicted = estSpeed + estAcceleration * dt;
+      float residual = speed - predicted;
+
+      estSpeed = predicted + SPEED_ESTIMATOR_ALPHA * residual;
+      estAcceleration += SPEED_ESTIMATOR_BETA * residual / dt;
+      samplePeriod = dt;
+    }
+
+  //Wynik przechodzi do nowej estymaty plynnie w ciagu jednego okresu probkowania, zamiast skakac w chwili odebrania ramki
+  blendStart = previousOutput;
+  initialized = 1;
+  lastSample = speed;
+  lastTimestamp = timestamp;
+}
+
+/**
+* @fn speed_estimator_getSpeed(uint32_t now)
+* @brief Predkosc ekstrapolowana na chwile now, ograniczona do SPEED_ESTIMATOR_MAX_OVERSHOOT od ostatniej probki
+* @details W chwili odebrania probki wynik jest rowny poprzedniemu, w ciagu samplePeriod przechodzi liniowo do ograniczonej estymaty,
+* dzieki czemu przez caly czas lezy pomiedzy poprzednim wynikiem a zakresem +-SPEED_ESTIMATOR_MAX_OVERSHOOT od ostatniej probki.
+*/
+float speed_estimator_getSpeed(uint32_t now)
+{
+  if (!initialized) return 0.0f;
+
+  uint32_t dt = now - lastTimestamp;
+
+  if (dt > SPEED_ESTIMATOR_MAX_EXTRAPOLATION) dt = SPEED_ESTIMATOR_MAX_EXTRAPOLATION;
+
+  float speed = extrapolate(dt);
+
+  if (dt < samplePeriod) speed = blendStart + (speed - blendStart) * dt / samplePeriod;
+
+  if (speed < 0.0f) speed = 0.0f;
+
+  return speed;
+}
+
+/**
+* @fn extrapolate(uint32_t dt)
+* @brief Estymata dt ms po ostatniej probce, ograniczona do SPEED_ESTIMATOR_MAX_OVERSHOOT od tej probki
+*/
+static float extrapolate(uint32_t dt)
+{
+  float speed = estSpeed + estAcceleration * dt;
+
+  if (speed > lastSample + SPEED_ESTIMATOR_MAX_OVERSHOOT) speed = lastSample + SPEED_ESTIMATOR_MAX_OVERSHOOT;
+  if (speed < lastSample - SPEED_ESTIMATOR_MAX_OVERSHOOT) speed = lastSample - SPEED_ESTIMATOR_MAX_OVERSHOOT;
+
+  return speed;
+}
@@ -0,0 +1,26 @@
+/**
+* @file speed_estimator.h
+* @brief Estymator predkosci (filtr alfa-beta) wyznaczajacy predkosc pomiedzy ramkami telemetrii
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+#pragma once
+
+#include <stdint-gcc.h>
+
+// ******************************************************************************************************************************************************** //
+
+#define SPEED_ESTIMATOR_ALPHA			0.8f			///< Wzmocnienie korekcji predkosci
+#define SPEED_ESTIMATOR_BETA			0.2f			///< Wzmocnienie korekcji przyspieszenia
+#define SPEED_ESTIMATOR_MAX_SAMPLE_PERIOD	1000			///< Dluzsza przerwa miedzy probkami powoduje reset filtru [ms]
+#define SPEED_ESTIMATOR_MAX_EXTRAPOLATION	500			///< Maksymalny czas ekstrapolacji od ostatniej probki [ms]
+#define SPEED_ESTIMATOR_MAX_OVERSHOOT		2.0f			///< Maksymalne odchylenie wyniku od ostatniej probki [km/h]
+
+// ******************************************************************************************************************************************************** //
+
+extern void speed_estimator_reset(void);
+extern void speed_estimator_addSample(float speed, uint32_t timestamp);
+extern float speed_estimator_getSpeed(uint32_t now);
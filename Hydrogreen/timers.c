@@ -12,27 +12,24 @@
 #include "leds.h"
 #include "tim.h"
 #include "hydrogreen.h"
+#include "profiler.h"
+#include "trace.h"
 
 // ******************************************************************************************************************************************************** //
 
-static volatile uint32_t timers_sysCycle100kHzCnt;		///< Licznik tickow zegara nastepujacych z czestotliwoscia 100kHz
-volatile uint8_t timers_tick1kHz; 				///< Flaga ustawiana co okres T = 1ms
-volatile uint8_t timers_tick10kHz; 				///< Flaga ustawiana co okres T = 0,1ms
-volatile uint8_t timers_mainTimeHours; 				///< Czas pracy systemu - liczba godzin
-volatile uint8_t timers_mainTimeMinutes; 			///< Czas pracy systemu - liczba minut
-volatile uint8_t timers_mainTimeSeconds; 			///< Czas pracy systemu - liczba sekund
-volatile uint16_t timers_mainTimeMiliseconds; 			///< Czas pracy systemu - liczba milisekund
-uint32_t timers_minSysCyclePeriod;				///< Minimalny czas trwania petli hydrogreen_step()
-uint32_t timers_maxSysCyclePeriod;				///< Maksymalny czas trwania petli hydrogreen_step()
-uint32_t timers_avgSysCyclePeriod;				///< Sredni czas trwania petli hydrogreen_step()
+static uint32_t stepStartCycles;				///< Wartosc licznika cykli na poczatku ticku planisty
+volatile uint32_t timers_tick10kHzCnt; 			///< Licznik tickow o okresie T = 0,1ms (nie jest zerowany, przepelnia sie)
+static volatile uint32_t usOverflowCnt;				///< Liczba przepelnien 32-bitowego licznika TIM2 (starsze slowo zegara us)
+uint32_t timers_minSysCyclePeriod;				///< Minimalny czas wykonania zadan jednego ticku planisty
+uint32_t timers_maxSysCyclePeriod;				///< Maksymalny czas wykonania zadan jednego ticku planisty
+uint32_t timers_avgSysCyclePeriod;				///< Sredni czas wykonania zadan jednego ticku planisty
 
 // ******************************************************************************************************************************************************** //
 
-static inline void timers_step(void);
-static inline void setSystemOperatingTime(void);
 void timers_init(void);
-void timers_beforeStep1kHz(void);
-void timers_afterStep1kHz(void);
+void timers_beforeStep(void);
+void timers_afterStep(void);
+uint16_t timers_getTickPhase(void);
 
 // ******************************************************************************************************************************************************** //
 
@@ -42,81 +39,90 @@ void timers_afterStep1kHz(void);
 */
 void timers_init(void)
 {
-  HAL_TIM_Base_Start_IT(&htim6);		//Inicjalizuj TIM6 pracujacy z czestotliwoscia 10kHz
-  HAL_TIM_Base_Start_IT(&htim7);		//Inicjalizuj TIM7 pracujacy z czestotliwoscia 100kHz
-}
-/**
-* @fn timers_main(void)
-* @brief Glowna funkcja odpowiadajaca za interwaly czasowe wykorzystywane w systemie
-*/
-static inline void timers_step(void)
-{
-  timers_tick1kHz = 1;
+  profiler_init();				//Pomiar czasu wykonania licznikiem cykli rdzenia
 
-  setSystemOperatingTime();
+  //HAL_TIM_Base_Init() generuje zdarzenie aktualizacji, ktore nie jest przepelnieniem licznika
+  __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_UPDATE);
+  HAL_TIM_Base_Start_IT(&htim2);		//Inicjalizuj 32-bitowy TIM2 zliczajacy mikrosekundy
+  HAL_TIM_Base_Start_IT(&htim6);		//Inicjalizuj TIM6 pracujacy z czestotliwoscia 10kHz
 }
 
 /**
-* @fn setSystemOperatingTime(void)
-* @brief Funkcja przeliczajaca czas pracy systemu na milisekundy, sekundy, minuty oraz godziny
+* @fn timers_getUs(void)
+* @brief Czas pracy systemu [us], monotoniczny zegar 64-bitowy (TIM2 + licznik przepelnien), mozna wywolywac rowniez w przerwaniach
+* @details Odczyt bez blokowania przerwan: jezeli w trakcie odczytu nastapilo przepelnienie obsluzone w przerwaniu, odczyt jest powtarzany.
+* Przepelnienie jeszcze nieobsluzone (wywolanie przy wylaczonych przerwaniach lub z przerwania o wyzszym priorytecie)
+* jest rozpoznawane po fladze UIF i malej wartosci licznika.
 */
-static inline void setSystemOperatingTime(void)
+uint64_t timers_getUs(void)
 {
-  timers_mainTimeMiliseconds++;
+  uint32_t overflowCnt;
+  uint32_t high;
+  uint32_t low;
 
-  //Sekundy
-  if (timers_mainTimeMiliseconds >= PERIOD_1S)
+  do
     {
-      timers_mainTimeMiliseconds = 0;
-      timers_mainTimeSeconds++;
+      overflowCnt = usOverflowCnt;
+      low = __HAL_TIM_GET_COUNTER(&htim2);
+      high = overflowCnt;
+
+      if ( (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET) && (low < 0x80000000UL) )
+	{
+	  high++;
+	}
     }
+  while (overflowCnt != usOverflowCnt);
 
-  //Minuty
-  if (timers_mainTimeSeconds >= 60)
-    {
-      timers_mainTimeSeconds = 0;
-      timers_mainTimeMinutes++;
-    }
+  return ((uint64_t)high << 32) | low;
+}
 
-  //Godziny
-  if (timers_mainTimeMinutes >= 60)
-    {
-      timers_mainTimeMinutes = 0;
-      timers_mainTimeHours++;
-    }
+/**
+* @fn timers_getUptime(TIMERS_UPTIME *uptime)
+* @brief Czas pracy systemu w godzinach, minutach, sekundach i milisekundach, przeliczany dopiero przy odczycie
+*/
+void timers_getUptime(TIMERS_UPTIME *uptime)
+{
+  uint32_t ms = timers_getUs() / 1000;		//Wystarcza na 49 dni pracy
+
+  uptime->miliseconds = ms % 1000;
+  ms /= 1000;
+  uptime->seconds = ms % 60;
+  ms /= 60;
+  uptime->minutes = ms % 60;
+  uptime->hours = ms / 60;
 }
 
 /**
-* @fn timers_beforeStep1kHz(void)
-* @brief Funkcja sluzaca do obliczania czasu trwania petli hydrogreen_step(), wywolac przed hydrogreen_step()
+* @fn timers_beforeStep(void)
+* @brief Funkcja sluzaca do obliczania czasu wykonania zadan jednego ticku planisty, wywolac przed zadaniami
 */
-void timers_beforeStep1kHz(void)
+void timers_beforeStep(void)
 {
-  timers_sysCycle100kHzCnt = 0;
+  stepStartCycles = profiler_getCycles();
+  TRACE(TRACE_STEP_BEGIN, 0);
 }
 
 /**
-* @fn timers_afterStep1kHz(void)
-* @brief Funkcja sluzaca do obliczania czasu trwania petli hydrogreen_step(), wywolac po hydrogreen_step()
+* @fn timers_afterStep(void)
+* @brief Funkcja sluzaca do obliczania czasu wykonania zadan jednego ticku planisty, wywolac po zadaniach
 */
-void timers_afterStep1kHz(void)
+void timers_afterStep(void)
 {
   static uint8_t initFlag;
   static uint32_t actSysCyclePeriod;
   static uint32_t avgSysCyclePeriodSum;
   static uint16_t avgCnt;
 
+  TRACE(TRACE_STEP_END, 0);
+  actSysCyclePeriod = profiler_cyclesToUs(profiler_getCycles() - stepStartCycles);
+
   //Warunek wykorzystywany przy inicjalizacji systemu (tylko raz)
   if (!initFlag)
     {
-      timers_minSysCyclePeriod = 10 * timers_sysCycle100kHzCnt;
+      timers_minSysCyclePeriod = actSysCyclePeriod;
       initFlag = 1;
     }
 
-  actSysCyclePeriod = 10 * timers_sysCycle100kHzCnt; //Przeliczenie otrzymanej wartosci na mikrosekundy
-
-  timers_sysCycle100kHzCnt = 0;
-
   //Oblicz sredni czas trwania cyklu ze 100 probek
   if (avgCnt <= 100)
     {
@@ -143,20 +149,28 @@ void timers_afterStep1kHz(void)
     }
 }
 
-void HAL_SYSTICK_Callback(void)
+/**
+* @fn timers_getTickPhase(void)
+* @brief Czas jaki uplynal od ostatniego ticku 10kHz [us] (licznik TIM6 taktowany 1MHz)
+*/
+uint16_t timers_getTickPhase(void)
 {
-  timers_step();
+  return __HAL_TIM_GET_COUNTER(&htim6);
 }
 
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
-  if (htim->Instance == TIM6)
+  if (htim->Instance == TIM2)
     {
-      timers_tick10kHz = 1;
+      usOverflowCnt++;
+      TRACE(TRACE_US_OVERFLOW, usOverflowCnt);
     }
 
-  if (htim->Instance == TIM7)
+  if (htim->Instance == TIM6)
     {
-      timers_sysCycle100kHzCnt++;
+      timers_tick10kHzCnt++;
+
+      //Zadania RS-485 wykonywane sa w PendSV, zaraz po zakonczeniu tego przerwania
+      SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
     }
 }
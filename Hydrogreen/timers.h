@@ -13,21 +13,32 @@
 
 // ******************************************************************************************************************************************************** //
 
+/**
+* @struct TIMERS_UPTIME
+* @brief Czas pracy systemu rozbity na jednostki (timers_getUptime())
+*/
+typedef struct
+{
+  uint16_t hours;
+  uint8_t minutes;
+  uint8_t seconds;
+  uint16_t miliseconds;
+} TIMERS_UPTIME;
+
+// ******************************************************************************************************************************************************** //
+
 extern void timers_init(void);
-extern void timers_main(void);
-extern void timers_beforeStep1kHz(void);
-extern void timers_afterStep1kHz(void);
+extern uint64_t timers_getUs(void);
+extern void timers_getUptime(TIMERS_UPTIME *uptime);
+extern void timers_beforeStep(void);
+extern void timers_afterStep(void);
+extern uint16_t timers_getTickPhase(void);
 
 // ******************************************************************************************************************************************************** //
 
 extern volatile uint8_t timers_tick500Hz; 		///< Flaga ustawiana co okres T = 2ms
-extern volatile uint8_t timers_tick1kHz; 		///< Flaga ustawiana co okres T = 1ms, wykorzystywana przy obiegu glownej petli programu
-extern volatile uint8_t timers_tick10kHz; 		///< Flaga ustawiana co okres T = 0,1ms
-extern volatile uint8_t timers_mainTimeHours; 		///< Czas pracy systemu - liczba godzin
-extern volatile uint8_t timers_mainTimeMinutes; 	///< Czas pracy systemu - liczba minut
-extern volatile uint8_t timers_mainTimeSeconds; 	///< Czas pracy systemu - liczba sekund
-extern volatile uint16_t timers_mainTimeMiliseconds; 	///< Czas pracy systemu - liczba milisekund
-
-extern uint32_t timers_minSysCyclePeriod;		///< Minimalny zanotowany czas trwania petli hydrogreen_step1kHz()
-extern uint32_t timers_maxSysCyclePeriod;		///< Maksymalny zanotowany czas trwania petli hydrogreen_step1kHz()
-extern uint32_t timers_avgSysCyclePeriod;		///< Sredni czas trwania petli hydrogreen_step1kHz()
+extern volatile uint32_t timers_tick10kHzCnt; 		///< Licznik tickow o okresie T = 0,1ms, tick planisty (scheduler.c)
+
+extern uint32_t timers_minSysCyclePeriod;		///< Minimalny zanotowany czas wykonania zadan jednego ticku planisty [us]
+extern uint32_t timers_maxSysCyclePeriod;		///< Maksymalny zanotowany czas wykonania zadan jednego ticku planisty [us]
+extern uint32_t timers_avgSysCyclePeriod;		///< Sredni czas wykonania zadan jednego ticku planisty [us]
@@ -0,0 +1,94 @@
+/**
+* @file trace.c
+* @brief Bufor zdarzen (flight recorder) ze znacznikami czasu licznika cykli DWT, zrzucany przez UART i dekodowany na komputerze
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include "trace.h"
+#include "usart.h"
+#include "iwdg.h"
+
+// ******************************************************************************************************************************************************** //
+
+#define UART_PORT_TRACE			huart2					///< UART zrzutu (RS-485, odczyt konwerterem USB-RS485)
+
+// ******************************************************************************************************************************************************** //
+
+TRACE_BUFFER trace_buffer __attribute__((section(".ccmram")));			///< Bufor zdarzen, sekcja CCMRAM nie jest zerowana przy starcie
+volatile uint8_t trace_frozen;							///< 1 - rejestrowanie wstrzymane
+static volatile uint32_t dumpRequest __attribute__((section(".ccmram")));	///< TRACE_DUMP_REQUEST - bufor nalezy wyslac po resecie
+
+// ******************************************************************************************************************************************************** //
+
+static void sendDump(void);
+
+// ******************************************************************************************************************************************************** //
+
+/**
+* @fn trace_init(void)
+* @brief Wyslanie zrzutu zleconego przed resetem oraz wyczyszczenie bufora zdarzen, umiescic na poczatku hydrogreen_init()
+* (przed uruchomieniem przerwan i wymiany danych RS-485)
+*/
+void trace_init(void)
+{
+  //Zawartosc CCMRAM po wlaczeniu zasilania jest przypadkowa, zrzut wymaga rowniez poprawnego naglowka bufora
+  uint8_t dumpPending = (dumpRequest == TRACE_DUMP_REQUEST) && (trace_buffer.magic == TRACE_MAGIC);
+
+  dumpRequest = 0;
+
+  if (dumpPending)
+    {
+      sendDump();
+    }
+  trace_buffer.magic = TRACE_MAGIC;
+  trace_buffer.version = TRACE_VERSION;
+  trace_buffer.size = TRACE_SIZE;
+  trace_buffer.coreClock = SystemCoreClock;
+  trace_buffer.head = 0;
+}
+
+/**
+* @fn trace_dump(void)
+* @brief Zlecenie zrzutu bufora i reset programowy, mozna wywolac w dowolnym kontekscie (HardFault_Handler(), Error_Handler())
+* @details Rejestrowanie jest wstrzymywane, a w CCMRAM (sekcja nie jest zerowana przy starcie) zapisywany jest znacznik zrzutu.
+* Bufor wysyla trace_init() po resecie, zanim ruszy planista i wymiana danych RS-485, dzieki czemu zrzut nie miesza sie
+* z ramkami wysylanymi w przerwaniu PendSV. Bufor mozna rowniez odczytac debuggerem: dump binary value trace.bin trace_buffer (gdb),
+* oba pliki dekoduje Tools/trace_decoder.
+*/
+void trace_dump(void)
+{
+  trace_frozen = 1;
+  dumpRequest = TRACE_DUMP_REQUEST;
+
+  NVIC_SystemReset();
+}
+
+/**
+* @fn sendDump(void)
+* @brief Wyslanie calego bufora przez UART_PORT_TRACE porcjami po TRACE_DUMP_CHUNK bajtow
+* @details Zrzut trwa ok. 360ms przy 57600 bit/s, dluzej niz okres IWDG (150ms), dlatego watchdog jest przeladowywany po kazdej porcji.
+*/
+static void sendDump(void)
+{
+  const uint8_t *data = (const uint8_t*)&trace_buffer;
+
+  for (uint32_t sent = 0; sent < sizeof(trace_buffer); sent += TRACE_DUMP_CHUNK)
+    {
+      uint32_t size = sizeof(trace_buffer) - sent;
+
+      if (size > TRACE_DUMP_CHUNK) size = TRACE_DUMP_CHUNK;
+
+      HAL_IWDG_Refresh(&hiwdg);
+
+      if (HAL_UART_Transmit(&UART_PORT_TRACE, (uint8_t*)&data[sent], size, TRACE_DUMP_CHUNK_TIMEOUT) != HAL_OK)
+	{
+	  break;
+	}
+    }
+
+  HAL_IWDG_Refresh(&hiwdg);
+}
@@ -0,0 +1,163 @@
+/**
+* @file trace.h
+* @brief Bufor zdarzen (flight recorder) ze znacznikami czasu licznika cykli DWT, zrzucany przez UART i dekodowany na komputerze
+* @details Zdarzenie zajmuje 8 bajtow: czas [cykl], identyfikator, numer aktywnego wyjatku (IPSR) i 16-bitowy argument.
+* Bufor jest nadpisywany po zapelnieniu, zawsze zawiera TRACE_SIZE ostatnich zdarzen. Zapis trwa kilkanascie cykli
+* (przerwania wylaczone tylko na czas zapisu jednego wpisu), dlatego rejestrowanie moze pozostac wlaczone w wersji wyscigowej.
+* Identyfikatory zgrupowane sa w klasy po 32, klasy wylaczone w TRACE_CLASSES nie generuja zadnego kodu.
+* Zdarzenia o nazwie zakonczonej _BEGIN/_END tworza odcinki czasu, _STATE wartosc zmiennej w czasie, pozostale sa chwilowe
+* (konwencja wykorzystywana przez Tools/trace_decoder, ktory przy kompilacji z -DTRACE_HOST korzysta z tej samej listy zdarzen).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+#pragma once
+
+#include <stdint.h>
+
+#ifndef TRACE_HOST
+#include "profiler.h"
+#endif
+
+// ******************************************************************************************************************************************************** //
+
+#define TRACE_ENABLE							///< Rejestrowanie zdarzen, bez tej definicji makro TRACE() nie generuje kodu
+#define TRACE_SIZE			256				///< Liczba zdarzen w buforze (potega 2), bufor zajmuje TRACE_SIZE * 8 bajtow w CCMRAM
+#define TRACE_MAGIC			0x52544748			///< "HGTR", poczatek zrzutu
+#define TRACE_VERSION			1				///< Wersja formatu zrzutu
+#define TRACE_DUMP_REQUEST		0x504D5544			///< "DUMP", znacznik zrzutu zleconego przed resetem (CCMRAM)
+#define TRACE_DUMP_CHUNK		64				///< Bajty wysylane pomiedzy przeladowaniami IWDG (ok. 11ms przy 57600 bit/s)
+#define TRACE_DUMP_CHUNK_TIMEOUT	50				///< Maksymalny czas wysylania jednej porcji zrzutu [ms]
+
+#define TRACE_CLASS_TICK		(1 << 0)			///< Zdarzenia kazdego ticku planisty (10kHz), bufor obejmuje wtedy ok. 6ms
+#define TRACE_CLASS_ISR			(1 << 1)			///< Pozostale przerwania (UART, DMA, TIM2)
+#define TRACE_CLASS_RS485		(1 << 2)			///< Ramki RS-485
+#define TRACE_CLASS_LCD			(1 << 3)			///< Obsluga wyswietlacza
+#define TRACE_CLASSES			(TRACE_CLASS_ISR | TRACE_CLASS_RS485 | TRACE_CLASS_LCD)	///< Klasy rejestrowanych zdarzen
+
+/**
+* @def TRACE_EVENT_LIST(X)
+* @brief Lista zdarzen X(nazwa, identyfikator), klasa zdarzenia to identyfikator / 32
+*/
+#define TRACE_EVENT_LIST(X)						\
+  X(TRACE_TIM6_BEGIN,			0x00)			\
+  X(TRACE_TIM6_END,			0x01)			\
+  X(TRACE_PENDSV_BEGIN,			0x02)			\
+  X(TRACE_PENDSV_END,			0x03)			\
+  X(TRACE_STEP_BEGIN,			0x04)			\
+  X(TRACE_STEP_END,			0x05)			\
+  X(TRACE_TIM2_BEGIN,			0x20)			\
+  X(TRACE_TIM2_END,			0x21)			\
+  X(TRACE_USART1_BEGIN,			0x22)			\
+  X(TRACE_USART1_END,			0x23)			\
+  X(TRACE_USART2_BEGIN,			0x24)			\
+  X(TRACE_USART2_END,			0x25)			\
+  X(TRACE_DMA1_CH4_BEGIN,		0x26)			\
+  X(TRACE_DMA1_CH4_END,			0x27)			\
+  X(TRACE_US_OVERFLOW,			0x28)			\
+  X(TRACE_EXTI_BEGIN,			0x29)			\
+  X(TRACE_EXTI_END,			0x2A)			\
+  X(TRACE_BUTTON_EDGE,			0x2B)			\
+  X(TRACE_RS485_FRAME_OK,		0x40)			\
+  X(TRACE_RS485_FRAME_BAD,		0x41)			\
+  X(TRACE_RS485_LINK_LOST,		0x42)			\
+  X(TRACE_RS485_RX_OVERFLOW,		0x43)			\
+  X(TRACE_RS485_TX_FRAME,		0x44)			\
+  X(TRACE_RS485_SYNC,			0x45)			\
+  X(TRACE_LCD_STEP_BEGIN,		0x60)			\
+  X(TRACE_LCD_STEP_END,			0x61)			\
+  X(TRACE_LCD_PAGE_STATE,		0x62)			\
+  X(TRACE_LCD_INIT_STATE,		0x63)			\
+  X(TRACE_LCD_LINK_LOST,		0x64)			\
+  X(TRACE_LCD_FLUSH,			0x65)
+
+// ******************************************************************************************************************************************************** //
+
+#define TRACE_ID_ENUM(name, id)		name = id,
+
+/**
+* @enum TRACE_ID
+* @brief Identyfikatory zdarzen
+*/
+typedef enum
+{
+  TRACE_EVENT_LIST(TRACE_ID_ENUM)
+} TRACE_ID;
+
+/**
+* @struct TRACE_EVENT
+* @brief Wpis bufora zdarzen
+*/
+typedef struct
+{
+  uint32_t cycles;			///< Licznik cykli DWT w chwili zdarzenia
+  uint8_t id;				///< TRACE_ID
+  uint8_t exception;			///< Numer aktywnego wyjatku (0 - watek glowny, 14 - PendSV, 16 + n - przerwanie n)
+  uint16_t arg;				///< Argument zdarzenia
+} TRACE_EVENT;
+
+/**
+* @struct TRACE_BUFFER
+* @brief Bufor zdarzen, zrzut przez UART to kopia tej struktury (little endian)
+*/
+typedef struct
+{
+  uint32_t magic;			///< TRACE_MAGIC
+  uint16_t version;			///< TRACE_VERSION
+  uint16_t size;			///< TRACE_SIZE
+  uint32_t coreClock;			///< Czestotliwosc licznika cykli [Hz]
+  volatile uint32_t head;		///< Liczba wszystkich zapisanych zdarzen, najstarsze w buforze ma numer head - min(head, size)
+  TRACE_EVENT events[TRACE_SIZE];
+} TRACE_BUFFER;
+
+// ******************************************************************************************************************************************************** //
+
+#ifndef TRACE_HOST
+
+extern TRACE_BUFFER trace_buffer;		///< Bufor zdarzen (CCMRAM)
+extern volatile uint8_t trace_frozen;		///< 1 - rejestrowanie wstrzymane (np. na czas zrzutu)
+
+extern void trace_init(void);
+extern void trace_dump(void);
+
+/**
+* @def TRACE(id, arg)
+* @brief Zapis zdarzenia, mozna wywolywac w dowolnym kontekscie (rowniez w przerwaniach)
+*/
+#ifdef TRACE_ENABLE
+#define TRACE(id, arg)		do { if (TRACE_CLASSES & (1 << ((id) >> 5))) trace_record((id), (arg)); } while (0)
+#else
+#define TRACE(id, arg)		do { } while (0)
+#endif
+
+/**
+* @fn trace_record(uint8_t id, uint16_t arg)
+* @brief Zapis zdarzenia do bufora, wywolywac przez makro TRACE()
+* @details Pozycja w buforze i znacznik czasu pobierane sa przy wylaczonych przerwaniach, dzieki czemu kolejnosc wpisow
+* jest zgodna z kolejnoscia znacznikow czasu rowniez gdy zapis zostanie wywlaszczony przez inne przerwanie.
+*/
+static inline void trace_record(uint8_t id, uint16_t arg)
+{
+  if (trace_frozen)
+    {
+      return;
+    }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint32_t head = trace_buffer.head;
+  TRACE_EVENT *event = &trace_buffer.events[head & (TRACE_SIZE - 1)];
+
+  event->cycles = profiler_getCycles();
+  event->id = id;
+  event->exception = __get_IPSR();
+  event->arg = arg;
+  trace_buffer.head = head + 1;
+
+  __set_PRIMASK(primask);
+}
+
+#endif
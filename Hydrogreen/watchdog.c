@@ -52,7 +52,7 @@ void watchdog_init(void)
 
 /**
 * @fn watchdog_step(void)
-* @brief Funkcja przeladowujaca IWDG, powinna zostac wywolana wewnatrz hydrogreen_step()
+* @brief Funkcja przeladowujaca IWDG, zadanie planisty (tabela tasks[] w hydrogreen.c)
 */
 inline void watchdog_step(void)
 {
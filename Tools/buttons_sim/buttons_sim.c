@@ -0,0 +1,211 @@
+/**
+* @file buttons_sim.c
+* @brief Test filtracji przyciskow (Hydrogreen/buttons.c) z drganiami styku, uruchamiany na komputerze
+* @details Test laczy buttons.c z zastepczymi naglowkami main.h i gpio.h (rejestry IDR portow A i B). Czas plynie w krokach 1us,
+* co 1ms wywolywane jest buttons_step() (jak zadanie planisty), kazda zmiana pinu przycisku zglaszajacego zbocza wywoluje
+* HAL_GPIO_EXTI_Callback() (jak przerwanie EXTI). Scenariusze dla HALF_GAS (czas filtracji 4ms):
+* - czyste wcisniecie: zmiana stanu po czasie filtracji, czas zmiany rowny czasowi zbocza,
+* - wcisniecie i zwolnienie z drganiami styku: brak zaklocen w buttons_glitchCnt, czas zmiany stanu i czas od zbocza do zmiany stanu
+*   liczone od pierwszego zbocza drgan do probki, w ktorej zmienil sie stan,
+* - impuls krotszy od czasu filtracji: jedno zaklocenie, stan bez zmian, kolejne wcisniecie mierzone od wlasnego zbocza.
+* Kod wyjscia 1 oznacza niespelnienie ktoregos z warunkow. Kompilacja:
+*
+*   gcc -std=gnu99 -O2 -Wall -DTRACE_HOST -I. -I.. -I../../Hydrogreen -I../../External_libraries -o buttons_sim buttons_sim.c
+*       ../../Hydrogreen/buttons.c
+*
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <stdio.h>
+#include "buttons.h"
+#include "timers.h"
+#include "gestures.h"
+#include "host_check.h"
+
+#define STEP_PERIOD_US		1000		///< Okres wywolywania buttons_step() [us]
+#define HALF_GAS_DEBOUNCE_MS	4		///< Czas filtracji HALF_GAS (tabela config[] w buttons.c) [ms]
+#define BOUNCE_PERIOD_US	700		///< Odstep kolejnych zboczy drgan styku [us]
+#define BOUNCE_EDGES		7		///< Liczba zboczy drgan (nieparzysta, ostatnie ustala nowy stan)
+
+GPIO_TypeDef sim_gpioA = { .IDR = 0xFFFF };	///< Przyciski zwieraja wejscie do masy, 1 - zwolniony
+GPIO_TypeDef sim_gpioB = { .IDR = 0xFFFF };
+
+static uint64_t simUs;
+static uint32_t stateChangeUs;		///< Czas probki, w ktorej zmienil sie stan HALF_GAS [us]
+
+// ******************************************************************************************************************************************************** //
+
+static void runUs(uint32_t us);
+static void setPin(uint32_t mask, uint8_t pressed);
+static void bounce(uint32_t mask, uint8_t pressed);
+static uint8_t bitOf(uint32_t mask);
+static void scenarioClean(void);
+static void scenarioBounce(void);
+static void scenarioGlitch(void);
+
+// ******************************************************************************************************************************************************** //
+
+int main(void)
+{
+  buttons_init();
+
+  //Poczatek symulacji w polowie okresu, zbocza nie pokrywaja sie z probkami
+  runUs(STEP_PERIOD_US / 2);
+
+  scenarioClean();
+  scenarioBounce();
+  scenarioGlitch();
+
+  return host_check_result();
+}
+
+/**
+* @fn scenarioClean(void)
+* @brief Wcisniecie i zwolnienie bez drgan
+*/
+static void scenarioClean(void)
+{
+  uint32_t edgeUs = (uint32_t)simUs;
+
+  setPin(BUTTONS_HALF_GAS, 1);
+  runUs(HALF_GAS_DEBOUNCE_MS * STEP_PERIOD_US + STEP_PERIOD_US);
+
+  host_check(BUTTONS.halfGas == 1, "clean: pressed", "%6.0f", BUTTONS.halfGas);
+  host_check(buttons_getChangeUs(bitOf(BUTTONS_HALF_GAS)) == edgeUs, "clean: change time is edge time", "%6.0f us",
+	     buttons_getChangeUs(bitOf(BUTTONS_HALF_GAS)) - edgeUs);
+  host_check(buttons_edgeLatency <= HALF_GAS_DEBOUNCE_MS * STEP_PERIOD_US, "clean: edge latency", "%6.0f us", buttons_edgeLatency);
+
+  setPin(BUTTONS_HALF_GAS, 0);
+  runUs(HALF_GAS_DEBOUNCE_MS * STEP_PERIOD_US + STEP_PERIOD_US);
+
+  host_check(BUTTONS.halfGas == 0, "clean: released", "%6.0f", BUTTONS.halfGas);
+  host_check(buttons_glitchCnt == 0, "clean: glitches", "%6.0f", buttons_glitchCnt);
+}
+
+/**
+* @fn scenarioBounce(void)
+* @brief Wcisniecie i zwolnienie z drganiami styku, czas mierzony od pierwszego zbocza
+*/
+static void scenarioBounce(void)
+{
+  static const uint8_t states[] = { 1, 0 };
+
+  for (uint8_t i = 0; i < sizeof(states); i++)
+    {
+      uint8_t pressed = states[i];
+      const char *name = pressed ? "bounce press" : "bounce release";
+      uint32_t edgeUs = (uint32_t)simUs;
+      char label[48];
+
+      bounce(BUTTONS_HALF_GAS, pressed);
+      runUs(HALF_GAS_DEBOUNCE_MS * STEP_PERIOD_US + STEP_PERIOD_US);
+
+      uint32_t latency = buttons_edgeLatency;
+
+      snprintf(label, sizeof(label), "%s: state", name);
+      host_check(BUTTONS.halfGas == pressed, label, "%6.0f", BUTTONS.halfGas);
+      snprintf(label, sizeof(label), "%s: glitches", name);
+      host_check(buttons_glitchCnt == 0, label, "%6.0f", buttons_glitchCnt);
+      snprintf(label, sizeof(label), "%s: change time is first edge", name);
+      host_check(buttons_getChangeUs(bitOf(BUTTONS_HALF_GAS)) == edgeUs, label, "%6.0f us",
+		 (double)(int32_t)(buttons_getChangeUs(bitOf(BUTTONS_HALF_GAS)) - edgeUs));
+      snprintf(label, sizeof(label), "%s: edge latency", name);
+      host_check(latency == stateChangeUs - edgeUs, label, "%6.0f us", latency);
+    }
+}
+
+/**
+* @fn scenarioGlitch(void)
+* @brief Impuls krotszy od czasu filtracji, nastepnie czyste wcisniecie
+*/
+static void scenarioGlitch(void)
+{
+  uint32_t glitches = buttons_glitchCnt;
+  uint8_t pressedMs = 0;
+
+  setPin(BUTTONS_HALF_GAS, 1);
+  runUs(STEP_PERIOD_US + STEP_PERIOD_US / 2);
+  setPin(BUTTONS_HALF_GAS, 0);
+
+  for (uint8_t ms = 0; ms < 3 * HALF_GAS_DEBOUNCE_MS; ms++)
+    {
+      runUs(STEP_PERIOD_US);
+      if (BUTTONS.halfGas) pressedMs++;
+    }
+
+  host_check(pressedMs == 0, "glitch: state unchanged", "%6.0f ms", pressedMs);
+  host_check(buttons_glitchCnt == glitches + 1, "glitch: counted once", "%6.0f", buttons_glitchCnt - glitches);
+
+  uint32_t edgeUs = (uint32_t)simUs;
+
+  setPin(BUTTONS_HALF_GAS, 1);
+  runUs(HALF_GAS_DEBOUNCE_MS * STEP_PERIOD_US + STEP_PERIOD_US);
+
+  host_check(buttons_getChangeUs(bitOf(BUTTONS_HALF_GAS)) == edgeUs, "glitch: next press from its own edge", "%6.0f us",
+	     (double)(int32_t)(buttons_getChangeUs(bitOf(BUTTONS_HALF_GAS)) - edgeUs));
+
+  setPin(BUTTONS_HALF_GAS, 0);
+  runUs(HALF_GAS_DEBOUNCE_MS * STEP_PERIOD_US + STEP_PERIOD_US);
+}
+
+// ******************************************************************************************************************************************************** //
+
+uint64_t timers_getUs(void)
+{
+  return simUs;
+}
+
+void gestures_step(uint32_t changed)
+{
+  if (changed & BUTTONS_HALF_GAS) stateChangeUs = (uint32_t)simUs;
+}
+
+/**
+* @fn runUs(uint32_t us)
+* @brief Uplyw czasu, buttons_step() na kazdej granicy STEP_PERIOD_US
+*/
+static void runUs(uint32_t us)
+{
+  for (uint32_t i = 0; i < us; i++)
+    {
+      simUs++;
+      if (simUs % STEP_PERIOD_US == 0) buttons_step();
+    }
+}
+
+/**
+* @fn setPin(uint32_t mask, uint8_t pressed)
+* @brief Zmiana stanu pinu przycisku, przyciski zglaszajace zbocza wywoluja przerwanie EXTI
+*/
+static void setPin(uint32_t mask, uint8_t pressed)
+{
+  GPIO_TypeDef *port = (mask & 0xFFFF) ? GPIOA : GPIOB;
+  uint16_t pin = (mask & 0xFFFF) ? mask : (mask >> 16);
+
+  if (pressed) port->IDR &= ~pin;
+  else port->IDR |= pin;
+
+  if (mask & BUTTONS_EDGE_MASK) HAL_GPIO_EXTI_Callback(pin);
+}
+
+/**
+* @fn bounce(uint32_t mask, uint8_t pressed)
+* @brief BOUNCE_EDGES zboczy co BOUNCE_PERIOD_US, ostatnie ustala stan pressed
+*/
+static void bounce(uint32_t mask, uint8_t pressed)
+{
+  for (uint8_t i = 0; i < BOUNCE_EDGES; i++)
+    {
+      if (i > 0) runUs(BOUNCE_PERIOD_US);
+      setPin(mask, (i & 1) ? !pressed : pressed);
+    }
+}
+
+static uint8_t bitOf(uint32_t mask)
+{
+  return 31 - __CLZ(mask);
+}
@@ -0,0 +1,13 @@
+/**
+* @file gpio.h
+* @brief Zastepczy naglowek Core/Inc/gpio.h do kompilacji Hydrogreen/buttons.c na komputerze, porty sa zdefiniowane w main.h
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#pragma once
+
+#include "main.h"
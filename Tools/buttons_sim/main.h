@@ -0,0 +1,53 @@
+/**
+* @file main.h
+* @brief Zastepczy naglowek Core/Inc/main.h do kompilacji Hydrogreen/buttons.c na komputerze
+* @details Zawiera piny przyciskow (jak w Core/Inc/main.h), rejestry IDR portow A i B ustawiane przez buttons_sim.c oraz __CLZ().
+* Przy kompilacji z -DTRACE_HOST trace.h nie definiuje makra TRACE(), dlatego zdarzenia sa tutaj pomijane.
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define GPIO_PIN_0				((uint16_t)0x0001)
+#define GPIO_PIN_1				((uint16_t)0x0002)
+#define GPIO_PIN_4				((uint16_t)0x0010)
+#define GPIO_PIN_5				((uint16_t)0x0020)
+#define GPIO_PIN_6				((uint16_t)0x0040)
+#define GPIO_PIN_7				((uint16_t)0x0080)
+#define GPIO_PIN_8				((uint16_t)0x0100)
+#define GPIO_PIN_11				((uint16_t)0x0800)
+#define GPIO_PIN_12				((uint16_t)0x1000)
+
+#define MODE_1_BUTTON_Pin			GPIO_PIN_1
+#define FULL_GAS_BUTTON_Pin			GPIO_PIN_4
+#define HORN_BUTTON_Pin				GPIO_PIN_0
+#define MODE_2_BUTTON_Pin			GPIO_PIN_1
+#define SC_CLOSE_BUTTON_Pin			GPIO_PIN_8
+#define FUELCELL_RACE_MODE_BUTTON_Pin		GPIO_PIN_11
+#define HALF_GAS_BUTTON_Pin			GPIO_PIN_12
+#define FUELCELL_OFF_MODE_BUTTON_Pin		GPIO_PIN_4
+#define FUELCELL_PREPARETORACE_MODE_BUTTON_Pin	GPIO_PIN_5
+#define SUPPLY_BUTTON_Pin			GPIO_PIN_6
+#define SPEED_RESET_BUTTON_Pin			GPIO_PIN_7
+
+typedef struct
+{
+  volatile uint32_t IDR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpioA;
+extern GPIO_TypeDef sim_gpioB;
+
+#define GPIOA					(&sim_gpioA)
+#define GPIOB					(&sim_gpioB)
+
+extern void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+#define __CLZ(value)				((uint8_t)__builtin_clz(value))
+#define TRACE(id, arg)				do { } while (0)
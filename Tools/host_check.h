@@ -0,0 +1,53 @@
+/**
+* @file host_check.h
+* @brief Wspolne funkcje testow uruchamianych na komputerze (katalog Tools): sprawdzanie warunkow, wynik testu i kod wyjscia
+* @details Kazdy test jest jednym plikiem zrodlowym, dlatego funkcje sa statyczne. Warunek jest wypisywany razem ze zmierzona wartoscia
+* i wynikiem ok / FAIL, host_check_result() wypisuje OK lub FAILED i zwraca kod wyjscia (1 - niespelniony ktorys z warunkow).
+* Testy dolaczaja naglowek przez -I.. (katalog Tools).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+static uint8_t host_checkOk = 1;		///< 0 - ktorys z warunkow nie zostal spelniony
+
+/**
+* @fn host_check(uint8_t condition, const char *name, const char *format, double value)
+* @brief Wypisanie warunku i zmierzonej wartosci (format printf dla double), niespelniony warunek zmienia wynik testu
+*/
+static inline void host_check(uint8_t condition, const char *name, const char *format, double value)
+{
+  printf("%-40s ", name);
+  printf(format, value);
+  printf("  %s\n", condition ? "ok" : "FAIL");
+
+  host_checkOk &= condition;
+}
+
+/**
+* @fn host_check_usage(const char *program, const char *options)
+* @brief Opis wywolania przy blednych argumentach, zwraca kod wyjscia 2
+*/
+static inline int host_check_usage(const char *program, const char *options)
+{
+  fprintf(stderr, "usage: %s %s\n", program, options);
+  return 2;
+}
+
+/**
+* @fn host_check_result(void)
+* @brief Podsumowanie testu, zwraca kod wyjscia programu
+*/
+static inline int host_check_result(void)
+{
+  printf("%s\n", host_checkOk ? "OK" : "FAILED");
+
+  return host_checkOk ? 0 : 1;
+}
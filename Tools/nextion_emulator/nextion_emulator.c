@@ -0,0 +1,602 @@
+/**
+* @file nextion_emulator.c
+* @brief Emulator wyswietlacza Nextion Enhanced NX3224K028 uruchamiany na komputerze (testy regresyjne i pomiary pasma toru LCD)
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "nextion_emulator.h"
+
+#define RESET_TIME_US			150000				///< Czas uruchomienia wyswietlacza po komendzie rest [us]
+#define REPLY_INVALID_INSTRUCTION	0x00				///< Odpowiedzi wyswietlacza (bkcmd=2)
+#define REPLY_BUFFER_OVERFLOW		0x24
+#define REPLY_SENDME			0x66
+#define REPLY_READY			0x88
+
+// ******************************************************************************************************************************************************** //
+
+static void resetDisplay(NEXTION_EMULATOR *emu);
+static void receiveByte(NEXTION_EMULATOR *emu, uint8_t byte, uint64_t timeUs);
+static uint64_t commandCost(const NEXTION_EMULATOR *emu, const char *text);
+static void executeCommand(NEXTION_EMULATOR *emu, const char *text, uint64_t timeUs);
+static void writeComponent(NEXTION_EMULATOR *emu, const char *text, const char *dot, const char *equal);
+static void pushReply(NEXTION_EMULATOR *emu, uint8_t code, const uint8_t *data, uint8_t length, uint64_t timeUs);
+static uint16_t parseColor(const char *text);
+static uint8_t parseArgs(const char *text, long *args, uint8_t maxArgs, const char **last);
+static void fillRect(NEXTION_EMULATOR *emu, long x, long y, long w, long h, uint16_t color);
+static void drawLine(NEXTION_EMULATOR *emu, long x1, long y1, long x2, long y2, uint16_t color);
+
+// ******************************************************************************************************************************************************** //
+
+/*
+ * Default timing model, values estimated from the NX3224K028 datasheet and bench observations, not measured precisely
+ */
+void nextion_emulator_defaultConfig(NEXTION_EMULATOR_CONFIG *config)
+{
+  config->baudrate = 921600;
+  config->serialBufferSize = NEXTION_EMULATOR_SERIAL_BUFFER_SIZE;
+  config->cmdBaseTimeUs = 50;
+  config->cmdByteTimeNs = 500;
+  config->pageTimeUs = 30000;
+  config->pixelTimeNs = 15;
+}
+
+void nextion_emulator_init(NEXTION_EMULATOR *emu, const NEXTION_EMULATOR_CONFIG *config)
+{
+  memset(emu, 0, sizeof(*emu));
+
+  emu->config = *config;
+  if ( (emu->config.serialBufferSize == 0) || (emu->config.serialBufferSize > NEXTION_EMULATOR_SERIAL_BUFFER_SIZE) )
+    {
+      emu->config.serialBufferSize = NEXTION_EMULATOR_SERIAL_BUFFER_SIZE;
+    }
+
+  emu->persistentBaudrate = config->baudrate;
+  resetDisplay(emu);
+}
+
+/*
+ * Feed bytes received by the display, the first byte arrives at timeUs, next ones follow at the current wire speed (10 bits per byte)
+ */
+void nextion_emulator_feed(NEXTION_EMULATOR *emu, const uint8_t *data, uint32_t length, uint64_t timeUs)
+{
+  uint64_t timeNs = timeUs * 1000;
+
+  for (uint32_t i = 0; i < length; i++)
+    {
+      timeNs += 10000000000ULL / emu->baudrate;
+
+      nextion_emulator_run(emu, timeNs / 1000);
+      receiveByte(emu, data[i], timeNs / 1000);
+    }
+}
+
+/*
+ * Process all commands which finish before timeUs
+ */
+void nextion_emulator_run(NEXTION_EMULATOR *emu, uint64_t timeUs)
+{
+  while (emu->pendingTail != emu->pendingHead)
+    {
+      NEXTION_EMULATOR_CMD *cmd = &emu->pending[emu->pendingTail];
+      uint64_t start = (emu->busyUntilUs > cmd->readyTimeUs) ? emu->busyUntilUs : cmd->readyTimeUs;
+      uint64_t cost = commandCost(emu, cmd->text);
+
+      if (start + cost > timeUs) break;
+
+      emu->busyUntilUs = start + cost;
+      emu->stats.busyTimeUs += cost;
+      if (emu->busyUntilUs - cmd->readyTimeUs > emu->stats.maxCmdLatencyUs) emu->stats.maxCmdLatencyUs = emu->busyUntilUs - cmd->readyTimeUs;
+
+      emu->bufferFill -= cmd->length;
+      emu->pendingTail = (emu->pendingTail + 1) % NEXTION_EMULATOR_MAX_PENDING_CMDS;
+
+      executeCommand(emu, cmd->text, emu->busyUntilUs);
+    }
+}
+
+/*
+ * Read bytes sent back by the display up to timeUs, returns number of copied bytes
+ */
+uint32_t nextion_emulator_readReply(NEXTION_EMULATOR *emu, uint8_t *data, uint32_t maxLength, uint64_t timeUs)
+{
+  uint32_t length = 0;
+
+  nextion_emulator_run(emu, timeUs);
+
+  while ( (emu->replyTail != emu->replyHead) && (length < maxLength) && (emu->replyTimeUs[emu->replyTail] <= timeUs) )
+    {
+      data[length++] = emu->reply[emu->replyTail];
+      emu->replyTail = (emu->replyTail + 1) % NEXTION_EMULATOR_REPLY_BUFFER_SIZE;
+    }
+
+  return length;
+}
+
+const NEXTION_EMULATOR_COMPONENT *nextion_emulator_findComponent(const NEXTION_EMULATOR *emu, const char *name, const char *attribute)
+{
+  for (uint16_t i = 0; i < emu->componentCnt; i++)
+    {
+      const NEXTION_EMULATOR_COMPONENT *component = &emu->components[i];
+
+      if ( (component->page == emu->page) && (strcmp(component->name, name) == 0) && (strcmp(component->attribute, attribute) == 0) )
+	{
+	  return component;
+	}
+    }
+
+  return NULL;
+}
+
+/*
+ * Text snapshot of the display state, stable format intended for diffing against a reference file
+ */
+void nextion_emulator_writeText(const NEXTION_EMULATOR *emu, FILE *file)
+{
+  fprintf(file, "page=%u\n", emu->page);
+  fprintf(file, "baud=%lu bauds=%lu\n", (unsigned long)emu->baudrate, (unsigned long)emu->persistentBaudrate);
+  fprintf(file, "refresh=%s\n", emu->refreshStopped ? "stopped" : "running");
+
+  for (uint8_t i = 0; i < NEXTION_EMULATOR_PIO_CNT; i++)
+    {
+      fprintf(file, "pio%u mode=%u value=%u\n", i, emu->pioMode[i], emu->pioValue[i]);
+    }
+
+  for (uint16_t i = 0; i < emu->componentCnt; i++)
+    {
+      const NEXTION_EMULATOR_COMPONENT *component = &emu->components[i];
+
+      fprintf(file, "%s.%s=%s\n", component->name, component->attribute, component->value);
+    }
+}
+
+void nextion_emulator_writeStats(const NEXTION_EMULATOR *emu, FILE *file)
+{
+  const NEXTION_EMULATOR_STATS *stats = &emu->stats;
+  uint64_t endTimeUs = (emu->busyUntilUs > stats->lastByteTimeUs) ? emu->busyUntilUs : stats->lastByteTimeUs;
+  double seconds = (endTimeUs - stats->firstByteTimeUs) / 1e6;
+
+  if (seconds <= 0) seconds = 1e-6;
+
+  fprintf(file, "duration:          %.3f s\n", seconds);
+  fprintf(file, "bytes:             %lu (%.0f B/s)\n", (unsigned long)stats->bytes, stats->bytes / seconds);
+  fprintf(file, "commands:          %lu (%.0f cmd/s)\n", (unsigned long)stats->commands, stats->commands / seconds);
+  fprintf(file, "component writes:  %lu\n", (unsigned long)stats->componentWrites);
+  fprintf(file, "redundant writes:  %lu (%.1f %%)\n", (unsigned long)stats->redundantWrites,
+	  stats->componentWrites ? 100.0 * stats->redundantWrites / stats->componentWrites : 0.0);
+  fprintf(file, "page changes:      %lu\n", (unsigned long)stats->pageChanges);
+  fprintf(file, "unknown commands:  %lu\n", (unsigned long)stats->unknownCommands);
+  fprintf(file, "too long commands: %lu\n", (unsigned long)stats->longCommands);
+  fprintf(file, "overflow bytes:    %lu\n", (unsigned long)stats->overflowBytes);
+  fprintf(file, "max buffer fill:   %u / %u B\n", stats->maxBufferFill, emu->config.serialBufferSize);
+  fprintf(file, "display busy:      %.1f %%\n", 100.0 * stats->busyTimeUs / 1e6 / seconds);
+  fprintf(file, "max cmd latency:   %.3f ms\n", stats->maxCmdLatencyUs / 1e3);
+
+  for (uint16_t i = 0; i < emu->componentCnt; i++)
+    {
+      const NEXTION_EMULATOR_COMPONENT *component = &emu->components[i];
+
+      if (component->redundantWrites == 0) continue;
+
+      fprintf(file, "  %s.%s: %lu writes, %lu redundant\n", component->name, component->attribute,
+	      (unsigned long)component->writes, (unsigned long)component->redundantWrites);
+    }
+}
+
+/*
+ * Binary PPM (P6) snapshot of the frame buffer, returns 1 on success
+ */
+uint8_t nextion_emulator_writePpm(const NEXTION_EMULATOR *emu, FILE *file)
+{
+  fprintf(file, "P6\n%d %d\n255\n", NEXTION_EMULATOR_WIDTH, NEXTION_EMULATOR_HEIGHT);
+
+  for (uint16_t y = 0; y < NEXTION_EMULATOR_HEIGHT; y++)
+    {
+      for (uint16_t x = 0; x < NEXTION_EMULATOR_WIDTH; x++)
+	{
+	  uint16_t pixel = emu->framebuffer[y][x];
+	  uint8_t rgb[3] = { (uint8_t)(((pixel >> 11) & 0x1F) * 255 / 31), (uint8_t)(((pixel >> 5) & 0x3F) * 255 / 63), (uint8_t)((pixel & 0x1F) * 255 / 31) };
+
+	  if (fwrite(rgb, 1, sizeof(rgb), file) != sizeof(rgb)) return 0;
+	}
+    }
+
+  return 1;
+}
+
+// ******************************************************************************************************************************************************** //
+
+/*
+ * State after power-up or rest command
+ */
+static void resetDisplay(NEXTION_EMULATOR *emu)
+{
+  emu->page = 0;
+  emu->refreshStopped = 0;
+  emu->baudrate = emu->persistentBaudrate;
+  emu->componentCnt = 0;
+  memset(emu->pioMode, 0, sizeof(emu->pioMode));
+  memset(emu->pioValue, 0, sizeof(emu->pioValue));
+  memset(emu->framebuffer, 0, sizeof(emu->framebuffer));
+
+  emu->rxCmdLength = 0;
+  emu->rxTerminatorCnt = 0;
+  emu->bufferFill = 0;
+  emu->pendingHead = 0;
+  emu->pendingTail = 0;
+}
+
+static void receiveByte(NEXTION_EMULATOR *emu, uint8_t byte, uint64_t timeUs)
+{
+  if (emu->stats.bytes == 0) emu->stats.firstByteTimeUs = timeUs;
+  emu->stats.lastByteTimeUs = timeUs;
+  emu->stats.bytes++;
+
+  //Przepelnienie bufora szeregowego, wyswietlacz odrzuca bajt i zglasza blad
+  if (emu->bufferFill >= emu->config.serialBufferSize)
+    {
+      if (!emu->overflowActive) pushReply(emu, REPLY_BUFFER_OVERFLOW, NULL, 0, timeUs);
+      emu->overflowActive = 1;
+      emu->stats.overflowBytes++;
+      emu->rxCmdLength = 0;
+      emu->rxTerminatorCnt = 0;
+      return;
+    }
+
+  emu->overflowActive = 0;
+  emu->bufferFill++;
+  if (emu->bufferFill > emu->stats.maxBufferFill) emu->stats.maxBufferFill = emu->bufferFill;
+
+  if (byte == 0xFF)
+    {
+      emu->rxCmdLength++;
+
+      if (++emu->rxTerminatorCnt < 3) return;
+
+      //Komenda zakonczona, wstaw ja do kolejki przetwarzania
+      NEXTION_EMULATOR_CMD *cmd = &emu->pending[emu->pendingHead];
+      uint16_t textLength = emu->rxCmdLength - 3;
+
+      if (textLength > NEXTION_EMULATOR_MAX_CMD_LENGTH)
+	{
+	  emu->stats.longCommands++;
+	  textLength = NEXTION_EMULATOR_MAX_CMD_LENGTH;
+	}
+
+      memcpy(cmd->text, emu->rxCmd, textLength);
+      cmd->text[textLength] = 0;
+      cmd->length = emu->rxCmdLength;
+      cmd->readyTimeUs = timeUs;
+      emu->pendingHead = (emu->pendingHead + 1) % NEXTION_EMULATOR_MAX_PENDING_CMDS;
+
+      emu->rxCmdLength = 0;
+      emu->rxTerminatorCnt = 0;
+      return;
+    }
+
+  //Pojedyncze 0xFF nalezace do tresci komendy
+  while (emu->rxTerminatorCnt > 0)
+    {
+      if (emu->rxCmdLength - emu->rxTerminatorCnt < NEXTION_EMULATOR_MAX_CMD_LENGTH) emu->rxCmd[emu->rxCmdLength - emu->rxTerminatorCnt] = (char)0xFF;
+      emu->rxTerminatorCnt--;
+    }
+
+  if (emu->rxCmdLength < NEXTION_EMULATOR_MAX_CMD_LENGTH) emu->rxCmd[emu->rxCmdLength] = (char)byte;
+  emu->rxCmdLength++;
+}
+
+static uint64_t commandCost(const NEXTION_EMULATOR *emu, const char *text)
+{
+  uint64_t cost = emu->config.cmdBaseTimeUs + (uint64_t)strlen(text) * emu->config.cmdByteTimeNs / 1000;
+  long args[5];
+  uint64_t pixels = 0;
+
+  if (strncmp(text, "page ", 5) == 0) return cost + emu->config.pageTimeUs;
+  if (strcmp(text, "rest") == 0) return cost + RESET_TIME_US;
+
+  if (strncmp(text, "cls ", 4) == 0)
+    {
+      pixels = NEXTION_EMULATOR_WIDTH * NEXTION_EMULATOR_HEIGHT;
+    }
+  else if ( (strncmp(text, "fill ", 5) == 0) && (parseArgs(text + 5, args, 4, NULL) == 4) )
+    {
+      pixels = (uint64_t)labs(args[2] * args[3]);
+    }
+  else if ( (strncmp(text, "draw ", 5) == 0) && (parseArgs(text + 5, args, 4, NULL) == 4) )
+    {
+      pixels = 2 * (uint64_t)(labs(args[2] - args[0]) + labs(args[3] - args[1]));
+    }
+  else if ( (strncmp(text, "line ", 5) == 0) && (parseArgs(text + 5, args, 4, NULL) == 4) )
+    {
+      pixels = (uint64_t)(labs(args[2] - args[0]) + labs(args[3] - args[1]));
+    }
+
+  return cost + pixels * emu->config.pixelTimeNs / 1000;
+}
+
+static void executeCommand(NEXTION_EMULATOR *emu, const char *text, uint64_t timeUs)
+{
+  long args[5];
+  const char *last;
+  const char *dot = strchr(text, '.');
+  const char *equal = strchr(text, '=');
+
+  emu->stats.commands++;
+
+  //Sam terminator (uzywany do czyszczenia bufora wyswietlacza) jest ignorowany
+  if (text[0] == 0) return;
+
+  if (strncmp(text, "page ", 5) == 0)
+    {
+      uint8_t page = (uint8_t)atoi(text + 5);
+      uint16_t kept = 0;
+
+      emu->stats.pageChanges++;
+
+      //Komponenty poprzedniej strony traca wartosci (zasieg lokalny)
+      for (uint16_t i = 0; i < emu->componentCnt; i++)
+	{
+	  if (emu->components[i].page != emu->page) emu->components[kept++] = emu->components[i];
+	}
+      emu->componentCnt = kept;
+
+      emu->page = page;
+      memset(emu->framebuffer, 0, sizeof(emu->framebuffer));
+      return;
+    }
+
+  if (strcmp(text, "rest") == 0)
+    {
+      resetDisplay(emu);
+      pushReply(emu, REPLY_READY, NULL, 0, timeUs);
+      return;
+    }
+
+  if (strncmp(text, "bauds=", 6) == 0)
+    {
+      emu->persistentBaudrate = strtoul(text + 6, NULL, 10);
+      emu->baudrate = emu->persistentBaudrate;
+      return;
+    }
+
+  if (strncmp(text, "baud=", 5) == 0)
+    {
+      emu->baudrate = strtoul(text + 5, NULL, 10);
+      return;
+    }
+
+  if (strcmp(text, "sendme") == 0)
+    {
+      pushReply(emu, REPLY_SENDME, &emu->page, 1, timeUs);
+      return;
+    }
+
+  if (strcmp(text, "ref_stop") == 0)
+    {
+      emu->refreshStopped = 1;
+      return;
+    }
+
+  if (strcmp(text, "ref_star") == 0)
+    {
+      emu->refreshStopped = 0;
+      return;
+    }
+
+  if (strncmp(text, "cls ", 4) == 0)
+    {
+      fillRect(emu, 0, 0, NEXTION_EMULATOR_WIDTH, NEXTION_EMULATOR_HEIGHT, parseColor(text + 4));
+      return;
+    }
+
+  if ( (strncmp(text, "fill ", 5) == 0) && (parseArgs(text + 5, args, 4, &last) == 4) )
+    {
+      fillRect(emu, args[0], args[1], args[2], args[3], parseColor(last));
+      return;
+    }
+
+  if ( (strncmp(text, "draw ", 5) == 0) && (parseArgs(text + 5, args, 4, &last) == 4) )
+    {
+      uint16_t color = parseColor(last);
+
+      drawLine(emu, args[0], args[1], args[2], args[1], color);
+      drawLine(emu, args[2], args[1], args[2], args[3], color);
+      drawLine(emu, args[2], args[3], args[0], args[3], color);
+      drawLine(emu, args[0], args[3], args[0], args[1], color);
+      return;
+    }
+
+  if ( (strncmp(text, "line ", 5) == 0) && (parseArgs(text + 5, args, 4, &last) == 4) )
+    {
+      drawLine(emu, args[0], args[1], args[2], args[3], parseColor(last));
+      return;
+    }
+
+  if ( (strncmp(text, "cfgpio ", 7) == 0) && (parseArgs(text + 7, args, 3, NULL) == 3) )
+    {
+      if ( (args[0] >= 0) && (args[0] < NEXTION_EMULATOR_PIO_CNT) ) emu->pioMode[args[0]] = (uint8_t)args[1];
+      return;
+    }
+
+  if ( (strncmp(text, "pio", 3) == 0) && (equal != NULL) && (dot == NULL) )
+    {
+      long pin = atol(text + 3);
+
+      if ( (pin >= 0) && (pin < NEXTION_EMULATOR_PIO_CNT) ) emu->pioValue[pin] = (uint8_t)atoi(equal + 1);
+      return;
+    }
+
+  //Komendy bez wplywu na sledzony stan
+  if ( (strncmp(text, "udelete ", 8) == 0) || (strncmp(text, "ref ", 4) == 0) || (strncmp(text, "vis ", 4) == 0)
+      || (strncmp(text, "tsw ", 4) == 0) || (strncmp(text, "click ", 6) == 0) || (strncmp(text, "bkcmd=", 6) == 0)
+      || (strncmp(text, "dim=", 4) == 0) || (strncmp(text, "sleep=", 6) == 0) )
+    {
+      return;
+    }
+
+  //Zapis atrybutu komponentu: nazwa.atrybut=wartosc
+  if ( (dot != NULL) && (equal != NULL) && (dot < equal) )
+    {
+      writeComponent(emu, text, dot, equal);
+      return;
+    }
+
+  emu->stats.unknownCommands++;
+  pushReply(emu, REPLY_INVALID_INSTRUCTION, NULL, 0, timeUs);
+}
+
+static void writeComponent(NEXTION_EMULATOR *emu, const char *text, const char *dot, const char *equal)
+{
+  char name[sizeof(emu->components[0].name)];
+  char attribute[sizeof(emu->components[0].attribute)];
+  size_t nameLength = (size_t)(dot - text);
+  size_t attributeLength = (size_t)(equal - dot - 1);
+
+  if (nameLength >= sizeof(name)) nameLength = sizeof(name) - 1;
+  if (attributeLength >= sizeof(attribute)) attributeLength = sizeof(attribute) - 1;
+
+  memcpy(name, text, nameLength);
+  name[nameLength] = 0;
+  memcpy(attribute, dot + 1, attributeLength);
+  attribute[attributeLength] = 0;
+
+  emu->stats.componentWrites++;
+
+  NEXTION_EMULATOR_COMPONENT *component = (NEXTION_EMULATOR_COMPONENT *)nextion_emulator_findComponent(emu, name, attribute);
+
+  if (component == NULL)
+    {
+      if (emu->componentCnt >= NEXTION_EMULATOR_MAX_COMPONENTS) return;
+
+      component = &emu->components[emu->componentCnt++];
+      memset(component, 0, sizeof(*component));
+      component->page = emu->page;
+      strcpy(component->name, name);
+      strcpy(component->attribute, attribute);
+    }
+  else if (strncmp(component->value, equal + 1, sizeof(component->value) - 1) == 0)
+    {
+      //Wartosc juz wyswietlana, zapis niepotrzebnie zajal lacze
+      component->redundantWrites++;
+      emu->stats.redundantWrites++;
+    }
+
+  component->writes++;
+  strncpy(component->value, equal + 1, sizeof(component->value) - 1);
+  component->value[sizeof(component->value) - 1] = 0;
+}
+
+static void pushReply(NEXTION_EMULATOR *emu, uint8_t code, const uint8_t *data, uint8_t length, uint64_t timeUs)
+{
+  uint8_t frame[8];
+  uint8_t frameLength = 0;
+
+  frame[frameLength++] = code;
+  for (uint8_t i = 0; (i < length) && (frameLength < sizeof(frame) - 3); i++) frame[frameLength++] = data[i];
+  frame[frameLength++] = 0xFF;
+  frame[frameLength++] = 0xFF;
+  frame[frameLength++] = 0xFF;
+
+  for (uint8_t i = 0; i < frameLength; i++)
+    {
+      uint16_t next = (emu->replyHead + 1) % NEXTION_EMULATOR_REPLY_BUFFER_SIZE;
+
+      //Odpowiedzi nieodczytywane przez uzytkownika emulatora sa nadpisywane od najstarszej
+      if (next == emu->replyTail) emu->replyTail = (emu->replyTail + 1) % NEXTION_EMULATOR_REPLY_BUFFER_SIZE;
+
+      emu->reply[emu->replyHead] = frame[i];
+      emu->replyTimeUs[emu->replyHead] = timeUs;
+      emu->replyHead = next;
+    }
+}
+
+/*
+ * Color given as RGB565 number or one of the predefined Nextion color names
+ */
+static uint16_t parseColor(const char *text)
+{
+  static const struct
+  {
+    const char *name;
+    uint16_t value;
+  } colors[] =
+  {
+    { "BLACK", 0 }, { "BLUE", 31 }, { "BROWN", 48192 }, { "GREEN", 2016 }, { "YELLOW", 65504 },
+    { "RED", 63488 }, { "GRAY", 33840 }, { "WHITE", 65535 }
+  };
+
+  while (*text == ' ') text++;
+
+  for (uint8_t i = 0; i < sizeof(colors) / sizeof(colors[0]); i++)
+    {
+      if (strcmp(text, colors[i].name) == 0) return colors[i].value;
+    }
+
+  return (uint16_t)strtoul(text, NULL, 10);
+}
+
+/*
+ * Parse comma separated integer arguments, *last points to the argument following them
+ */
+static uint8_t parseArgs(const char *text, long *args, uint8_t maxArgs, const char **last)
+{
+  uint8_t cnt = 0;
+  char *end;
+
+  while (cnt < maxArgs)
+    {
+      args[cnt] = strtol(text, &end, 10);
+      if (end == text) break;
+
+      cnt++;
+      text = end;
+      if (*text == ',') text++;
+    }
+
+  if (last != NULL) *last = text;
+
+  return cnt;
+}
+
+static void fillRect(NEXTION_EMULATOR *emu, long x, long y, long w, long h, uint16_t color)
+{
+  for (long row = (y < 0 ? 0 : y); (row < y + h) && (row < NEXTION_EMULATOR_HEIGHT); row++)
+    {
+      for (long col = (x < 0 ? 0 : x); (col < x + w) && (col < NEXTION_EMULATOR_WIDTH); col++)
+	{
+	  emu->framebuffer[row][col] = color;
+	}
+    }
+}
+
+static void drawLine(NEXTION_EMULATOR *emu, long x1, long y1, long x2, long y2, uint16_t color)
+{
+  long dx = labs(x2 - x1);
+  long dy = -labs(y2 - y1);
+  long sx = (x1 < x2) ? 1 : -1;
+  long sy = (y1 < y2) ? 1 : -1;
+  long err = dx + dy;
+
+  for (;;)
+    {
+      if ( (x1 >= 0) && (x1 < NEXTION_EMULATOR_WIDTH) && (y1 >= 0) && (y1 < NEXTION_EMULATOR_HEIGHT) ) emu->framebuffer[y1][x1] = color;
+      if ( (x1 == x2) && (y1 == y2) ) break;
+
+      long e2 = 2 * err;
+      if (e2 >= dy)
+	{
+	  err += dy;
+	  x1 += sx;
+	}
+      if (e2 <= dx)
+	{
+	  err += dx;
+	  y1 += sy;
+	}
+    }
+}
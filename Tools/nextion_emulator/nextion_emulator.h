@@ -0,0 +1,139 @@
+/**
+* @file nextion_emulator.h
+* @brief Emulator wyswietlacza Nextion Enhanced NX3224K028 uruchamiany na komputerze (testy regresyjne i pomiary pasma toru LCD)
+* @details Biblioteka przyjmuje dokladnie ten sam strumien bajtow, ktory wysyla External_libraries/Nextion_Enhanced_NX3224K028.c
+* (komendy zakonczone 0xFF 0xFF 0xFF), sledzi strone i stan komponentow, symuluje bufor szeregowy wyswietlacza
+* oraz czas przetwarzania kazdej komendy. Nie zalezy od HAL, kompilacja:
+*
+*   gcc -std=c99 -O2 -Wall -o nextion_emulator nextion_emulator.c nextion_emulator_main.c
+*
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define NEXTION_EMULATOR_WIDTH			320				///< Rozdzielczosc wyswietlacza (poziomo)
+#define NEXTION_EMULATOR_HEIGHT			240
+#define NEXTION_EMULATOR_SERIAL_BUFFER_SIZE	1024				///< Rozmiar bufora szeregowego wyswietlacza [B]
+#define NEXTION_EMULATOR_MAX_CMD_LENGTH		128				///< Najdluzsza obslugiwana komenda (bez terminatora)
+#define NEXTION_EMULATOR_MAX_PENDING_CMDS	(NEXTION_EMULATOR_SERIAL_BUFFER_SIZE / 3 + 1)	///< Najkrotsza komenda to sam terminator, wiec kolejka nie moze sie przepelnic przed buforem
+#define NEXTION_EMULATOR_MAX_COMPONENTS		96				///< Liczba sledzonych par komponent.atrybut
+#define NEXTION_EMULATOR_REPLY_BUFFER_SIZE	256				///< Rozmiar bufora odpowiedzi wyswietlacza
+#define NEXTION_EMULATOR_PIO_CNT		8				///< Liczba pinow plytki rozszerzen
+
+/**
+* @struct NEXTION_EMULATOR_CONFIG
+* @brief Parametry modelu czasowego wyswietlacza
+*/
+typedef struct
+{
+  uint32_t baudrate;				///< Predkosc transmisji po starcie wyswietlacza [bit/s]
+  uint16_t serialBufferSize;			///< Rozmiar bufora szeregowego [B], maksymalnie NEXTION_EMULATOR_SERIAL_BUFFER_SIZE
+  uint32_t cmdBaseTimeUs;			///< Staly czas przetworzenia jednej komendy [us]
+  uint32_t cmdByteTimeNs;			///< Czas przetworzenia jednego bajtu komendy [ns]
+  uint32_t pageTimeUs;				///< Czas zaladowania strony [us]
+  uint32_t pixelTimeNs;				///< Czas narysowania jednego piksela (draw, fill, line, cls) [ns]
+} NEXTION_EMULATOR_CONFIG;
+
+/**
+* @struct NEXTION_EMULATOR_STATS
+* @brief Statystyki strumienia komend
+*/
+typedef struct
+{
+  uint64_t firstByteTimeUs;			///< Czas odebrania pierwszego bajtu [us]
+  uint64_t lastByteTimeUs;			///< Czas odebrania ostatniego bajtu [us]
+  uint32_t bytes;				///< Liczba odebranych bajtow (wraz z terminatorami)
+  uint32_t commands;				///< Liczba przetworzonych komend
+  uint32_t componentWrites;			///< Liczba zapisow atrybutow komponentow
+  uint32_t redundantWrites;			///< Zapisy wartosci identycznej z aktualnie wyswietlana
+  uint32_t pageChanges;				///< Liczba komend page
+  uint32_t unknownCommands;			///< Komendy nieobslugiwane przez emulator
+  uint32_t overflowBytes;			///< Bajty odrzucone z powodu przepelnienia bufora szeregowego
+  uint32_t longCommands;			///< Komendy dluzsze niz NEXTION_EMULATOR_MAX_CMD_LENGTH
+  uint16_t maxBufferFill;			///< Najwieksze zanotowane zapelnienie bufora szeregowego [B]
+  uint64_t busyTimeUs;				///< Laczny czas przetwarzania komend [us]
+  uint64_t maxCmdLatencyUs;			///< Najdluzszy czas od odebrania terminatora do zakonczenia przetwarzania komendy [us]
+} NEXTION_EMULATOR_STATS;
+
+/**
+* @struct NEXTION_EMULATOR_COMPONENT
+* @brief Ostatnia wartosc zapisana do atrybutu komponentu
+*/
+typedef struct
+{
+  uint8_t page;
+  char name[16];
+  char attribute[8];
+  char value[40];
+  uint32_t writes;
+  uint32_t redundantWrites;
+} NEXTION_EMULATOR_COMPONENT;
+
+/**
+* @struct NEXTION_EMULATOR_CMD
+* @brief Komenda oczekujaca w buforze szeregowym
+*/
+typedef struct
+{
+  char text[NEXTION_EMULATOR_MAX_CMD_LENGTH + 1];
+  uint16_t length;				///< Liczba bajtow zajmowanych w buforze (wraz z terminatorem)
+  uint64_t readyTimeUs;				///< Czas odebrania terminatora [us]
+} NEXTION_EMULATOR_CMD;
+
+/**
+* @struct NEXTION_EMULATOR
+* @brief Stan emulowanego wyswietlacza
+*/
+typedef struct
+{
+  NEXTION_EMULATOR_CONFIG config;
+  NEXTION_EMULATOR_STATS stats;
+
+  //Stan wyswietlacza
+  uint8_t page;
+  uint8_t refreshStopped;			///< 1 - po ref_stop, do ref_star
+  uint32_t baudrate;				///< Aktualna predkosc transmisji [bit/s]
+  uint32_t persistentBaudrate;			///< Predkosc ustawiona przez bauds= (obowiazuje po rest)
+  uint8_t pioMode[NEXTION_EMULATOR_PIO_CNT];
+  uint8_t pioValue[NEXTION_EMULATOR_PIO_CNT];
+  uint16_t componentCnt;
+  NEXTION_EMULATOR_COMPONENT components[NEXTION_EMULATOR_MAX_COMPONENTS];
+  uint16_t framebuffer[NEXTION_EMULATOR_HEIGHT][NEXTION_EMULATOR_WIDTH];	///< RGB565
+
+  //Bufor szeregowy
+  char rxCmd[NEXTION_EMULATOR_MAX_CMD_LENGTH + 1];	///< Aktualnie odbierana komenda
+  uint16_t rxCmdLength;				///< Liczba bajtow odbieranej komendy (wraz z odebranymi 0xFF)
+  uint8_t rxTerminatorCnt;			///< Liczba kolejnych odebranych 0xFF
+  uint16_t bufferFill;				///< Zapelnienie bufora szeregowego [B]
+  uint8_t overflowActive;			///< 1 - poprzedni bajt zostal odrzucony (0x24 wysylane raz na przepelnienie)
+  uint16_t pendingHead;
+  uint16_t pendingTail;
+  NEXTION_EMULATOR_CMD pending[NEXTION_EMULATOR_MAX_PENDING_CMDS];
+  uint64_t busyUntilUs;				///< Czas zakonczenia przetwarzania ostatniej komendy [us]
+
+  //Odpowiedzi wyswietlacza
+  uint16_t replyHead;
+  uint16_t replyTail;
+  uint8_t reply[NEXTION_EMULATOR_REPLY_BUFFER_SIZE];
+  uint64_t replyTimeUs[NEXTION_EMULATOR_REPLY_BUFFER_SIZE];
+} NEXTION_EMULATOR;
+
+// ******************************************************************************************************************************************************** //
+
+extern void nextion_emulator_defaultConfig(NEXTION_EMULATOR_CONFIG *config);
+extern void nextion_emulator_init(NEXTION_EMULATOR *emu, const NEXTION_EMULATOR_CONFIG *config);
+extern void nextion_emulator_feed(NEXTION_EMULATOR *emu, const uint8_t *data, uint32_t length, uint64_t timeUs);
+extern void nextion_emulator_run(NEXTION_EMULATOR *emu, uint64_t timeUs);
+extern uint32_t nextion_emulator_readReply(NEXTION_EMULATOR *emu, uint8_t *data, uint32_t maxLength, uint64_t timeUs);
+extern const NEXTION_EMULATOR_COMPONENT *nextion_emulator_findComponent(const NEXTION_EMULATOR *emu, const char *name, const char *attribute);
+extern void nextion_emulator_writeText(const NEXTION_EMULATOR *emu, FILE *file);
+extern void nextion_emulator_writeStats(const NEXTION_EMULATOR *emu, FILE *file);
+extern uint8_t nextion_emulator_writePpm(const NEXTION_EMULATOR *emu, FILE *file);
@@ -0,0 +1,146 @@
+/**
+* @file nextion_emulator_main.c
+* @brief Program uruchamiajacy emulator Nextion na zapisanym strumieniu bajtow
+* @details Uzycie:
+*
+*   nextion_emulator [-r] [-b baudrate] [-t snapshot.txt] [-p snapshot.ppm] capture.bin
+*
+* Domyslny format pliku to kolejne rekordy: czas [us] (uint32, little endian), dlugosc (uint16, little endian), bajty.
+* Jeden rekord odpowiada jednemu transferowi DMA z Nextion_Enhanced_NX3224K028_flush(). Z opcja -r plik jest surowym
+* strumieniem bajtow (np. zrzut z analizatora stanow logicznych) wysylanym bez przerw z pelna predkoscia lacza.
+* Statystyki wypisywane sa na stdout, kod wyjscia 1 oznacza blad lub przepelnienie bufora wyswietlacza.
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "nextion_emulator.h"
+
+static NEXTION_EMULATOR emu;		///< Duza struktura (bufor ramki), dlatego poza stosem
+
+// ******************************************************************************************************************************************************** //
+
+static int usage(const char *program);
+static uint8_t feedRaw(FILE *file);
+static uint8_t feedRecords(FILE *file);
+
+// ******************************************************************************************************************************************************** //
+
+int main(int argc, char **argv)
+{
+  NEXTION_EMULATOR_CONFIG config;
+  const char *textPath = NULL;
+  const char *ppmPath = NULL;
+  uint8_t raw = 0;
+  int i;
+
+  nextion_emulator_defaultConfig(&config);
+
+  for (i = 1; i < argc - 1; i++)
+    {
+      if (strcmp(argv[i], "-r") == 0) raw = 1;
+      else if ( (strcmp(argv[i], "-b") == 0) && (i + 2 < argc) ) config.baudrate = strtoul(argv[++i], NULL, 10);
+      else if ( (strcmp(argv[i], "-t") == 0) && (i + 2 < argc) ) textPath = argv[++i];
+      else if ( (strcmp(argv[i], "-p") == 0) && (i + 2 < argc) ) ppmPath = argv[++i];
+      else return usage(argv[0]);
+    }
+
+  if ( (i != argc - 1) || (config.baudrate == 0) ) return usage(argv[0]);
+
+  FILE *capture = fopen(argv[i], "rb");
+  if (capture == NULL)
+    {
+      perror(argv[i]);
+      return 1;
+    }
+
+  nextion_emulator_init(&emu, &config);
+
+  uint8_t ok = raw ? feedRaw(capture) : feedRecords(capture);
+  fclose(capture);
+
+  //Dokoncz przetwarzanie komend pozostalych w buforze
+  nextion_emulator_run(&emu, UINT64_MAX);
+
+  nextion_emulator_writeStats(&emu, stdout);
+
+  if (textPath != NULL)
+    {
+      FILE *file = fopen(textPath, "w");
+
+      if (file == NULL)
+	{
+	  perror(textPath);
+	  return 1;
+	}
+
+      nextion_emulator_writeText(&emu, file);
+      fclose(file);
+    }
+
+  if (ppmPath != NULL)
+    {
+      FILE *file = fopen(ppmPath, "wb");
+
+      if ( (file == NULL) || !nextion_emulator_writePpm(&emu, file) )
+	{
+	  perror(ppmPath);
+	  return 1;
+	}
+
+      fclose(file);
+    }
+
+  return (ok && (emu.stats.overflowBytes == 0)) ? 0 : 1;
+}
+
+static int usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [-r] [-b baudrate] [-t snapshot.txt] [-p snapshot.ppm] capture.bin\n", program);
+  return 2;
+}
+
+static uint8_t feedRaw(FILE *file)
+{
+  uint8_t buffer[256];
+  size_t length;
+  uint64_t timeNs = 0;
+
+  while ( (length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+      //Kazdy bajt osobno, aby zmiana predkosci (baud=, bauds=) obowiazywala od kolejnej komendy
+      for (size_t i = 0; i < length; i++)
+	{
+	  nextion_emulator_feed(&emu, &buffer[i], 1, timeNs / 1000);
+	  timeNs += 10000000000ULL / emu.baudrate;
+	}
+    }
+
+  return 1;
+}
+
+static uint8_t feedRecords(FILE *file)
+{
+  uint8_t header[6];
+  uint8_t buffer[65535];
+
+  while (fread(header, 1, sizeof(header), file) == sizeof(header))
+    {
+      uint32_t timeUs = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+      uint16_t length = header[4] | (header[5] << 8);
+
+      if (fread(buffer, 1, length, file) != length)
+	{
+	  fprintf(stderr, "truncated record at %lu us\n", (unsigned long)timeUs);
+	  return 0;
+	}
+
+      nextion_emulator_feed(&emu, buffer, length, timeUs);
+    }
+
+  return 1;
+}
@@ -0,0 +1,360 @@
+/**
+* @file nextion_priority_test.c
+* @brief Test strony bezpieczenstwa (Nextion_Enhanced_NX3224K028_loadNewPagePriority()) przerywajacej paczke komend, uruchamiany na komputerze
+* @details Test laczy biblioteke wyswietlacza (External_libraries/Nextion_Enhanced_NX3224K028.c) z emulatorem (Tools/nextion_emulator)
+* przez zastepczy naglowek usart.h. Transmisja DMA jest modelowana bajt po bajcie z predkoscia lacza, odpowiedzi emulatora
+* trafiaja do biblioteki tak jak z przerwania UART. Co 1ms wywolywane sa parseReceivedData() i flush() (jak w lcd_control.c).
+* Scenariusze:
+* - strona 1, ramka komend (ref_stop ... ref_star) przerwana w polowie komendy po wykonaniu ref_stop, nastepnie strona 3
+*   zlecona komenda priorytetowa. Wymagane sa: strona 3 w emulatorze, wlaczone odswiezanie, potwierdzenie sendme w bibliotece,
+* - strona 4 zlecana co 1ms w trakcie wymiany addt, na ktora wyswietlacz nie odpowiada (emulator nie obsluguje addt, najgorszy przypadek).
+*   Zlecenie musi zostac przyjete w czasie NEXTION_ADDT_PRIO_TIMEOUT + 3ms,
+* - sendme (jak sprawdzenie polaczenia), strona 1 i pelna ramka w jednej paczce. Czas ramki musi konczyc odpowiedz na sendme
+*   dodane przez endFrame(), a nie odpowiedzi na wczesniejsze sendme (czas nie krotszy od czasu wysylania paczki),
+* - licznik komend statystyk: zmiana strony to 2 komendy (page, sendme), strona priorytetowa 3 (ref_star, page, sendme).
+* Kod wyjscia 1 oznacza niespelnienie ktoregos z warunkow. Kompilacja:
+*
+*   gcc -std=gnu99 -O2 -Wall -I. -I.. -I../../External_libraries -I../nextion_emulator -o nextion_priority_test nextion_priority_test.c
+*       ../nextion_emulator/nextion_emulator.c ../../External_libraries/Nextion_Enhanced_NX3224K028.c
+*
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "usart.h"
+#include "Nextion_Enhanced_NX3224K028.h"
+#include "nextion_emulator.h"
+#include "host_check.h"
+
+#define BAUDRATE		921600		///< Jak USART1 w lcd_control.c
+#define STEP_US			1		///< Krok symulacji [us]
+#define LOOP_PERIOD_US		1000		///< Okres wywolywania biblioteki (zadanie LCD) [us]
+#define PAGE_TIMEOUT_MS		200		///< Maksymalny czas oczekiwania na strone w tescie [ms]
+#define BURST_TIMEOUT_MS	20		///< Maksymalny czas oczekiwania na wykonanie ref_stop przerywanej ramki [ms]
+
+/**
+* @struct SIM
+* @brief Stan symulowanego UART (TX przez DMA, RX w przerwaniu) i czasu
+*/
+typedef struct
+{
+  uint64_t timeNs;
+  const uint8_t *txData;
+  uint16_t txLength;
+  uint16_t txPos;			///< Liczba bajtow juz odebranych przez wyswietlacz
+  uint64_t txStartNs;
+  uint8_t *rxData;			///< Adres podany w HAL_UART_Receive_IT()
+} SIM;
+
+static SIM sim;
+static NEXTION_EMULATOR emu;
+static NEXTION_HANDLE lcd;
+static UART_HandleTypeDef huart;
+
+// ******************************************************************************************************************************************************** //
+
+static uint64_t byteNs(void);
+static void simStep(void);
+static void runMs(uint32_t ms, uint8_t (*done)(void));
+static void scenarioCutBurst(void);
+static void scenarioAddt(void);
+static void scenarioFrameTime(void);
+static void scenarioCommandCount(void);
+static uint8_t page1Ready(void);
+static uint8_t page3Ready(void);
+static uint8_t page4Ready(void);
+static uint8_t burstCut(void);
+static uint8_t frameTimeDone(void);
+
+// ******************************************************************************************************************************************************** //
+
+int main(void)
+{
+  NEXTION_EMULATOR_CONFIG config;
+
+  nextion_emulator_defaultConfig(&config);
+  config.baudrate = BAUDRATE;
+  nextion_emulator_init(&emu, &config);
+
+  huart.Instance = &huart;
+  huart.Init.BaudRate = BAUDRATE;
+  huart.gState = HAL_UART_STATE_READY;
+  huart.RxState = HAL_UART_STATE_READY;
+
+  Nextion_Enhanced_NX3224K028_init(&lcd, &huart);
+  Nextion_Enhanced_NX3224K028_startReception(&lcd);
+
+  Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1);
+  runMs(PAGE_TIMEOUT_MS, page1Ready);
+  host_check(page1Ready(), "start: page 1 confirmed", "%6.0f", lcd.activePage);
+
+  scenarioCutBurst();
+  scenarioAddt();
+  scenarioFrameTime();
+  scenarioCommandCount();
+
+  return host_check_result();
+}
+
+/**
+* @fn scenarioCutBurst(void)
+* @brief Strona 3 zlecona w trakcie wysylania ramki, transfer przerwany w polowie komendy po wykonaniu ref_stop
+*/
+static void scenarioCutBurst(void)
+{
+  //Ramka wypelniajaca caly bufor, wysylana przez ok. 2,8ms
+  Nextion_Enhanced_NX3224K028_beginFrame(&lcd);
+  for (uint16_t i = 0; Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*)"n0", i); i++);
+  Nextion_Enhanced_NX3224K028_endFrame(&lcd);
+  Nextion_Enhanced_NX3224K028_flush(&lcd);
+
+  //Przerwij transfer w polowie komendy, po wykonaniu ref_stop przez wyswietlacz
+  uint64_t limitNs = sim.timeNs + BURST_TIMEOUT_MS * 1000000ULL;
+  while (!burstCut() && (sim.timeNs < limitNs)) simStep();
+
+  host_check(burstCut(), "burst: cut inside command after ref_stop", "%6.0f B", emu.rxCmdLength);
+
+  uint8_t accepted = Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 3);
+  host_check(accepted, "priority: request accepted", "%6.0f", accepted);
+
+  runMs(PAGE_TIMEOUT_MS, page3Ready);
+
+  host_check(emu.page == 3, "priority: emulator page", "%6.0f", emu.page);
+  host_check(!emu.refreshStopped, "priority: refresh stopped", "%6.0f", emu.refreshStopped);
+  host_check(Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 3), "priority: page 3 ready", "%6.0f", lcd.activePage);
+  host_check(lcd.pageConfirmTimeoutCnt == 0, "priority: page confirm timeouts", "%6.0f", lcd.pageConfirmTimeoutCnt);
+  host_check(lcd.abortedBurstCnt == 1, "priority: aborted bursts", "%6.0f", lcd.abortedBurstCnt);
+  host_check(lcd.prioPageLatency < NEXTION_PAGE_LOAD_TIMEOUT, "priority: latency", "%6.0f ms", lcd.prioPageLatency);
+}
+
+/**
+* @fn scenarioAddt(void)
+* @brief Strona 4 zlecana co 1ms (jak choosePage() w lcd_control.c) w trakcie wymiany addt bez odpowiedzi 0xFE / 0xFD
+*/
+static void scenarioAddt(void)
+{
+  uint8_t points[NEXTION_ADDT_MAX_LENGTH];
+
+  memset(points, 100, sizeof(points));
+  Nextion_Enhanced_NX3224K028_addTransparentData(&lcd, 2, 0, points, sizeof(points));
+  Nextion_Enhanced_NX3224K028_flush(&lcd);
+
+  uint32_t refusedMs = 0;
+
+  while (!Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 4) && (refusedMs < PAGE_TIMEOUT_MS))
+    {
+      for (uint32_t us = 0; us < LOOP_PERIOD_US; us += STEP_US) simStep();
+
+      Nextion_Enhanced_NX3224K028_parseReceivedData(&lcd);
+      Nextion_Enhanced_NX3224K028_flush(&lcd);
+      refusedMs++;
+    }
+
+  host_check(refusedMs <= NEXTION_ADDT_PRIO_TIMEOUT + 3, "addt: priority request refused", "%6.0f ms", refusedMs);
+
+  runMs(PAGE_TIMEOUT_MS, page4Ready);
+
+  host_check(emu.page == 4, "addt: emulator page", "%6.0f", emu.page);
+  host_check(!emu.refreshStopped, "addt: refresh stopped", "%6.0f", emu.refreshStopped);
+  host_check(Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 4), "addt: page 4 ready", "%6.0f", lcd.activePage);
+  host_check(lcd.pageConfirmTimeoutCnt == 0, "addt: page confirm timeouts", "%6.0f", lcd.pageConfirmTimeoutCnt);
+}
+
+/**
+* @fn scenarioFrameTime(void)
+* @brief Pomiar czasu ramki wyslanej w jednej paczce za sendme i zmiana strony, ktorych odpowiedzi nadchodza wczesniej
+*/
+static void scenarioFrameTime(void)
+{
+  Nextion_Enhanced_NX3224K028_sendme(&lcd);
+  Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 1);
+
+  Nextion_Enhanced_NX3224K028_beginFrame(&lcd);
+  for (uint16_t i = 0; Nextion_Enhanced_NX3224K028_writeNumberToControl(&lcd, (const uint8_t*)"n0", i); i++);
+  Nextion_Enhanced_NX3224K028_endFrame(&lcd);
+  Nextion_Enhanced_NX3224K028_flush(&lcd);
+
+  uint32_t burstMs = sim.txLength * byteNs() / 1000000;
+
+  runMs(PAGE_TIMEOUT_MS, frameTimeDone);
+
+  host_check(frameTimeDone(), "frame time: measured", "%6.0f", lcd.txFrameTimePending);
+  host_check(lcd.frameTime >= burstMs, "frame time: not before burst end", "%6.0f ms", lcd.frameTime);
+  host_check(lcd.frameTime < NEXTION_FRAME_TIME_TIMEOUT, "frame time: reply matched", "%6.0f ms", lcd.frameTime);
+  host_check(page1Ready(), "frame time: page 1 confirmed", "%6.0f", lcd.activePage);
+}
+
+/**
+* @fn scenarioCommandCount(void)
+* @brief Liczba komend zmiany strony i strony priorytetowej doliczana do statystyk
+*/
+static void scenarioCommandCount(void)
+{
+  Nextion_Enhanced_NX3224K028_loadNewPage(&lcd, 4);
+
+  uint32_t windowStart = lcd.txStatsWindowStart;
+  uint32_t before = lcd.txStatsCmdCnt;
+
+  Nextion_Enhanced_NX3224K028_flush(&lcd);
+
+  //Poczatek nowego okna statystyk w trakcie flush() zeruje licznik
+  if (lcd.txStatsWindowStart != windowStart) before = 0;
+
+  host_check(lcd.txStatsCmdCnt - before == 2, "commands: page change", "%6.0f", lcd.txStatsCmdCnt - before);
+
+  runMs(PAGE_TIMEOUT_MS, page4Ready);
+  before = lcd.txStatsCmdCnt;
+
+  Nextion_Enhanced_NX3224K028_loadNewPagePriority(&lcd, 3);
+
+  host_check(lcd.txStatsCmdCnt - before == 3, "commands: priority page", "%6.0f", lcd.txStatsCmdCnt - before);
+
+  runMs(PAGE_TIMEOUT_MS, page3Ready);
+  host_check(page3Ready(), "commands: page 3 confirmed", "%6.0f", lcd.activePage);
+}
+
+// ******************************************************************************************************************************************************** //
+
+uint32_t HAL_GetTick(void)
+{
+  return sim.timeNs / 1000000;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *uart)
+{
+  (void)uart;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *uart, uint8_t *data, uint16_t size)
+{
+  if (uart->gState != HAL_UART_STATE_READY)
+    {
+      return HAL_BUSY;
+    }
+
+  sim.txData = data;
+  sim.txLength = size;
+  sim.txPos = 0;
+  sim.txStartNs = sim.timeNs;
+  uart->gState = HAL_UART_STATE_BUSY_TX;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *uart, uint8_t *data, uint16_t size)
+{
+  //Biblioteka odbiera po jednym bajcie, rxCpltCallback() wywolywany jest dla kazdego bajtu odpowiedzi
+  (void)size;
+
+  sim.rxData = data;
+  uart->RxState = HAL_UART_STATE_BUSY_RX;
+
+  return HAL_OK;
+}
+
+/*
+ * Bajt w rejestrze przesuwnym nie jest dokanczany, wyswietlacz odbiera tylko bajty wyslane w calosci
+ */
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *uart)
+{
+  sim.txLength = sim.txPos;
+  uart->gState = HAL_UART_STATE_READY;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *uart)
+{
+  HAL_UART_AbortTransmit(uart);
+  uart->RxState = HAL_UART_STATE_READY;
+
+  return HAL_OK;
+}
+
+// ******************************************************************************************************************************************************** //
+
+static uint64_t byteNs(void)
+{
+  return 10000000000ULL / BAUDRATE;
+}
+
+/**
+* @fn simStep(void)
+* @brief STEP_US symulacji: bajty wyslane przez DMA trafiaja do emulatora, jego odpowiedzi do przerwania odbiorczego biblioteki
+*/
+static void simStep(void)
+{
+  sim.timeNs += STEP_US * 1000;
+
+  while ( (huart.gState == HAL_UART_STATE_BUSY_TX) && (sim.txStartNs + (sim.txPos + 1) * byteNs() <= sim.timeNs) )
+    {
+      nextion_emulator_feed(&emu, &sim.txData[sim.txPos], 1, (sim.txStartNs + sim.txPos * byteNs()) / 1000);
+
+      if (++sim.txPos == sim.txLength)
+	{
+	  huart.gState = HAL_UART_STATE_READY;
+	}
+    }
+
+  nextion_emulator_run(&emu, sim.timeNs / 1000);
+
+  uint8_t byte;
+  while (nextion_emulator_readReply(&emu, &byte, 1, sim.timeNs / 1000) == 1)
+    {
+      //Bajt odebrany przy wylaczonym odbiorze jest tracony (jak przy bledzie przepelnienia)
+      if (huart.RxState != HAL_UART_STATE_BUSY_RX) continue;
+
+      huart.RxState = HAL_UART_STATE_READY;
+      *sim.rxData = byte;
+      Nextion_Enhanced_NX3224K028_rxCpltCallback(&huart);
+    }
+}
+
+/**
+* @fn runMs(uint32_t ms, uint8_t (*done)(void))
+* @brief Praca zadania LCD przez maksymalnie ms milisekund lub do spelnienia warunku done
+*/
+static void runMs(uint32_t ms, uint8_t (*done)(void))
+{
+  uint64_t endNs = sim.timeNs + ms * 1000000ULL;
+
+  while ( (sim.timeNs < endNs) && !done() )
+    {
+      for (uint32_t us = 0; us < LOOP_PERIOD_US; us += STEP_US) simStep();
+
+      Nextion_Enhanced_NX3224K028_parseReceivedData(&lcd);
+      Nextion_Enhanced_NX3224K028_flush(&lcd);
+    }
+}
+
+static uint8_t page1Ready(void)
+{
+  return Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 1) && (emu.page == 1);
+}
+
+static uint8_t page3Ready(void)
+{
+  return Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 3) && (emu.page == 3);
+}
+
+static uint8_t page4Ready(void)
+{
+  return Nextion_Enhanced_NX3224K028_isPageReady(&lcd, 4) && (emu.page == 4);
+}
+
+static uint8_t frameTimeDone(void)
+{
+  return !lcd.txFrameTimePending;
+}
+
+static uint8_t burstCut(void)
+{
+  return (huart.gState == HAL_UART_STATE_BUSY_TX) && emu.refreshStopped && (emu.rxCmdLength > 0) && (emu.rxTerminatorCnt == 0);
+}
@@ -0,0 +1,49 @@
+/**
+* @file usart.h
+* @brief Zastepczy naglowek HAL UART do kompilacji External_libraries/Nextion_Enhanced_NX3224K028.c na komputerze
+* @details Zawiera tylko pola i funkcje wykorzystywane przez biblioteke wyswietlacza. Funkcje sa zaimplementowane w nextion_priority_test.c,
+* ktory modeluje transmisje DMA z predkoscia lacza i przekazuje bajty do emulatora (Tools/nextion_emulator).
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum
+{
+  HAL_OK,
+  HAL_ERROR,
+  HAL_BUSY
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  HAL_UART_STATE_READY,
+  HAL_UART_STATE_BUSY_TX,
+  HAL_UART_STATE_BUSY_RX
+} HAL_UART_StateTypeDef;
+
+typedef struct
+{
+  uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct
+{
+  void *Instance;
+  UART_InitTypeDef Init;
+  volatile HAL_UART_StateTypeDef gState;	///< Stan czesci nadawczej
+  volatile HAL_UART_StateTypeDef RxState;	///< Stan czesci odbiorczej
+} UART_HandleTypeDef;
+
+extern uint32_t HAL_GetTick(void);
+extern HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+extern HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+extern HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+extern HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart);
+extern HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart);
@@ -0,0 +1,399 @@
+/**
+* @file paddle_sim.c
+* @brief Test przetwarzania pomiaru manetki (Hydrogreen/paddle.c) na syntetycznych sygnalach, uruchamiany na komputerze
+* @details Symulacja odtwarza prace ADC i DMA: co 0,1ms kolejna probka 12-bit trafia do bufora kolowego PADDLE_WINDOW elementow,
+* co 1ms wywolywane jest paddle_process() tak jak paddle_step() na mikrokontrolerze. Do sygnalu dodawany jest szum
+* (deterministyczny generator, wyniki sa powtarzalne) oraz zaklocenie 50Hz. Sprawdzane sa: brak zmian przy zwolnionej
+* i nieruchomej manetce, czas odpowiedzi na skok, monotonicznosc przy powolnym ruchu, wykrycie przerwanego przewodu
+* z blokada do czasu zwolnienia, kalibracja oraz gest kalibracji (tylko na postoju, bez reakcji na kombinacje MODE_1 + MODE_2
+* rozpoczeta od MODE_2). Kod wyjscia 1 oznacza niespelnienie ktoregos z warunkow. Kompilacja:
+*
+*   gcc -std=gnu99 -O2 -Wall -DPADDLE_HOST -I.. -I../../Hydrogreen -o paddle_sim paddle_sim.c ../../Hydrogreen/paddle.c -lm
+*
+*   paddle_sim [-c przebieg.csv]
+*
+* Z opcja -c zapisywany jest przebieg wszystkich scenariuszy: czas [ms], wejscie (12-bit), paddle_raw, paddle_filtered, paddle_value, paddle_mode.
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "paddle.h"
+#include "host_check.h"
+
+#define SAMPLES_PER_STEP	10		///< Probki ADC (10kHz) na jedno wywolanie paddle_process() (1kHz)
+#define NOISE_LSB		12		///< Amplituda szumu [LSB 12-bit]
+#define HUM_LSB			8		///< Amplituda zaklocenia 50Hz [LSB 12-bit]
+#define STEP_RESPONSE_MAX_MS	15		///< Maksymalny czas od skoku do 90% PADDLE_VALUE_MAX [ms]
+
+#define PERCENT_TO_ADC(percent)	(ADC_MIN + ((ADC_MAX - ADC_MIN) * (percent)) / 100)
+#define ADC_MIN			(PADDLE_DEFAULT_RAW_MIN / 16)		///< Pomiar 12-bit odpowiadajacy kalibracji domyslnej
+#define ADC_MAX			(PADDLE_DEFAULT_RAW_MAX / 16)
+
+/**
+* @struct SIM
+* @brief Stan symulowanego ADC i DMA
+*/
+typedef struct
+{
+  uint16_t window[PADDLE_WINDOW];
+  uint32_t pos;				///< Indeks kolejnej probki zapisywanej przez "DMA"
+  uint32_t timeMs;
+  uint32_t seed;
+  FILE *csv;
+  double input;				///< Ostatnia wartosc wejsciowa bez szumu (12-bit)
+} SIM;
+
+static SIM sim;
+
+// ******************************************************************************************************************************************************** //
+
+static void simReset(void);
+static void simStep(double input);
+static void scenarioIdle(void);
+static void scenarioHold(void);
+static void scenarioStep(void);
+static void scenarioRamp(void);
+static void scenarioBrokenWire(void);
+static void scenarioCalibration(void);
+static void scenarioCalibrationGesture(void);
+static void holdButton(uint32_t holdMs, uint8_t otherAtMs);
+
+// ******************************************************************************************************************************************************** //
+
+int main(int argc, char **argv)
+{
+  if (argc == 3 && strcmp(argv[1], "-c") == 0)
+    {
+      sim.csv = fopen(argv[2], "w");
+
+      if (sim.csv == NULL)
+	{
+	  perror(argv[2]);
+	  return 1;
+	}
+
+      fprintf(sim.csv, "time_ms,input,raw,filtered,value,mode\n");
+    }
+  else if (argc != 1)
+    {
+      return host_check_usage(argv[0], "[-c trace.csv]");
+    }
+
+  scenarioIdle();
+  scenarioHold();
+  scenarioStep();
+  scenarioRamp();
+  scenarioBrokenWire();
+  scenarioCalibration();
+  scenarioCalibrationGesture();
+
+  if (sim.csv != NULL) fclose(sim.csv);
+
+  return host_check_result();
+}
+
+/**
+* @fn simReset(void)
+* @brief Nowy scenariusz: kalibracja domyslna, bufor wypelniony pomiarem zwolnionej manetki
+*/
+static void simReset(void)
+{
+  paddle_reset();
+
+  for (uint32_t i = 0; i < PADDLE_WINDOW; i++) sim.window[i] = ADC_MIN;
+
+  sim.pos = 0;
+  sim.seed = 12345;
+}
+
+/**
+* @fn simStep(double input)
+* @brief 1ms symulacji: SAMPLES_PER_STEP probek z szumem zapisanych do bufora kolowego, nastepnie paddle_process()
+*/
+static void simStep(double input)
+{
+  for (uint32_t i = 0; i < SAMPLES_PER_STEP; i++)
+    {
+      double timeS = (sim.timeMs * SAMPLES_PER_STEP + i) * 1e-4;
+
+      //Szum trojkatny z dwoch liczb xorshift32
+      sim.seed ^= sim.seed << 13;
+      sim.seed ^= sim.seed >> 17;
+      sim.seed ^= sim.seed << 5;
+      double noise = (double)(sim.seed & 0xFFFF) / 0xFFFF;
+      sim.seed ^= sim.seed << 13;
+      sim.seed ^= sim.seed >> 17;
+      sim.seed ^= sim.seed << 5;
+      noise -= (double)(sim.seed & 0xFFFF) / 0xFFFF;
+
+      double sample = input + noise * NOISE_LSB + HUM_LSB * sin(2 * M_PI * 50 * timeS);
+
+      if (sample < 0) sample = 0;
+      if (sample > 4095) sample = 4095;
+
+      sim.window[sim.pos++ & (PADDLE_WINDOW - 1)] = (uint16_t)lround(sample);
+    }
+
+  paddle_process(sim.window);
+  sim.timeMs++;
+  sim.input = input;
+
+  if (sim.csv != NULL)
+    {
+      fprintf(sim.csv, "%lu,%.1f,%u,%u,%u,%d\n", (unsigned long)sim.timeMs, input, paddle_raw, paddle_filtered, paddle_value, paddle_mode);
+    }
+}
+
+/**
+* @fn scenarioIdle(void)
+* @brief Zwolniona manetka z szumem: paddle_value musi pozostac 0, blokada po starcie musi zostac zdjeta
+*/
+static void scenarioIdle(void)
+{
+  uint32_t nonZero = 0;
+
+  simReset();
+
+  for (uint32_t ms = 0; ms < 1000; ms++)
+    {
+      simStep(ADC_MIN);
+      if (paddle_value != 0) nonZero++;
+    }
+
+  host_check(nonZero == 0, "idle: value != 0", "%6.0f ms", nonZero);
+  host_check(paddle_mode == PADDLE_MODE_RUN, "idle: mode after start", "%6.0f", paddle_mode);
+}
+
+/**
+* @fn scenarioHold(void)
+* @brief Nieruchoma manetka w polowie zakresu: po ustaleniu sie wartosci nie moze ona zmieniac sie od szumu
+*/
+static void scenarioHold(void)
+{
+  uint32_t changes = 0;
+
+  simReset();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(ADC_MIN);
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(PERCENT_TO_ADC(50));
+
+  uint8_t previous = paddle_value;
+
+  for (uint32_t ms = 0; ms < 2000; ms++)
+    {
+      simStep(PERCENT_TO_ADC(50));
+      if (paddle_value != previous) changes++;
+      previous = paddle_value;
+    }
+
+  host_check(changes == 0, "hold 50%: value changes", "%6.0f", changes);
+  host_check(paddle_value > 110 && paddle_value < 145, "hold 50%: value", "%6.0f", paddle_value);
+}
+
+/**
+* @fn scenarioStep(void)
+* @brief Skok z zwolnionej do wcisnietej manetki i z powrotem, czas do 90% i do zera
+*/
+static void scenarioStep(void)
+{
+  uint32_t riseMs = UINT32_MAX;
+  uint32_t fallMs = UINT32_MAX;
+
+  simReset();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(ADC_MIN);
+
+  for (uint32_t ms = 0; ms < 100; ms++)
+    {
+      simStep(ADC_MAX);
+      if ( (riseMs == UINT32_MAX) && (paddle_value >= PADDLE_VALUE_MAX * 9 / 10) ) riseMs = ms + 1;
+    }
+
+  host_check(paddle_value == PADDLE_VALUE_MAX, "step: value at full press", "%6.0f", paddle_value);
+
+  for (uint32_t ms = 0; ms < 100; ms++)
+    {
+      simStep(ADC_MIN);
+      if ( (fallMs == UINT32_MAX) && (paddle_value == 0) ) fallMs = ms + 1;
+    }
+
+  host_check(riseMs <= STEP_RESPONSE_MAX_MS, "step: 0 -> 90%", "%6.0f ms", riseMs);
+  host_check(fallMs <= STEP_RESPONSE_MAX_MS, "step: 100% -> 0", "%6.0f ms", fallMs);
+}
+
+/**
+* @fn scenarioRamp(void)
+* @brief Powolne wcisniecie i zwolnienie (po 1s), wartosc nie moze sie cofac ani przeskakiwac o wiecej niz kilka LSB
+*/
+static void scenarioRamp(void)
+{
+  uint32_t reversals = 0;
+  uint32_t maxJump = 0;
+
+  simReset();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(ADC_MIN);
+
+  for (int32_t direction = 1; direction >= -1; direction -= 2)
+    {
+      uint8_t previous = paddle_value;
+
+      for (uint32_t ms = 0; ms <= 1000; ms++)
+	{
+	  double percent = (direction > 0) ? ms / 10.0 : 100 - ms / 10.0;
+	  simStep(ADC_MIN + (ADC_MAX - ADC_MIN) * percent / 100);
+
+	  int32_t delta = (int32_t)paddle_value - previous;
+	  if (delta * direction < 0) reversals++;
+	  if ((uint32_t)abs(delta) > maxJump) maxJump = abs(delta);
+	  previous = paddle_value;
+	}
+
+      host_check(paddle_value == ((direction > 0) ? PADDLE_VALUE_MAX : 0), (direction > 0) ? "ramp up: final value" : "ramp down: final value",
+	    "%6.0f", paddle_value);
+    }
+
+  host_check(reversals == 0, "ramp: reversals", "%6.0f", reversals);
+  host_check(maxJump <= 3, "ramp: max jump", "%6.0f LSB", maxJump);
+}
+
+/**
+* @fn scenarioBrokenWire(void)
+* @brief Przerwany przewod przy wcisnietej manetce: blad, paddle_value = 0 do czasu ponownego zwolnienia manetki
+*/
+static void scenarioBrokenWire(void)
+{
+  uint32_t detectMs = UINT32_MAX;
+  uint32_t nonZero = 0;
+
+  simReset();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(ADC_MIN);
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(PERCENT_TO_ADC(60));
+
+  for (uint32_t ms = 0; ms < 100; ms++)
+    {
+      simStep(0);
+      if ( (detectMs == UINT32_MAX) && (paddle_mode == PADDLE_MODE_FAULT) ) detectMs = ms + 1;
+    }
+
+  host_check(detectMs <= PADDLE_FAULT_STEPS + 10, "broken wire: detection", "%6.0f ms", detectMs);
+  host_check(paddle_faultCnt == 1, "broken wire: fault count", "%6.0f", paddle_faultCnt);
+
+  //Przewod naprawiony przy wcisnietej manetce, wartosc musi pozostac 0
+  for (uint32_t ms = 0; ms < 200; ms++)
+    {
+      simStep(PERCENT_TO_ADC(60));
+      if (paddle_value != 0) nonZero++;
+    }
+
+  host_check(nonZero == 0, "broken wire: value before release", "%6.0f ms", nonZero);
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(ADC_MIN);
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(PERCENT_TO_ADC(60));
+
+  host_check(paddle_value > 130 && paddle_value < 170, "broken wire: value after release", "%6.0f", paddle_value);
+}
+
+/**
+* @fn scenarioCalibration(void)
+* @brief Czujnik o innym zakresie niz domyslny: po kalibracji pelne wcisniecie daje PADDLE_VALUE_MAX, zbyt maly zakres jest odrzucany
+*/
+static void scenarioCalibration(void)
+{
+  const double calMin = 900;
+  const double calMax = 3000;
+
+  simReset();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMin);
+
+  paddle_startCalibration();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMin + (calMax - calMin) * ms / 100);
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMax);
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMax - (calMax - calMin) * ms / 100);
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMin);
+
+  host_check(paddle_finishCalibration(), "calibration: accepted", "%6.0f", 1);
+  host_check(fabs(paddle_calibration.rawMin / 16.0 - calMin) < 10, "calibration: min", "%6.0f", paddle_calibration.rawMin / 16.0);
+  host_check(fabs(paddle_calibration.rawMax / 16.0 - calMax) < 10, "calibration: max", "%6.0f", paddle_calibration.rawMax / 16.0);
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMin);
+  host_check(paddle_value == 0, "calibration: released", "%6.0f", paddle_value);
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMax);
+  host_check(paddle_value == PADDLE_VALUE_MAX, "calibration: full press", "%6.0f", paddle_value);
+
+  //Zbyt maly zakres (manetka nie zostala wcisnieta), obowiazuje poprzednia kalibracja
+  PADDLE_CALIBRATION previous = paddle_calibration;
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(calMin);
+
+  paddle_startCalibration();
+  for (uint32_t ms = 0; ms < 300; ms++) simStep(calMin);
+
+  host_check(!paddle_finishCalibration(), "calibration: small span rejected", "%6.0f", 1);
+  host_check( (paddle_calibration.rawMin == previous.rawMin) && (paddle_calibration.rawMax == previous.rawMax), "calibration: previous kept", "%6.0f", 1);
+}
+
+/**
+* @fn holdButton(uint32_t holdMs, uint8_t otherAtMs)
+* @brief Przytrzymanie MODE_2 przez holdMs przy zwolnionej manetce, otherAtMs != 0 - wcisniecie MODE_1 po tym czasie (kombinacja)
+*/
+static void holdButton(uint32_t holdMs, uint8_t otherAtMs)
+{
+  paddle_button(PADDLE_BUTTON_PRESS, 0);
+
+  for (uint32_t ms = 0; ms < holdMs; ms++)
+    {
+      if ( otherAtMs && (ms == otherAtMs * 1000UL) ) paddle_button(PADDLE_BUTTON_OTHER, 0);
+      simStep(ADC_MIN);
+    }
+
+  paddle_button(PADDLE_BUTTON_RELEASE, holdMs);
+}
+
+/**
+* @fn scenarioCalibrationGesture(void)
+* @brief Gest kalibracji: odrzucony w ruchu, pomijany przy kombinacji MODE_1 + MODE_2 i zbyt krotkim przytrzymaniu, przerwany po ruszeniu
+*/
+static void scenarioCalibrationGesture(void)
+{
+  simReset();
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(ADC_MIN);
+
+  paddle_setStopped(0);
+  holdButton(PADDLE_CAL_HOLD_MS + 500, 0);
+  host_check(paddle_mode != PADDLE_MODE_CALIBRATION, "gesture: refused while moving", "%6.0f", paddle_mode);
+
+  //Kierowca rozpoczyna kombinacje ponownej inicjalizacji LCD od przytrzymania MODE_2, MODE_1 dochodzi po PADDLE_CAL_HOLD_MS
+  paddle_setStopped(1);
+  holdButton(PADDLE_CAL_HOLD_MS + 3000, PADDLE_CAL_HOLD_MS / 1000 + 1);
+  host_check(paddle_mode != PADDLE_MODE_CALIBRATION, "gesture: MODE_2 into chord ignored", "%6.0f", paddle_mode);
+
+  holdButton(PADDLE_CAL_HOLD_MS - 500, 0);
+  host_check(paddle_mode != PADDLE_MODE_CALIBRATION, "gesture: short hold ignored", "%6.0f", paddle_mode);
+
+  holdButton(PADDLE_CAL_HOLD_MS + 500, 0);
+  host_check(paddle_mode == PADDLE_MODE_CALIBRATION, "gesture: started at standstill", "%6.0f", paddle_mode);
+
+  //Ruszenie w trakcie kalibracji, obowiazuje poprzednia kalibracja i blokada do zwolnienia manetki
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(PERCENT_TO_ADC(60));
+
+  paddle_setStopped(0);
+  host_check(paddle_mode == PADDLE_MODE_WAIT_RELEASE, "gesture: cancelled when moving", "%6.0f", paddle_mode);
+  host_check( (paddle_calibration.rawMin == PADDLE_DEFAULT_RAW_MIN) && (paddle_calibration.rawMax == PADDLE_DEFAULT_RAW_MAX),
+	 "gesture: previous kept", "%6.0f", 1);
+
+  for (uint32_t ms = 0; ms < 100; ms++) simStep(PERCENT_TO_ADC(60));
+  host_check(paddle_value == 0, "gesture: value before release", "%6.0f", paddle_value);
+}
@@ -0,0 +1,352 @@
+/**
+* @file speed_estimator_sim.c
+* @brief Test estymatora predkosci (Hydrogreen/speed_estimator.c) na przebiegach predkosci, uruchamiany na komputerze
+* @details Symulacja odtwarza prace lcd_control.c: ramki telemetrii przychodza srednio co okres ramki z rozrzutem +-25% i gubieniem
+* 10% ramek (deterministyczny generator, wyniki sa powtarzalne), predkosc w ramce jest obcieta do pelnych km/h (jak interimSpeed),
+* pasek SB jest odswiezany co 5ms. Przebieg pochodzi z profilu syntetycznego (rozpedzanie, jazda, hamowanie) lub z pliku CSV
+* (czas [ms], predkosc [km/h]). Sprawdzane sa:
+* - zmiana wyniku w chwili odebrania ramki (wynik przed i po speed_estimator_addSample() musi byc taki sam),
+* - zakres wyniku: pomiedzy wynikiem w chwili ostatniej ramki a +-SPEED_ESTIMATOR_MAX_OVERSHOOT od ostatniej probki,
+*   po uplywie okresu ramki tylko +-SPEED_ESTIMATOR_MAX_OVERSHOOT,
+* - najwieksza zmiana paska na jedno odswiezenie (5ms, tylko przebiegi plynne),
+* - blad wzgledem przebiegu: nie wiekszy niz blad wyswietlania ostatniej probki (pasek przed wprowadzeniem estymatora)
+*   powiekszony o SPEED_ESTIMATOR_MAX_OVERSHOOT (tylko przebiegi plynne).
+* Kod wyjscia 1 oznacza niespelnienie ktoregos z warunkow. Kompilacja:
+*
+*   gcc -std=gnu99 -O2 -Wall -I.. -I../../Hydrogreen -o speed_estimator_sim speed_estimator_sim.c ../../Hydrogreen/speed_estimator.c -lm
+*
+*   speed_estimator_sim [-t przebieg.csv] [-c wynik.csv]
+*
+* Z opcja -t zamiast profilu syntetycznego odtwarzany jest zapisany przebieg. Z opcja -c zapisywany jest wynik wszystkich scenariuszy:
+* czas [ms], predkosc z przebiegu, ostatnia probka, wynik estymatora [km/h].
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "speed_estimator.h"
+#include "host_check.h"
+
+#define BAR_PERIOD_MS		5		///< Okres odswiezania paska SB (mode1Page() w lcd_control.c) [ms]
+#define JITTER_PERCENT		25		///< Rozrzut okresu ramek [% okresu]
+#define LOSS_PERCENT		10		///< Odsetek zgubionych ramek (bledne CRC) [%]
+#define BAR_STEP_MAX		0.5f		///< Maksymalna zmiana wyniku na jedno odswiezenie paska (1% paska SB) [km/h]
+#define ARRIVAL_STEP_MAX	0.001f		///< Maksymalna zmiana wyniku w chwili odebrania ramki [km/h]
+#define BAND_EPSILON		0.001f		///< Tolerancja obliczen zmiennoprzecinkowych przy sprawdzaniu zakresu [km/h]
+#define TRACE_MAX_POINTS	100000		///< Maksymalna liczba punktow przebiegu z pliku
+
+/**
+* @struct RESULT
+* @brief Najgorsze wartosci zanotowane w jednym scenariuszu
+*/
+typedef struct
+{
+  float barStep;			///< Najwieksza zmiana wyniku pomiedzy odswiezeniami paska [km/h]
+  float error;				///< Najwiekszy blad wzgledem przebiegu [km/h]
+  float holdError;			///< Najwiekszy blad ostatniej probki wzgledem przebiegu [km/h]
+  float arrivalStep;			///< Najwieksza zmiana wyniku w chwili odebrania ramki [km/h]
+  float bandExcess;			///< Najwieksze wyjscie poza dopuszczalny zakres [km/h]
+  uint32_t frames;			///< Liczba odebranych ramek
+} RESULT;
+
+/**
+* @struct TRACE
+* @brief Przebieg wczytany z pliku CSV
+*/
+typedef struct
+{
+  uint32_t count;
+  uint32_t timeMs[TRACE_MAX_POINTS];
+  float speed[TRACE_MAX_POINTS];
+} TRACE;
+
+static TRACE trace;
+static FILE *csv;
+static uint32_t seed;
+
+// ******************************************************************************************************************************************************** //
+
+static uint8_t loadTrace(const char *path);
+static float traceSpeed(uint32_t timeMs);
+static float driveSpeed(uint32_t timeMs);
+static float stepSpeed(uint32_t timeMs);
+static float outageSpeed(uint32_t timeMs);
+static uint32_t randomPercent(void);
+static RESULT run(float (*speedAt)(uint32_t), uint32_t durationMs, uint32_t periodMs, uint32_t outageStart, uint32_t outageEnd);
+
+// ******************************************************************************************************************************************************** //
+
+int main(int argc, char **argv)
+{
+  const char *tracePath = NULL;
+
+  for (int i = 1; i < argc; i++)
+    {
+      if ( (strcmp(argv[i], "-t") == 0) && (i + 1 < argc) )
+	{
+	  tracePath = argv[++i];
+	}
+      else if ( (strcmp(argv[i], "-c") == 0) && (i + 1 < argc) )
+	{
+	  csv = fopen(argv[++i], "w");
+
+	  if (csv == NULL)
+	    {
+	      perror(argv[i]);
+	      return 1;
+	    }
+
+	  fprintf(csv, "time_ms,speed,sample,estimate\n");
+	}
+      else
+	{
+	  return host_check_usage(argv[0], "[-t trace.csv] [-c output.csv]");
+	}
+    }
+
+  if ( (tracePath != NULL) && !loadTrace(tracePath) )
+    {
+      return 1;
+    }
+
+  //Przebiegi plynne: wszystkie warunki przy roznych okresach ramek
+  static const uint32_t periods[] = { 100, 250, 400 };
+
+  for (uint32_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++)
+    {
+      char name[48];
+      RESULT result;
+
+      if (tracePath != NULL)
+	{
+	  result = run(traceSpeed, trace.timeMs[trace.count - 1], periods[i], 0, 0);
+	}
+      else
+	{
+	  result = run(driveSpeed, 20000, periods[i], 0, 0);
+	}
+
+      printf("frame period %lu ms, %lu frames\n", (unsigned long)periods[i], (unsigned long)result.frames);
+
+      snprintf(name, sizeof(name), "  bar step per %d ms", BAR_PERIOD_MS);
+      host_check(result.barStep <= BAR_STEP_MAX, name, "%6.3f km/h", result.barStep);
+      printf("%-40s %6.3f km/h\n", "  last sample error against trace", result.holdError);
+      host_check(result.error <= result.holdError + SPEED_ESTIMATOR_MAX_OVERSHOOT, "  error against trace", "%6.3f km/h", result.error);
+      host_check(result.arrivalStep <= ARRIVAL_STEP_MAX, "  step at frame arrival", "%6.3f km/h", result.arrivalStep);
+      host_check(result.bandExcess <= BAND_EPSILON, "  outside band", "%6.3f km/h", result.bandExcess);
+    }
+
+  //Skok predkosci o 20km/h (residuum powyzej zakresu ograniczenia) oraz przerwa dluzsza niz SPEED_ESTIMATOR_MAX_SAMPLE_PERIOD
+  RESULT step = run(stepSpeed, 3000, 100, 0, 0);
+
+  printf("speed step 10 -> 30 km/h\n");
+  host_check(step.arrivalStep <= ARRIVAL_STEP_MAX, "  step at frame arrival", "%6.3f km/h", step.arrivalStep);
+  host_check(step.bandExcess <= BAND_EPSILON, "  outside band", "%6.3f km/h", step.bandExcess);
+
+  RESULT outage = run(outageSpeed, 6000, 100, 2000, 3500);
+
+  printf("1500 ms without frames while braking\n");
+  host_check(outage.arrivalStep <= ARRIVAL_STEP_MAX, "  step at frame arrival", "%6.3f km/h", outage.arrivalStep);
+  host_check(outage.bandExcess <= BAND_EPSILON, "  outside band", "%6.3f km/h", outage.bandExcess);
+
+  if (csv != NULL) fclose(csv);
+
+  return host_check_result();
+}
+
+/**
+* @fn loadTrace(const char *path)
+* @brief Wczytanie przebiegu: w kazdej linii czas [ms] i predkosc [km/h] oddzielone przecinkiem, linie nie zaczynajace sie od liczby sa pomijane
+*/
+static uint8_t loadTrace(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  char line[128];
+
+  if (file == NULL)
+    {
+      perror(path);
+      return 0;
+    }
+
+  while ( (fgets(line, sizeof(line), file) != NULL) && (trace.count < TRACE_MAX_POINTS) )
+    {
+      unsigned long timeMs;
+      float speed;
+
+      if (sscanf(line, "%lu,%f", &timeMs, &speed) != 2) continue;
+
+      if ( (trace.count > 0) && (timeMs <= trace.timeMs[trace.count - 1]) )
+	{
+	  fprintf(stderr, "%s: time not increasing at %lu ms\n", path, timeMs);
+	  fclose(file);
+	  return 0;
+	}
+
+      trace.timeMs[trace.count] = timeMs;
+      trace.speed[trace.count] = speed;
+      trace.count++;
+    }
+
+  fclose(file);
+
+  if (trace.count < 2)
+    {
+      fprintf(stderr, "%s: at least 2 points required\n", path);
+      return 0;
+    }
+
+  return 1;
+}
+
+/**
+* @fn traceSpeed(uint32_t timeMs)
+* @brief Predkosc z wczytanego przebiegu, interpolacja liniowa pomiedzy punktami
+*/
+static float traceSpeed(uint32_t timeMs)
+{
+  uint32_t i = 1;
+
+  if (timeMs <= trace.timeMs[0]) return trace.speed[0];
+
+  while ( (i < trace.count - 1) && (trace.timeMs[i] < timeMs) ) i++;
+
+  if (timeMs >= trace.timeMs[i]) return trace.speed[i];
+
+  float ratio = (float)(timeMs - trace.timeMs[i - 1]) / (trace.timeMs[i] - trace.timeMs[i - 1]);
+
+  return trace.speed[i - 1] + (trace.speed[i] - trace.speed[i - 1]) * ratio;
+}
+
+/**
+* @fn driveSpeed(uint32_t timeMs)
+* @brief Rozpedzanie 0 -> 40km/h w 10s, jazda ze stala predkoscia 5s, hamowanie do 0 w 5s
+*/
+static float driveSpeed(uint32_t timeMs)
+{
+  if (timeMs < 10000) return 40.0f * timeMs / 10000;
+  if (timeMs < 15000) return 40.0f;
+  if (timeMs < 20000) return 40.0f * (20000 - timeMs) / 5000;
+
+  return 0.0f;
+}
+
+static float stepSpeed(uint32_t timeMs)
+{
+  return (timeMs < 1000) ? 10.0f : 30.0f;
+}
+
+/**
+* @fn outageSpeed(uint32_t timeMs)
+* @brief Jazda 30km/h, od 2s hamowanie do 10km/h w 2s
+*/
+static float outageSpeed(uint32_t timeMs)
+{
+  if (timeMs < 2000) return 30.0f;
+  if (timeMs < 4000) return 30.0f - 20.0f * (timeMs - 2000) / 2000;
+
+  return 10.0f;
+}
+
+/**
+* @fn randomPercent(void)
+* @brief Liczba 0 - 99 z generatora xorshift32
+*/
+static uint32_t randomPercent(void)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+
+  return seed % 100;
+}
+
+/**
+* @fn run(float (*speedAt)(uint32_t), uint32_t durationMs, uint32_t periodMs, uint32_t outageStart, uint32_t outageEnd)
+* @brief Jeden scenariusz z krokiem 1ms, w przedziale [outageStart, outageEnd) ramki nie przychodza
+*/
+static RESULT run(float (*speedAt)(uint32_t), uint32_t durationMs, uint32_t periodMs, uint32_t outageStart, uint32_t outageEnd)
+{
+  RESULT result = { 0 };
+  uint32_t nextFrame = periodMs;
+  uint32_t lastFrame = 0;
+  uint32_t blendPeriod = 0;			///< Czas przejscia wyniku do nowej estymaty (jak samplePeriod w estymatorze)
+  uint8_t received = 0;
+  float sample = 0.0f;
+  float blendStart = 0.0f;
+  float lastBar = 0.0f;
+
+  seed = 12345;
+  speed_estimator_reset();
+
+  for (uint32_t now = 0; now <= durationMs; now++)
+    {
+      if (now == nextFrame)
+	{
+	  nextFrame += periodMs * (100 - JITTER_PERCENT + 2 * randomPercent() * JITTER_PERCENT / 100) / 100;
+
+	  if ( (randomPercent() >= LOSS_PERCENT) && ( (now < outageStart) || (now >= outageEnd) ) )
+	    {
+	      float before = speed_estimator_getSpeed(now);
+	      uint32_t gap = now - lastFrame;
+
+	      sample = floorf(speedAt(now));
+	      speed_estimator_addSample(sample, now);
+
+	      float after = speed_estimator_getSpeed(now);
+
+	      //Pierwsza ramka ustawia wynik od razu, pasek rusza od tej wartosci
+	      if (!received) lastBar = after;
+	      else if (fabsf(after - before) > result.arrivalStep) result.arrivalStep = fabsf(after - before);
+
+	      blendPeriod = !received ? 0 : (gap > SPEED_ESTIMATOR_MAX_SAMPLE_PERIOD) ? SPEED_ESTIMATOR_MAX_EXTRAPOLATION : gap;
+	      blendStart = before;
+	      lastFrame = now;
+	      received = 1;
+	      result.frames++;
+	    }
+	}
+
+      if (!received) continue;
+
+      float estimate = speed_estimator_getSpeed(now);
+
+      //Zakres: po przejsciu +-SPEED_ESTIMATOR_MAX_OVERSHOOT od probki, w trakcie przejscia rozszerzony o wynik w chwili odebrania ramki
+      float low = sample - SPEED_ESTIMATOR_MAX_OVERSHOOT;
+      float high = sample + SPEED_ESTIMATOR_MAX_OVERSHOOT;
+
+      if (now - lastFrame < blendPeriod)
+	{
+	  low = fminf(low, blendStart);
+	  high = fmaxf(high, blendStart);
+	}
+
+      float excess = fmaxf(estimate - high, fmaxf(low, 0.0f) - estimate);
+      if (excess > result.bandExcess) result.bandExcess = excess;
+
+      float error = fabsf(estimate - speedAt(now));
+      if (error > result.error) result.error = error;
+
+      float holdError = fabsf(sample - speedAt(now));
+      if (holdError > result.holdError) result.holdError = holdError;
+
+      if (now % BAR_PERIOD_MS == 0)
+	{
+	  if (fabsf(estimate - lastBar) > result.barStep) result.barStep = fabsf(estimate - lastBar);
+	  lastBar = estimate;
+	}
+
+      if (csv != NULL)
+	{
+	  fprintf(csv, "%lu,%.3f,%.0f,%.3f\n", (unsigned long)now, speedAt(now), sample, estimate);
+	}
+    }
+
+  return result;
+}
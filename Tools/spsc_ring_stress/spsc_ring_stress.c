@@ -0,0 +1,219 @@
+/**
+* @file spsc_ring_stress.c
+* @brief Test obciazeniowy bufora External_libraries/spsc_ring.h uruchamiany na komputerze
+* @details Producent i konsument pracuja w osobnych watkach i przekazuja kolejne liczby, konsument sprawdza ciaglosc sekwencji.
+* Wypisywany jest czas jednej operacji dla push/pop oraz dla operacji wsadowych, w jednym watku i pomiedzy watkami.
+* Kod wyjscia 1 oznacza utrate, powtorzenie lub zamiane kolejnosci elementu. Kompilacja:
+*
+*   gcc -std=gnu99 -O2 -Wall -pthread -I../../External_libraries -o spsc_ring_stress spsc_ring_stress.c
+*
+*   spsc_ring_stress [liczba elementow]
+*
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "spsc_ring.h"
+
+#define RING_SIZE		64		///< Jak bufor odbiorczy RS-485
+#define BATCH_SIZE		16		///< Dlugosc paczki w operacjach wsadowych
+
+SPSC_RING_DEFINE(STRESS_RING, stressRing, uint32_t, RING_SIZE)
+
+/**
+* @struct STRESS_RUN
+* @brief Parametry i wynik jednego przebiegu dwuwatkowego
+*/
+typedef struct
+{
+  STRESS_RING ring;
+  uint32_t itemCnt;
+  uint8_t batch;				///< 1 - pushBatch/popBatch, 0 - push/pop
+  uint32_t errors;				///< Liczba elementow odebranych poza kolejnoscia
+} STRESS_RUN;
+
+// ******************************************************************************************************************************************************** //
+
+static double nowNs(void);
+static void *producer(void *arg);
+static void *consumer(void *arg);
+static double singleThread(uint32_t itemCnt, uint8_t batch);
+static uint8_t twoThreads(uint32_t itemCnt, uint8_t batch, double *nsPerItem);
+
+// ******************************************************************************************************************************************************** //
+
+int main(int argc, char **argv)
+{
+  uint32_t itemCnt = (argc > 1) ? strtoul(argv[1], NULL, 10) : 20000000;
+  uint8_t ok = 1;
+  double ns;
+
+  if (itemCnt == 0)
+    {
+      fprintf(stderr, "usage: %s [item count]\n", argv[0]);
+      return 2;
+    }
+
+  printf("items: %lu, ring: %d, batch: %d\n", (unsigned long)itemCnt, RING_SIZE, BATCH_SIZE);
+  printf("single thread push+pop:            %6.2f ns/item\n", singleThread(itemCnt, 0));
+  printf("single thread pushBatch+popBatch:  %6.2f ns/item\n", singleThread(itemCnt, 1));
+
+  ok &= twoThreads(itemCnt, 0, &ns);
+  printf("two threads push / pop:            %6.2f ns/item\n", ns);
+
+  ok &= twoThreads(itemCnt, 1, &ns);
+  printf("two threads pushBatch / popBatch:  %6.2f ns/item\n", ns);
+
+  printf("%s\n", ok ? "OK" : "FAILED");
+
+  return ok ? 0 : 1;
+}
+
+static double nowNs(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+* @fn singleThread(uint32_t itemCnt, uint8_t batch)
+* @brief Koszt samych operacji na buforze (bez rywalizacji o linie pamieci podrecznej), zwraca czas na element [ns]
+*/
+static double singleThread(uint32_t itemCnt, uint8_t batch)
+{
+  static STRESS_RING ring;
+  uint32_t items[BATCH_SIZE];
+  volatile uint32_t sink = 0;
+
+  stressRing_init(&ring);
+
+  double start = nowNs();
+
+  for (uint32_t i = 0; i < itemCnt; i += BATCH_SIZE)
+    {
+      if (batch)
+	{
+	  for (uint32_t k = 0; k < BATCH_SIZE; k++) items[k] = i + k;
+
+	  stressRing_pushBatch(&ring, items, BATCH_SIZE);
+	  stressRing_popBatch(&ring, items, BATCH_SIZE);
+	  sink += items[BATCH_SIZE - 1];
+	}
+      else
+	{
+	  for (uint32_t k = 0; k < BATCH_SIZE; k++)
+	    {
+	      uint32_t item = i + k;
+
+	      stressRing_push(&ring, &item);
+	      stressRing_pop(&ring, &item);
+	      sink += item;
+	    }
+	}
+    }
+
+  return (nowNs() - start) / itemCnt;
+}
+
+/**
+* @fn twoThreads(uint32_t itemCnt, uint8_t batch, double *nsPerItem)
+* @brief Przekazanie itemCnt kolejnych liczb pomiedzy watkami, zwraca 0 jezeli sekwencja zostala naruszona
+*/
+static uint8_t twoThreads(uint32_t itemCnt, uint8_t batch, double *nsPerItem)
+{
+  static STRESS_RUN run;
+  pthread_t producerThread;
+  pthread_t consumerThread;
+
+  stressRing_init(&run.ring);
+  run.itemCnt = itemCnt;
+  run.batch = batch;
+  run.errors = 0;
+
+  double start = nowNs();
+
+  pthread_create(&consumerThread, NULL, consumer, &run);
+  pthread_create(&producerThread, NULL, producer, &run);
+  pthread_join(producerThread, NULL);
+  pthread_join(consumerThread, NULL);
+
+  *nsPerItem = (nowNs() - start) / itemCnt;
+
+  if (run.errors)
+    {
+      fprintf(stderr, "%s: %lu items out of sequence\n", batch ? "batch" : "single", (unsigned long)run.errors);
+    }
+
+  return run.errors == 0;
+}
+
+static void *producer(void *arg)
+{
+  STRESS_RUN *run = arg;
+  uint32_t items[BATCH_SIZE];
+  uint32_t next = 0;
+
+  while (next < run->itemCnt)
+    {
+      if (run->batch)
+	{
+	  uint32_t cnt = run->itemCnt - next;
+	  if (cnt > BATCH_SIZE) cnt = BATCH_SIZE;
+
+	  for (uint32_t k = 0; k < cnt; k++) items[k] = next + k;
+
+	  uint32_t pushed = stressRing_pushBatch(&run->ring, items, cnt);
+
+	  if (pushed == 0) sched_yield();
+	  next += pushed;
+	}
+      else if (stressRing_push(&run->ring, &next))
+	{
+	  next++;
+	}
+      else
+	{
+	  //Bufor pelny, na komputerze z jednym rdzeniem oddaj czas konsumentowi
+	  sched_yield();
+	}
+    }
+
+  return NULL;
+}
+
+static void *consumer(void *arg)
+{
+  STRESS_RUN *run = arg;
+  uint32_t items[BATCH_SIZE];
+  uint32_t expected = 0;
+
+  while (expected < run->itemCnt)
+    {
+      uint32_t cnt = run->batch ? stressRing_popBatch(&run->ring, items, BATCH_SIZE) : stressRing_pop(&run->ring, &items[0]);
+
+      if (cnt == 0) sched_yield();
+
+      for (uint32_t k = 0; k < cnt; k++)
+	{
+	  if (items[k] != expected)
+	    {
+	      run->errors++;
+	    }
+
+	  expected = items[k] + 1;
+	}
+    }
+
+  return NULL;
+}
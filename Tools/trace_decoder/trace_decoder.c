@@ -0,0 +1,233 @@
+/**
+* @file trace_decoder.c
+* @brief Konwersja zrzutu bufora zdarzen (Hydrogreen/trace.h) do formatu Chrome Trace Event JSON (chrome://tracing, ui.perfetto.dev)
+* @details Wejsciem jest zapis z UART po resecie zleconym przez trace_dump() (moze zawierac inne dane przed i po zrzucie, uzywany jest ostatni
+* poprawny zrzut) albo kopia pamieci z debuggera (dump binary value trace.bin trace_buffer). Wszystkie zdarzenia trafiaja
+* na jedna os, przerwania wywlaszczaja sie na jednym rdzeniu, dlatego odcinki _BEGIN/_END sa poprawnie zagniezdzone.
+* Licznik cykli przepelnia sie co 2^32 cykli (67s przy 64MHz), przerwa pomiedzy kolejnymi zdarzeniami nie moze byc dluzsza.
+* Kompilacja:
+*
+*   gcc -std=gnu99 -O2 -Wall -DTRACE_HOST -I../../Hydrogreen -o trace_decoder trace_decoder.c
+*
+*   trace_decoder [-o trace.json] dump.bin
+*
+* @author Piotr Durakiewicz
+* @date 18.10.2026
+* @todo
+* @bug
+* @copyright 2026 HYDROGREEN TEAM
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+#define HEADER_SIZE		16		///< Rozmiar naglowka TRACE_BUFFER w zrzucie [B]
+#define EVENT_SIZE		8		///< Rozmiar TRACE_EVENT w zrzucie [B]
+#define MAX_DEPTH		32		///< Maksymalne zagniezdzenie odcinkow
+
+#define TRACE_NAME(name, id)	[id] = #name,
+
+static const char *names[256] = { TRACE_EVENT_LIST(TRACE_NAME) };
+
+// ******************************************************************************************************************************************************** //
+
+static int usage(const char *program);
+static uint32_t get32(const uint8_t *data);
+static uint16_t get16(const uint8_t *data);
+static const uint8_t *findDump(const uint8_t *data, size_t length);
+static void eventName(uint8_t id, char *name, size_t size, char *phase);
+static void writeJson(const uint8_t *dump, FILE *out);
+
+// ******************************************************************************************************************************************************** //
+
+int main(int argc, char **argv)
+{
+  const char *outPath = NULL;
+  int i;
+
+  for (i = 1; i < argc - 1; i++)
+    {
+      if ( (strcmp(argv[i], "-o") == 0) && (i + 2 < argc) ) outPath = argv[++i];
+      else return usage(argv[0]);
+    }
+
+  if (i != argc - 1) return usage(argv[0]);
+
+  FILE *file = fopen(argv[i], "rb");
+  if (file == NULL)
+    {
+      perror(argv[i]);
+      return 1;
+    }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  uint8_t *data = malloc(length > 0 ? length : 1);
+  if ( (data == NULL) || (fread(data, 1, length, file) != (size_t)length) )
+    {
+      fprintf(stderr, "%s: read error\n", argv[i]);
+      return 1;
+    }
+  fclose(file);
+
+  const uint8_t *dump = findDump(data, length);
+  if (dump == NULL)
+    {
+      fprintf(stderr, "%s: no trace dump found\n", argv[i]);
+      return 1;
+    }
+
+  FILE *out = stdout;
+  if ( (outPath != NULL) && ((out = fopen(outPath, "w")) == NULL) )
+    {
+      perror(outPath);
+      return 1;
+    }
+
+  writeJson(dump, out);
+
+  if (out != stdout) fclose(out);
+  free(data);
+
+  return 0;
+}
+
+static int usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [-o trace.json] dump.bin\n", program);
+  return 2;
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint16_t get16(const uint8_t *data)
+{
+  return data[0] | (data[1] << 8);
+}
+
+/**
+* @fn findDump(const uint8_t *data, size_t length)
+* @brief Wyszukanie ostatniego kompletnego zrzutu (TRACE_MAGIC, TRACE_VERSION, rozmiar bedacy potega 2)
+*/
+static const uint8_t *findDump(const uint8_t *data, size_t length)
+{
+  const uint8_t *found = NULL;
+
+  for (size_t pos = 0; pos + HEADER_SIZE <= length; pos++)
+    {
+      const uint8_t *header = &data[pos];
+      uint16_t size = get16(&header[6]);
+
+      if ( (get32(header) != TRACE_MAGIC) || (get16(&header[4]) != TRACE_VERSION) ) continue;
+      if ( (size == 0) || (size & (size - 1)) || (get32(&header[8]) == 0) ) continue;
+      if (pos + HEADER_SIZE + (size_t)size * EVENT_SIZE > length) continue;
+
+      found = header;
+    }
+
+  return found;
+}
+
+/**
+* @fn eventName(uint8_t id, char *name, size_t size, char *phase)
+* @brief Nazwa zdarzenia bez przedrostka TRACE_ i przyrostka oraz typ zdarzenia Chrome (B, E, C, i)
+*/
+static void eventName(uint8_t id, char *name, size_t size, char *phase)
+{
+  static const struct { const char *suffix; char phase; } suffixes[] = { { "_BEGIN", 'B' }, { "_END", 'E' }, { "_STATE", 'C' } };
+
+  if (names[id] == NULL)
+    {
+      snprintf(name, size, "EVENT_0x%02X", id);
+      *phase = 'i';
+      return;
+    }
+
+  snprintf(name, size, "%s", names[id] + strlen("TRACE_"));
+  *phase = 'i';
+
+  for (size_t k = 0; k < sizeof(suffixes) / sizeof(suffixes[0]); k++)
+    {
+      size_t nameLength = strlen(name);
+      size_t suffixLength = strlen(suffixes[k].suffix);
+
+      if ( (nameLength > suffixLength) && (strcmp(name + nameLength - suffixLength, suffixes[k].suffix) == 0) )
+	{
+	  name[nameLength - suffixLength] = '\0';
+	  *phase = suffixes[k].phase;
+	  return;
+	}
+    }
+}
+
+/**
+* @fn writeJson(const uint8_t *dump, FILE *out)
+* @brief Zapis zdarzen od najstarszego, odcinki przerwane na poczatku bufora (bez _BEGIN) sa pomijane
+*/
+static void writeJson(const uint8_t *dump, FILE *out)
+{
+  uint16_t size = get16(&dump[6]);
+  double cyclesPerUs = get32(&dump[8]) / 1e6;
+  uint32_t head = get32(&dump[12]);
+  uint32_t count = (head < size) ? head : size;
+  const uint8_t *events = &dump[HEADER_SIZE];
+  char stack[MAX_DEPTH][32];
+  uint8_t depth = 0;
+  uint32_t skipped = 0;
+  uint64_t time = 0;
+  uint32_t prevCycles = 0;
+
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"STM32F303K8\"}}");
+
+  for (uint32_t n = head - count; n != head; n++)
+    {
+      const uint8_t *event = &events[(n & (size - 1)) * EVENT_SIZE];
+      uint32_t cycles = get32(event);
+      uint8_t id = event[4];
+      uint8_t exception = event[5];
+      uint16_t arg = get16(&event[6]);
+      char name[32];
+      char phase;
+
+      //Czas liczony od najstarszego zdarzenia, roznica modulo 2^32 usuwa przepelnienia licznika
+      if (n != head - count) time += (uint32_t)(cycles - prevCycles);
+      prevCycles = cycles;
+
+      eventName(id, name, sizeof(name), &phase);
+
+      if (phase == 'B')
+	{
+	  if (depth < MAX_DEPTH) snprintf(stack[depth], sizeof(stack[depth]), "%s", name);
+	  depth++;
+	}
+      else if (phase == 'E')
+	{
+	  if ( (depth == 0) || ((depth <= MAX_DEPTH) && (strcmp(stack[depth - 1], name) != 0)) )
+	    {
+	      skipped++;
+	      continue;
+	    }
+
+	  depth--;
+	}
+
+      fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1", name, phase, time / cyclesPerUs);
+
+      if (phase == 'C') fprintf(out, ",\"args\":{\"value\":%u}}", arg);
+      else if (phase == 'i') fprintf(out, ",\"s\":\"t\",\"args\":{\"arg\":%u,\"exception\":%u}}", arg, exception);
+      else fprintf(out, ",\"args\":{\"exception\":%u}}", exception);
+    }
+
+  fprintf(out, "\n]}\n");
+
+  fprintf(stderr, "events: %lu (%lu overwritten), span: %.3f ms, unmatched ends skipped: %lu\n",
+	  (unsigned long)count, (unsigned long)(head - count), time / cyclesPerUs / 1000.0, (unsigned long)skipped);
+}